@@ -36,6 +36,9 @@
   
 /* Includes ------------------------------------------------------------------*/
 #include "stm32f3_discovery.h"
+#ifdef USE_REPLAY
+#include "replay.h"
+#endif
 
 /** @addtogroup BSP
   * @{
@@ -113,6 +116,7 @@ uint32_t I2cxTimeout = I2Cx_TIMEOUT_MAX;    /*<! Value of Timeout when I2C commu
 static void     I2Cx_Init(void);
 static void     I2Cx_WriteData(uint16_t Addr, uint8_t Reg, uint8_t Value);
 static uint8_t  I2Cx_ReadData(uint16_t Addr, uint8_t Reg);
+static void     I2Cx_ReadBuffer(uint16_t Addr, uint8_t Reg, uint8_t *pBuffer, uint16_t Length);
 static void     I2Cx_Error (void);
 static void     I2Cx_MspInit(I2C_HandleTypeDef *hi2c);
 #endif
@@ -138,6 +142,7 @@ void      COMPASSACCELERO_IO_Init(void);
 void      COMPASSACCELERO_IO_ITConfig(void);
 void      COMPASSACCELERO_IO_Write(uint16_t DeviceAddr, uint8_t RegisterAddr, uint8_t Value);
 uint8_t   COMPASSACCELERO_IO_Read(uint16_t DeviceAddr, uint8_t RegisterAddr);
+void      COMPASSACCELERO_IO_ReadBuffer(uint16_t DeviceAddr, uint8_t RegisterAddr, uint8_t *pBuffer, uint16_t NumByteToRead);
 #endif
 
 /**
@@ -406,6 +411,29 @@ static uint8_t I2Cx_ReadData(uint16_t Addr, uint8_t Reg)
   return value;
 }
 
+/**
+  * @brief  Read consecutive registers of the device in one transfer.
+  * @param  Addr Device address on BUS Bus.
+  * @param  Reg The first register address to read, with the auto-increment
+  *         bit of the device if it has one
+  * @param  pBuffer Buffer receiving the register values
+  * @param  Length Number of registers to read
+  * @retval None
+  */
+static void I2Cx_ReadBuffer(uint16_t Addr, uint8_t Reg, uint8_t *pBuffer, uint16_t Length)
+{
+  HAL_StatusTypeDef status = HAL_OK;
+  
+  status = HAL_I2C_Mem_Read(&I2cHandle, Addr, Reg, I2C_MEMADD_SIZE_8BIT, pBuffer, Length, I2cxTimeout);
+  
+  /* Check the communication status */
+  if(status != HAL_OK)
+  {
+    /* Execute user timeout callback */
+    I2Cx_Error();
+  }
+}
+
 /**
   * @brief I2C3 error treatment function
   * @retval None
@@ -568,6 +596,14 @@ void GYRO_IO_Init(void)
   */
 void GYRO_IO_Write(uint8_t* pBuffer, uint8_t WriteAddr, uint16_t NumByteToWrite)
 {
+#ifdef USE_REPLAY
+  /* Recorded frames in place of the sensor, see replay.c */
+  if(REPLAY_IsActive())
+  {
+    REPLAY_GyroWrite(pBuffer, WriteAddr, NumByteToWrite);
+    return;
+  }
+#endif
   /* Configure the MS bit: 
        - When 0, the address will remain unchanged in multiple read/write commands.
        - When 1, the address will be auto incremented in multiple read/write commands.
@@ -603,6 +639,14 @@ void GYRO_IO_Write(uint8_t* pBuffer, uint8_t WriteAddr, uint16_t NumByteToWrite)
   */
 void GYRO_IO_Read(uint8_t* pBuffer, uint8_t ReadAddr, uint16_t NumByteToRead)
 {  
+#ifdef USE_REPLAY
+  /* Recorded frames in place of the sensor, see replay.c */
+  if(REPLAY_IsActive())
+  {
+    REPLAY_GyroRead(pBuffer, ReadAddr, NumByteToRead);
+    return;
+  }
+#endif
   if(NumByteToRead > 0x01)
   {
     ReadAddr |= (uint8_t)(READWRITE_CMD | MULTIPLEBYTE_CMD);
@@ -701,6 +745,14 @@ void COMPASSACCELERO_IO_ITConfig(void)
  */
 void COMPASSACCELERO_IO_Write(uint16_t DeviceAddr, uint8_t RegisterAddr, uint8_t Value)
 {
+#ifdef USE_REPLAY
+  /* Recorded frames in place of the sensor, see replay.c */
+  if(REPLAY_IsActive())
+  {
+    REPLAY_AccMagWrite(DeviceAddr, RegisterAddr, Value);
+    return;
+  }
+#endif
   /* call I2Cx Read data bus function */
   I2Cx_WriteData(DeviceAddr, RegisterAddr, Value);
 }
@@ -713,9 +765,42 @@ void COMPASSACCELERO_IO_Write(uint16_t DeviceAddr, uint8_t RegisterAddr, uint8_t
   */ 
 uint8_t COMPASSACCELERO_IO_Read(uint16_t DeviceAddr, uint8_t RegisterAddr)
 {
+#ifdef USE_REPLAY
+  /* Recorded frames in place of the sensor, see replay.c */
+  if(REPLAY_IsActive())
+  {
+    return REPLAY_AccMagRead(DeviceAddr, RegisterAddr);
+  }
+#endif
   /* call I2Cx Read data bus function */   
   return I2Cx_ReadData(DeviceAddr, RegisterAddr);
 }
+
+/**
+  * @brief  Reads consecutive registers of the COMPASS / ACCELEROMETER in one
+  *         I2C transfer, instead of one transfer per register.
+  * @param  DeviceAddr specifies the slave address to be programmed(ACC_I2C_ADDRESS or MAG_I2C_ADDRESS).
+  * @param  RegisterAddr first register, the accelerometer only increments the
+  *         address with its MSB set
+  * @param  pBuffer buffer receiving the register values
+  * @param  NumByteToRead number of registers to read
+  * @retval None
+  */
+void COMPASSACCELERO_IO_ReadBuffer(uint16_t DeviceAddr, uint8_t RegisterAddr, uint8_t *pBuffer, uint16_t NumByteToRead)
+{
+#ifdef USE_REPLAY
+  /* Recorded frames in place of the sensor, see replay.c */
+  if(REPLAY_IsActive())
+  {
+    while(NumByteToRead-- > 0)
+    {
+      *pBuffer++ = REPLAY_AccMagRead(DeviceAddr, RegisterAddr++);
+    }
+    return;
+  }
+#endif
+  I2Cx_ReadBuffer(DeviceAddr, RegisterAddr, pBuffer, NumByteToRead);
+}
 #endif /* HAL_I2C_MODULE_ENABLED */
 
 
@@ -0,0 +1,51 @@
+/**
+  ******************************************************************************
+  * @file    host/Inc/stm32f3xx_hal.h
+  * @brief   Stand-in for the HAL header in the host build (make host).
+  *          Provides the types and the few services of the HAL and CMSIS
+  *          used by the portable modules, see host/Src/bsp_host.c.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __STM32F3xx_HAL_H
+#define __STM32F3xx_HAL_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stddef.h>
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum
+{
+  HAL_OK       = 0x00U,
+  HAL_ERROR    = 0x01U,
+  HAL_BUSY     = 0x02U,
+  HAL_TIMEOUT  = 0x03U
+} HAL_StatusTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+#define __IO                  volatile
+#define __STATIC_INLINE       static inline
+
+/* Erase page of the STM32F303xC, the unit of the FLOG image */
+#define FLASH_PAGE_SIZE       0x800U
+
+/* Exported macro ------------------------------------------------------------*/
+/* Count leading zeros, 32 for 0 as the CLZ instruction */
+static inline uint32_t __CLZ(uint32_t Value)
+{
+  return (Value != 0U) ? (uint32_t)__builtin_clz(Value) : 32U;
+}
+
+/* Swap the bytes of each halfword, as the REV16 instruction */
+static inline uint32_t __REV16(uint32_t Value)
+{
+  return ((Value >> 8) & 0x00FF00FFU) | ((Value << 8) & 0xFF00FF00U);
+}
+
+/* Exported functions ------------------------------------------------------- */
+uint32_t HAL_GetTick(void);
+void     HAL_Delay(uint32_t Delay);
+
+#endif /* __STM32F3xx_HAL_H */
@@ -0,0 +1,176 @@
+/**
+  ******************************************************************************
+  * @file    host/Src/bsp_host.c
+  * @brief   Board services of the host build (make host).
+  *
+  *          The sensor bus functions of default/stm32f3_discovery.c are
+  *          served by the replay only, the CRC unit is computed in software
+  *          with the same result as crc32.c, and the time base is the
+  *          monotonic clock of the host.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <time.h>
+#include "stm32f3xx_hal.h"
+#include "replay.h"
+#include "crc32.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/* Reflected CRC-32 polynomial, as the CRC unit with input and output inversion */
+#define HOST_CRC32_POLY       0xEDB88320U
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Private function prototypes -----------------------------------------------*/
+void    GYRO_IO_Init(void);
+void    GYRO_IO_Write(uint8_t *pBuffer, uint8_t WriteAddr, uint16_t NumByteToWrite);
+void    GYRO_IO_Read(uint8_t *pBuffer, uint8_t ReadAddr, uint16_t NumByteToRead);
+void    COMPASSACCELERO_IO_Init(void);
+void    COMPASSACCELERO_IO_ITConfig(void);
+void    COMPASSACCELERO_IO_Write(uint16_t DeviceAddr, uint8_t RegisterAddr, uint8_t Value);
+uint8_t COMPASSACCELERO_IO_Read(uint16_t DeviceAddr, uint8_t RegisterAddr);
+void    COMPASSACCELERO_IO_ReadBuffer(uint16_t DeviceAddr, uint8_t RegisterAddr, uint8_t *pBuffer, uint16_t NumByteToRead);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Gyroscope bus initialization, nothing to do.
+  * @param  None
+  * @retval None
+  */
+void GYRO_IO_Init(void)
+{
+}
+
+/**
+  * @brief  Gyroscope register write, to the replay.
+  * @param  pBuffer: data to write
+  * @param  WriteAddr: first register
+  * @param  NumByteToWrite: number of registers
+  * @retval None
+  */
+void GYRO_IO_Write(uint8_t *pBuffer, uint8_t WriteAddr, uint16_t NumByteToWrite)
+{
+  REPLAY_GyroWrite(pBuffer, WriteAddr, NumByteToWrite);
+}
+
+/**
+  * @brief  Gyroscope register read, from the replay.
+  * @param  pBuffer: data read
+  * @param  ReadAddr: first register
+  * @param  NumByteToRead: number of registers
+  * @retval None
+  */
+void GYRO_IO_Read(uint8_t *pBuffer, uint8_t ReadAddr, uint16_t NumByteToRead)
+{
+  REPLAY_GyroRead(pBuffer, ReadAddr, NumByteToRead);
+}
+
+/**
+  * @brief  Accelerometer and magnetometer bus initialization, nothing to do.
+  * @param  None
+  * @retval None
+  */
+void COMPASSACCELERO_IO_Init(void)
+{
+}
+
+/**
+  * @brief  Accelerometer interrupt lines, not available.
+  * @param  None
+  * @retval None
+  */
+void COMPASSACCELERO_IO_ITConfig(void)
+{
+}
+
+/**
+  * @brief  Accelerometer or magnetometer register write, to the replay.
+  * @param  DeviceAddr: ACC_I2C_ADDRESS or MAG_I2C_ADDRESS
+  * @param  RegisterAddr: register
+  * @param  Value: value to write
+  * @retval None
+  */
+void COMPASSACCELERO_IO_Write(uint16_t DeviceAddr, uint8_t RegisterAddr, uint8_t Value)
+{
+  REPLAY_AccMagWrite(DeviceAddr, RegisterAddr, Value);
+}
+
+/**
+  * @brief  Accelerometer or magnetometer register read, from the replay.
+  * @param  DeviceAddr: ACC_I2C_ADDRESS or MAG_I2C_ADDRESS
+  * @param  RegisterAddr: register
+  * @retval Register value
+  */
+uint8_t COMPASSACCELERO_IO_Read(uint16_t DeviceAddr, uint8_t RegisterAddr)
+{
+  return REPLAY_AccMagRead(DeviceAddr, RegisterAddr);
+}
+
+/**
+  * @brief  Accelerometer or magnetometer burst read, from the replay.
+  * @param  DeviceAddr: ACC_I2C_ADDRESS or MAG_I2C_ADDRESS
+  * @param  RegisterAddr: first register
+  * @param  pBuffer: data read
+  * @param  NumByteToRead: number of registers
+  * @retval None
+  */
+void COMPASSACCELERO_IO_ReadBuffer(uint16_t DeviceAddr, uint8_t RegisterAddr, uint8_t *pBuffer, uint16_t NumByteToRead)
+{
+  while(NumByteToRead-- > 0U)
+  {
+    *pBuffer++ = REPLAY_AccMagRead(DeviceAddr, RegisterAddr++);
+  }
+}
+
+/**
+  * @brief  CRC-32 of a buffer, bitwise, same value as the CRC unit in crc32.c.
+  * @param  pData: data
+  * @param  Length: size in bytes
+  * @retval CRC-32 (zlib)
+  */
+uint32_t CRC32_Calc(const void *pData, uint32_t Length)
+{
+  const uint8_t *p = (const uint8_t *)pData;
+  uint32_t crc = 0xFFFFFFFFU;
+  uint32_t bit;
+
+  while(Length-- > 0U)
+  {
+    crc ^= *p++;
+    for(bit = 0; bit < 8U; bit++)
+    {
+      crc = (crc >> 1) ^ (HOST_CRC32_POLY & (0U - (crc & 1U)));
+    }
+  }
+  return crc ^ 0xFFFFFFFFU;
+}
+
+/**
+  * @brief  Milliseconds of the host monotonic clock.
+  * @param  None
+  * @retval Time in ms
+  */
+uint32_t HAL_GetTick(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint32_t)((now.tv_sec * 1000) + (now.tv_nsec / 1000000));
+}
+
+/**
+  * @brief  Wait for a number of milliseconds.
+  * @param  Delay: time in ms
+  * @retval None
+  */
+void HAL_Delay(uint32_t Delay)
+{
+  struct timespec wait;
+
+  wait.tv_sec = Delay / 1000U;
+  wait.tv_nsec = (long)(Delay % 1000U) * 1000000L;
+  nanosleep(&wait, NULL);
+}
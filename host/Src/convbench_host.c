@@ -0,0 +1,77 @@
+/**
+  ******************************************************************************
+  * @file    host/Src/convbench_host.c
+  * @brief   Host run of the conversion benchmark of convbench.c.
+  *
+  *          make host
+  *          build/host/convbench
+  *
+  *          Times in nanoseconds of the host monotonic clock. The host
+  *          compiler and core decide the ratios, the target figures come
+  *          from the CONV demo. Mismatches must be 0 on both.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <time.h>
+#include "stm32f3xx_hal.h"
+#include "convbench.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t Host_Nanos(void);
+static void     Host_Print(const char *pName, uint32_t Loop, uint32_t Kernel);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Run the benchmark and print loop and kernel times.
+  * @param  None
+  * @retval 0 if the kernels match the loops, 1 otherwise
+  */
+int main(void)
+{
+  const CONVBENCH_ResultTypeDef *result = CONVBENCH_Run(Host_Nanos);
+
+  printf("%u samples of 3 axes, ns\n", (unsigned)CONVBENCH_SAMPLES);
+  Host_Print("le", result->LoopLe, result->KernelLe);
+  Host_Print("be", result->LoopBe, result->KernelBe);
+  Host_Print("scale", result->LoopScale, result->KernelScale);
+  printf("codec     %u samples  encode %8lu  %.2f ns/sample  %lu of %u bytes\n",
+         (unsigned)CONVBENCH_CODEC_SAMPLES, (unsigned long)result->Encode,
+         (double)result->Encode / CONVBENCH_CODEC_SAMPLES, (unsigned long)result->EncodedSize,
+         (unsigned)(CONVBENCH_CODEC_FRAMES * CONVBENCH_CODEC_CHANNELS * 2U));
+  printf("mismatch  %lu\n", (unsigned long)result->Mismatches);
+
+  return (result->Mismatches == 0U) ? 0 : 1;
+}
+
+/**
+  * @brief  Nanoseconds of the host monotonic clock.
+  * @param  None
+  * @retval Time in ns, modulo 2^32
+  */
+static uint32_t Host_Nanos(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint32_t)((now.tv_sec * 1000000000) + now.tv_nsec);
+}
+
+/**
+  * @brief  One line of results.
+  * @param  pName: conversion
+  * @param  Loop: time of the byte loop
+  * @param  Kernel: time of the kernel
+  * @retval None
+  */
+static void Host_Print(const char *pName, uint32_t Loop, uint32_t Kernel)
+{
+  printf("%-9s loop %8lu  kernel %8lu  x%.2f\n", pName, (unsigned long)Loop, (unsigned long)Kernel,
+         (Kernel != 0U) ? ((double)Loop / Kernel) : 0.0);
+}
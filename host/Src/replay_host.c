@@ -0,0 +1,256 @@
+/**
+  ******************************************************************************
+  * @file    host/Src/replay_host.c
+  * @brief   Host build of the sensor pipeline, fed by a recorded log.
+  *
+  *          make host
+  *          build/host/replay build/debug/flashlog.bin [session] [speed]
+  *
+  *          The FLOG image of "make logdump" is replayed through the L3GD20
+  *          and LSM303DLHC drivers of the firmware, their output feeds the
+  *          IMUC_Encode() block codec and both AHRS filters. Every stage is
+  *          summarized by a digest to compare runs bit for bit:
+  *            - raw, codec, mahony: integer, equal on every host and on
+  *              the target
+  *            - madgwick: float, equal between runs of the same binary.
+  *              The target contracts to fused multiply-add, the host build
+  *              does not (-ffp-contract=off)
+  *          session: number in the log, 0 (default) for the last one.
+  *          speed: "fast" (default) or a multiple of the recorded rate.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "stm32f3xx_hal.h"
+#include "replay.h"
+#include "flashlog.h"
+#include "imucodec.h"
+#include "ahrs.h"
+#include "mems_drv.h"
+#include "mems_conv.h"
+#include <../Components/l3gd20/l3gd20.h>
+#include <../Components/lsm303dlhc/lsm303dlhc.h>
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+#define HOST_CHANNELS         9U
+#define HOST_PI               3.14159265358979
+#define HOST_DEG_TO_RAD       (HOST_PI / 180.0)
+#define HOST_GYRO_SHIFT       10U
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t Host_Micros(void);
+static uint8_t *Host_Load(const char *pPath, uint32_t *pSize);
+static void     Host_SensorsInit(void);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Replay a session and print the digests of each stage.
+  * @param  argc: number of arguments
+  * @param  argv: log image, session, speed
+  * @retval 0 on success, 1 if the session cannot be replayed, 2 if the
+  *         codec does not decode its own output
+  */
+int main(int argc, char *argv[])
+{
+  static int16_t frames[FLOG_BLOCK_FRAMES * HOST_CHANNELS];
+  static int16_t decoded[FLOG_BLOCK_FRAMES * HOST_CHANNELS];
+  static uint8_t packed[FLOG_MAX_PAYLOAD + 64U];
+  AHRS_MadgwickTypeDef madgwick;
+  AHRS_MahonyQTypeDef mahony;
+  const REPLAY_StatsTypeDef *stats;
+  int16_t *frame;
+  float gyroSens, accSens, gyro[3], acc[3], mag[3];
+  int32_t gyroQ[3], accQ[3], magQ[3];
+  int16_t gyroGain;
+  uint32_t rawHash = REPLAY_HASH_INIT, codecHash = REPLAY_HASH_INIT;
+  uint32_t mahonyHash = REPLAY_HASH_INIT, madgwickHash = REPLAY_HASH_INIT;
+  uint32_t size, speed = REPLAY_SPEED_FAST, count = 0, length, i;
+  uint32_t start, elapsed;
+  uint16_t session = REPLAY_LAST_SESSION;
+  uint32_t q[4];
+  uint8_t *image;
+  int lossless = 1;
+
+  if((argc < 2) || (argc > 4))
+  {
+    fprintf(stderr, "usage: %s flashlog.bin [session] [fast|speed]\n", argv[0]);
+    return 1;
+  }
+  if(argc > 2)
+  {
+    session = (uint16_t)strtoul(argv[2], NULL, 0);
+  }
+  if((argc > 3) && (strcmp(argv[3], "fast") != 0))
+  {
+    speed = (uint32_t)strtoul(argv[3], NULL, 0);
+  }
+
+  image = Host_Load(argv[1], &size);
+  if(image == NULL)
+  {
+    return 1;
+  }
+  REPLAY_Init(image, size);
+  if(REPLAY_Start(session, speed, Host_Micros) != HAL_OK)
+  {
+    fprintf(stderr, "%s: no frames in session %u\n", argv[1], (unsigned)session);
+    return 1;
+  }
+
+  /* Same settings as SENSORS_Init() in sensors.cpp */
+  Host_SensorsInit();
+  gyroSens = L3GD20_GetSensitivity() * 0.001f * (float)HOST_DEG_TO_RAD;
+  accSens = LSM303DLHC_AccGetSensitivity() * 0.001f;
+  gyroGain = MEMSCONV_GAIN((double)L3GD20_GetSensitivity() * 0.001 * HOST_DEG_TO_RAD * 65536.0, HOST_GYRO_SHIFT);
+
+  AHRS_MadgwickInit(&madgwick, (float)REPLAY_GetRate(), AHRS_MADGWICK_BETA);
+  AHRS_MahonyQInit(&mahony, REPLAY_GetRate(), AHRS_MAHONY_TWOKP_Q16, AHRS_MAHONY_TWOKI_Q16);
+
+  start = Host_Micros();
+  while(!REPLAY_IsDone())
+  {
+    /* Real-time replay: wait for the recorded rate */
+    while((L3GD20_GetDataStatus() & L3GD20_STATUS_ZYXDA) == 0)
+    {
+    }
+
+    frame = &frames[(count % FLOG_BLOCK_FRAMES) * HOST_CHANNELS];
+    L3GD20_ReadXYZRaw(&frame[0]);
+    LSM303DLHC_AccReadXYZRaw(&frame[3]);
+    LSM303DLHC_MagReadXYZ(&frame[6]);
+    rawHash = REPLAY_Hash(rawHash, frame, HOST_CHANNELS * sizeof(int16_t));
+    count++;
+
+    /* Lossless codec: each block must decode to its input */
+    if((count % FLOG_BLOCK_FRAMES) == 0U)
+    {
+      length = IMUC_Encode(frames, FLOG_BLOCK_FRAMES, HOST_CHANNELS, packed);
+      codecHash = REPLAY_Hash(codecHash, packed, length);
+      if((IMUC_Decode(packed, length, FLOG_BLOCK_FRAMES, HOST_CHANNELS, decoded) != length) ||
+         (memcmp(decoded, frames, sizeof(frames)) != 0))
+      {
+        lossless = 0;
+      }
+    }
+
+    /* Fixed point: rad/s in Q16, field Z scaled to the X/Y gain */
+    MEMSCONV_ScaleQ(&frame[0], gyroGain, HOST_GYRO_SHIFT, gyroQ);
+    for(i = 0; i < 3U; i++)
+    {
+      accQ[i] = frame[3U + i];
+      magQ[i] = frame[6U + i];
+    }
+    magQ[2] = (magQ[2] * LSM303DLHC_MAG_LSB_PER_GAUSS_XY_1_3) / LSM303DLHC_MAG_LSB_PER_GAUSS_Z_1_3;
+    AHRS_MahonyQUpdate(&mahony, gyroQ, accQ, magQ);
+    mahonyHash = REPLAY_Hash(mahonyHash, mahony.Q, sizeof(mahony.Q));
+
+    for(i = 0; i < 3U; i++)
+    {
+      gyro[i] = (float)frame[i] * gyroSens;
+      acc[i] = (float)frame[3U + i] * accSens;
+    }
+    /* By the reciprocal of the gains, as SENSORS_MagRead() */
+    mag[0] = (float)frame[6] * (1.0f / LSM303DLHC_MAG_LSB_PER_GAUSS_XY_1_3);
+    mag[1] = (float)frame[7] * (1.0f / LSM303DLHC_MAG_LSB_PER_GAUSS_XY_1_3);
+    mag[2] = (float)frame[8] * (1.0f / LSM303DLHC_MAG_LSB_PER_GAUSS_Z_1_3);
+    AHRS_MadgwickUpdate(&madgwick, gyro, acc, mag);
+    madgwickHash = REPLAY_Hash(madgwickHash, madgwick.Q, sizeof(madgwick.Q));
+  }
+  elapsed = Host_Micros() - start;
+
+  stats = REPLAY_GetStats();
+  memcpy(q, madgwick.Q, sizeof(q));
+  printf("frames    %lu at %u Hz, %lu skipped, %lu blocks, %lu corrupt\n",
+         (unsigned long)stats->Frames, (unsigned)REPLAY_GetRate(), (unsigned long)stats->Skipped,
+         (unsigned long)stats->Blocks, (unsigned long)stats->BadBlocks);
+  printf("raw       %08lx\n", (unsigned long)rawHash);
+  printf("codec     %08lx%s\n", (unsigned long)codecHash, lossless ? "" : "  DECODE MISMATCH");
+  printf("mahony    %08lx  q %08lx %08lx %08lx %08lx\n", (unsigned long)mahonyHash,
+         (unsigned long)(uint32_t)mahony.Q[0], (unsigned long)(uint32_t)mahony.Q[1],
+         (unsigned long)(uint32_t)mahony.Q[2], (unsigned long)(uint32_t)mahony.Q[3]);
+  printf("madgwick  %08lx  q %08lx %08lx %08lx %08lx\n", (unsigned long)madgwickHash,
+         (unsigned long)q[0], (unsigned long)q[1], (unsigned long)q[2], (unsigned long)q[3]);
+  printf("time      %.3f s, %.0f frames/s\n", elapsed * 1e-6, (elapsed != 0U) ? (count * 1e6 / elapsed) : 0.0);
+
+  free(image);
+  return lossless ? 0 : 2;
+}
+
+/**
+  * @brief  Microseconds of the host monotonic clock, paces the replay.
+  * @param  None
+  * @retval Time in us, modulo 2^32
+  */
+static uint32_t Host_Micros(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint32_t)((now.tv_sec * 1000000) + (now.tv_nsec / 1000));
+}
+
+/**
+  * @brief  Read a log image, padded with erased bytes to whole pages.
+  * @param  pPath: file of "make logdump"
+  * @param  pSize: image size in bytes
+  * @retval Image, NULL on error
+  */
+static uint8_t *Host_Load(const char *pPath, uint32_t *pSize)
+{
+  FILE *file = fopen(pPath, "rb");
+  uint8_t *image;
+  long length;
+
+  if(file == NULL)
+  {
+    perror(pPath);
+    return NULL;
+  }
+  fseek(file, 0, SEEK_END);
+  length = ftell(file);
+  rewind(file);
+
+  *pSize = ((uint32_t)length + FLASH_PAGE_SIZE - 1U) & ~(FLASH_PAGE_SIZE - 1U);
+  image = malloc(*pSize);
+  if(image != NULL)
+  {
+    memset(image, 0xFF, *pSize);
+    if(fread(image, 1, (size_t)length, file) != (size_t)length)
+    {
+      perror(pPath);
+      free(image);
+      image = NULL;
+    }
+  }
+  fclose(file);
+  return image;
+}
+
+/**
+  * @brief  Sensor settings of the recording demos.
+  * @param  None
+  * @retval None
+  */
+static void Host_SensorsInit(void)
+{
+  uint16_t ctrl;
+
+  ctrl = (uint16_t)(L3GD20_MODE_ACTIVE | L3GD20_OUTPUT_DATARATE_4 | L3GD20_AXES_ENABLE | L3GD20_BANDWIDTH_4);
+  ctrl |= (uint16_t)((L3GD20_BlockDataUpdate_Continous | L3GD20_BLE_LSB | L3GD20_FULLSCALE_500) << 8);
+  L3GD20_Init(ctrl);
+
+  ctrl = (uint16_t)(LSM303DLHC_NORMAL_MODE | LSM303DLHC_ODR_50_HZ | LSM303DLHC_AXES_ENABLE);
+  ctrl |= (uint16_t)((LSM303DLHC_BlockUpdate_Continous | LSM303DLHC_BLE_LSB | LSM303DLHC_FULLSCALE_2G |
+                      LSM303DLHC_HR_ENABLE) << 8);
+  LSM303DLHC_AccInit(ctrl);
+
+  LSM303DLHC_MagInit(LSM303DLHC_MAG_ODR_220_HZ, LSM303DLHC_MAG_FS_1_3_GA, LSM303DLHC_MAG_CONTINUOUS);
+}
@@ -12,17 +12,14 @@ void GPIO_Configuration(void)
 {
   GPIO_InitTypeDef GPIO_InitStructure;
  
-  /* Connect PA9 to USART1_Tx */
-  GPIO_PinAFConfig(GPIOA, GPIO_PinSource9, GPIO_AF_7);
-  //GPIO_PinAFConfig(GPIOC, GPIO_PinSource4, GPIO_AF_7);
+  /* Connect PC4 to USART1_Tx, the AF of the port initialized below */
+  GPIO_PinAFConfig(GPIOC, GPIO_PinSource4, GPIO_AF_7);
  
-  /* Connect PA10 to USART1_Rx */
-  GPIO_PinAFConfig(GPIOA, GPIO_PinSource10, GPIO_AF_7);
-  //GPIO_PinAFConfig(GPIOC, GPIO_PinSource5, GPIO_AF_7);
+  /* Connect PC5 to USART1_Rx */
+  GPIO_PinAFConfig(GPIOC, GPIO_PinSource5, GPIO_AF_7);
  
   /* Configure USART Tx as alternate function push-pull */
-  GPIO_InitStructure.GPIO_Pin = GPIO_Pin_9;
-  //GPIO_InitStructure.GPIO_Pin = GPIO_Pin_4;
+  GPIO_InitStructure.GPIO_Pin = GPIO_Pin_4;
   GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF;
   GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
   GPIO_InitStructure.GPIO_OType = GPIO_OType_PP;
@@ -32,8 +29,7 @@ void GPIO_Configuration(void)
   GPIO_Init(GPIOC, &GPIO_InitStructure);
  
   /* Configure USART Rx as alternate function push-pull */
-  GPIO_InitStructure.GPIO_Pin = GPIO_Pin_10;
-  //GPIO_InitStructure.GPIO_Pin = GPIO_Pin_5;
+  GPIO_InitStructure.GPIO_Pin = GPIO_Pin_5;
 
   //GPIO_Init(GPIOA, &GPIO_InitStructure);
   GPIO_Init(GPIOC, &GPIO_InitStructure);
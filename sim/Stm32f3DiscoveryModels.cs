@@ -0,0 +1,713 @@
+//
+// Renode models for the STM32F3-Discovery simulation benchmark.
+//
+// Loaded by sim/stm32f3_discovery.resc before the platform description:
+//   - STM32F3_RCC: clock control, ready flags follow their enable bits
+//   - STM32F3_FlashController: FPEC unlock, page and mass erase
+//   - STM32F3_CRC: CRC-32 unit with input and output bit reversal
+//   - L3GD20: gyroscope on SPI1, chip select on PE3
+//   - LSM303DLHC_Accelerometer, LSM303DLHC_Magnetometer: on I2C1
+//
+// The sensors replay recorded frames, in the CSV format written by
+// tools/flashlog_dump.py: session, t, then gyro X Y Z, accelerometer X Y Z
+// and magnetometer X Y Z. Reading the output registers of a sensor moves
+// it to its next frame, so the data always looks ready and the firmware
+// runs as fast as the simulated core allows. Without a recording the
+// sensors report a device lying flat and still.
+//
+using System;
+using System.Collections.Generic;
+using System.Globalization;
+using System.IO;
+using System.Linq;
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Logging;
+using Antmicro.Renode.Peripherals.Bus;
+using Antmicro.Renode.Peripherals.I2C;
+using Antmicro.Renode.Peripherals.SPI;
+
+namespace Antmicro.Renode.Peripherals.Sensors
+{
+    // Frames of a recording, shared by the sensors reading the same file
+    public static class RecordedFrames
+    {
+        public static short[][] Load(string path)
+        {
+            lock(cache)
+            {
+                if(!cache.TryGetValue(path, out var frames))
+                {
+                    frames = File.ReadLines(path)
+                        .Skip(1)
+                        .Select(line => line.Split(','))
+                        .Where(fields => fields.Length >= 2 + Channels)
+                        .Select(fields => fields.Skip(2).Take(Channels)
+                            .Select(f => short.Parse(f, CultureInfo.InvariantCulture)).ToArray())
+                        .ToArray();
+                    if(frames.Length == 0)
+                    {
+                        throw new ArgumentException($"No frames of {Channels} channels in {path}");
+                    }
+                    cache[path] = frames;
+                }
+                return frames;
+            }
+        }
+
+        public const int Channels = 9;
+
+        private static readonly Dictionary<string, short[][]> cache = new Dictionary<string, short[][]>();
+    }
+
+    // Register file of an ST MEMS sensor: the output registers hold the
+    // current frame, one axis per 16-bit pair
+    public abstract class MemsSensor : IPeripheral
+    {
+        protected MemsSensor(int firstChannel, short[] still)
+        {
+            this.firstChannel = firstChannel;
+            this.still = still;
+            Reset();
+        }
+
+        public virtual void Reset()
+        {
+            Array.Clear(registers, 0, registers.Length);
+            frame = 0;
+            SamplesRead = 0;
+            current = still;
+        }
+
+        public void LoadSamples(string path)
+        {
+            frames = RecordedFrames.Load(path);
+            frame = 0;
+            this.Log(LogLevel.Info, "{0} frames loaded from {1}", frames.Length, path);
+        }
+
+        public ulong SamplesRead { get; private set; }
+
+        protected void NextSample()
+        {
+            if(frames != null)
+            {
+                current = frames[frame].Skip(firstChannel).Take(3).ToArray();
+                frame = (frame + 1) % frames.Length;
+            }
+            SamplesRead++;
+        }
+
+        protected byte Axis(int axis, bool high, bool bigEndian)
+        {
+            var value = (ushort)current[axis];
+            return (byte)((high != bigEndian) ? (value >> 8) : value);
+        }
+
+        protected readonly byte[] registers = new byte[0x80];
+
+        private short[][] frames;
+        private int frame;
+        private short[] current;
+        private readonly int firstChannel;
+        private readonly short[] still;
+    }
+
+    public class L3GD20 : MemsSensor, ISPIPeripheral, IGPIOReceiver
+    {
+        public L3GD20() : base(0, new short[] { 0, 0, 0 })
+        {
+        }
+
+        public override void Reset()
+        {
+            base.Reset();
+            registers[WhoAmI] = 0xD4;
+            registers[Ctrl1] = 0x07;
+            FinishTransmission();
+        }
+
+        public byte Transmit(byte data)
+        {
+            if(!selected)
+            {
+                return 0;
+            }
+            if(address < 0)
+            {
+                read = (data & 0x80) != 0;
+                increment = (data & 0x40) != 0;
+                address = data & 0x3F;
+                return 0;
+            }
+
+            byte result = 0;
+            if(read)
+            {
+                result = ReadRegister(address);
+            }
+            else
+            {
+                registers[address] = data;
+            }
+            if(increment)
+            {
+                address = (address + 1) & 0x3F;
+            }
+            return result;
+        }
+
+        public void FinishTransmission()
+        {
+            address = -1;
+        }
+
+        // Chip select, active low
+        public void OnGPIO(int number, bool value)
+        {
+            selected = !value;
+            FinishTransmission();
+        }
+
+        private byte ReadRegister(int register)
+        {
+            var bigEndian = (registers[Ctrl4] & 0x40) != 0;
+            switch(register)
+            {
+            case Status:
+                return 0x0F;
+            case FifoSource:
+                // Stream and FIFO modes: the watermark is always reached
+                return ((registers[Ctrl5] & 0x40) != 0) ? (byte)(0x80 | (registers[FifoControl] & 0x1F)) : (byte)0x20;
+            case OutXL:
+                NextSample();
+                return Axis(0, false, bigEndian);
+            case OutXL + 1: return Axis(0, true, bigEndian);
+            case OutXL + 2: return Axis(1, false, bigEndian);
+            case OutXL + 3: return Axis(1, true, bigEndian);
+            case OutXL + 4: return Axis(2, false, bigEndian);
+            case OutXL + 5: return Axis(2, true, bigEndian);
+            default:
+                return registers[register];
+            }
+        }
+
+        private bool selected;
+        private int address;
+        private bool read;
+        private bool increment;
+
+        private const int WhoAmI = 0x0F;
+        private const int Ctrl1 = 0x20;
+        private const int Ctrl4 = 0x23;
+        private const int Ctrl5 = 0x24;
+        private const int Status = 0x27;
+        private const int OutXL = 0x28;
+        private const int FifoControl = 0x2E;
+        private const int FifoSource = 0x2F;
+    }
+
+    // I2C register access: the first byte written is the register address,
+    // bit 7 set for auto-increment
+    public abstract class MemsI2CSensor : MemsSensor, II2CPeripheral
+    {
+        protected MemsI2CSensor(int firstChannel, short[] still) : base(firstChannel, still)
+        {
+        }
+
+        public void Write(byte[] data)
+        {
+            if(data.Length == 0)
+            {
+                return;
+            }
+            address = data[0] & 0x7F;
+            increment = AutoIncrement(data[0]);
+            foreach(var b in data.Skip(1))
+            {
+                registers[address] = b;
+                Advance();
+            }
+        }
+
+        public byte[] Read(int count = 1)
+        {
+            var result = new byte[count];
+            for(var i = 0; i < count; i++)
+            {
+                result[i] = ReadRegister(address);
+                Advance();
+            }
+            return result;
+        }
+
+        public void FinishTransmission()
+        {
+        }
+
+        protected abstract bool AutoIncrement(byte subAddress);
+        protected abstract byte ReadRegister(int register);
+
+        private void Advance()
+        {
+            if(increment)
+            {
+                address = (address + 1) & 0x7F;
+            }
+        }
+
+        private int address;
+        private bool increment;
+    }
+
+    public class LSM303DLHC_Accelerometer : MemsI2CSensor
+    {
+        // 1 g on Z, 1 mg/LSB left-justified at +/-2 g
+        public LSM303DLHC_Accelerometer() : base(3, new short[] { 0, 0, 16000 })
+        {
+        }
+
+        public override void Reset()
+        {
+            base.Reset();
+            registers[WhoAmI] = 0x33;
+            registers[Ctrl1] = 0x07;
+        }
+
+        protected override bool AutoIncrement(byte subAddress)
+        {
+            return (subAddress & 0x80) != 0;
+        }
+
+        protected override byte ReadRegister(int register)
+        {
+            var bigEndian = (registers[Ctrl4] & 0x40) != 0;
+            switch(register)
+            {
+            case Status:
+                return 0x0F;
+            case OutXL:
+                NextSample();
+                return Axis(0, false, bigEndian);
+            case OutXL + 1: return Axis(0, true, bigEndian);
+            case OutXL + 2: return Axis(1, false, bigEndian);
+            case OutXL + 3: return Axis(1, true, bigEndian);
+            case OutXL + 4: return Axis(2, false, bigEndian);
+            case OutXL + 5: return Axis(2, true, bigEndian);
+            default:
+                return registers[register];
+            }
+        }
+
+        private const int WhoAmI = 0x0F;
+        private const int Ctrl1 = 0x20;
+        private const int Ctrl4 = 0x23;
+        private const int Status = 0x27;
+        private const int OutXL = 0x28;
+    }
+
+    public class LSM303DLHC_Magnetometer : MemsI2CSensor
+    {
+        public LSM303DLHC_Magnetometer() : base(6, new short[] { 300, 0, -400 })
+        {
+        }
+
+        public override void Reset()
+        {
+            base.Reset();
+            registers[IdentA] = 0x48;
+            registers[IdentB] = 0x34;
+            registers[IdentC] = 0x33;
+            registers[Mode] = 0x03;
+        }
+
+        // The magnetometer always increments, and wraps after the
+        // identification registers
+        protected override bool AutoIncrement(byte subAddress)
+        {
+            return true;
+        }
+
+        // Big-endian, in the order X, Z, Y
+        protected override byte ReadRegister(int register)
+        {
+            switch(register)
+            {
+            case Status:
+                return 0x01;
+            case OutXH:
+                NextSample();
+                return Axis(0, true, false);
+            case OutXH + 1: return Axis(0, false, false);
+            case OutXH + 2: return Axis(2, true, false);
+            case OutXH + 3: return Axis(2, false, false);
+            case OutXH + 4: return Axis(1, true, false);
+            case OutXH + 5: return Axis(1, false, false);
+            default:
+                return registers[register];
+            }
+        }
+
+        private const int Mode = 0x02;
+        private const int OutXH = 0x03;
+        private const int Status = 0x09;
+        private const int IdentA = 0x0A;
+        private const int IdentB = 0x0B;
+        private const int IdentC = 0x0C;
+    }
+}
+
+namespace Antmicro.Renode.Peripherals.Miscellaneous
+{
+    // Clock control: every oscillator and the PLL are ready as soon as they
+    // are enabled, and the clock switch takes effect at once
+    public class STM32F3_RCC : IDoubleWordPeripheral, IKnownSize
+    {
+        public STM32F3_RCC()
+        {
+            Reset();
+        }
+
+        public void Reset()
+        {
+            Array.Clear(registers, 0, registers.Length);
+            registers[CR / 4] = 0x00000083;
+            registers[AHBENR / 4] = 0x00000014;
+            registers[CSR / 4] = 0x0C000000;
+        }
+
+        public uint ReadDoubleWord(long offset)
+        {
+            var value = registers[offset / 4];
+            switch(offset)
+            {
+            case CR:
+                // HSIRDY, HSERDY, PLLRDY
+                value = (value & ~0x02020002u) | ((value & 0x01010001u) << 1);
+                break;
+            case CFGR:
+                // SWS = SW
+                value = (value & ~0xCu) | ((value & 0x3u) << 2);
+                break;
+            case BDCR:
+                // LSERDY
+                value = (value & ~0x2u) | ((value & 0x1u) << 1);
+                break;
+            case CSR:
+                // LSIRDY
+                value = (value & ~0x2u) | ((value & 0x1u) << 1);
+                break;
+            }
+            return value;
+        }
+
+        public void WriteDoubleWord(long offset, uint value)
+        {
+            if(offset == CSR)
+            {
+                // RMVF clears the reset flags
+                var flags = ((value & (1u << 24)) != 0) ? 0u : (registers[CSR / 4] & 0xFE000000u);
+                value = (value & ~0xFF000000u) | flags;
+            }
+            registers[offset / 4] = value;
+        }
+
+        public long Size => 0x400;
+
+        private readonly uint[] registers = new uint[0x100];
+
+        private const long CR = 0x00;
+        private const long CFGR = 0x04;
+        private const long AHBENR = 0x14;
+        private const long BDCR = 0x20;
+        private const long CSR = 0x24;
+    }
+
+    // Flash program and erase controller. Programming needs no help, the
+    // flash is a writable memory; page and mass erase fill it with 0xFF
+    public class STM32F3_FlashController : IDoubleWordPeripheral, IKnownSize
+    {
+        public STM32F3_FlashController(IMachine machine, ulong flashBase = 0x08000000, ulong flashSize = 0x40000, ulong pageSize = 0x800)
+        {
+            this.machine = machine;
+            this.flashBase = flashBase;
+            this.flashSize = flashSize;
+            this.pageSize = pageSize;
+            Reset();
+        }
+
+        public void Reset()
+        {
+            acr = 0x30;
+            cr = Lock;
+            sr = 0;
+            ar = 0;
+            keyStep = 0;
+        }
+
+        public uint ReadDoubleWord(long offset)
+        {
+            switch(offset)
+            {
+            case ACR:
+                return acr;
+            case SR:
+                return sr;
+            case CR:
+                return cr;
+            case AR:
+                return ar;
+            default:
+                return 0;
+            }
+        }
+
+        public void WriteDoubleWord(long offset, uint value)
+        {
+            switch(offset)
+            {
+            case ACR:
+                acr = value;
+                break;
+            case KEYR:
+                if(keyStep == 0 && value == Key1)
+                {
+                    keyStep = 1;
+                }
+                else if(keyStep == 1 && value == Key2)
+                {
+                    cr &= ~Lock;
+                    keyStep = 0;
+                }
+                else
+                {
+                    keyStep = 0;
+                }
+                break;
+            case SR:
+                // EOP, WRPRTERR and PGERR are cleared by writing 1
+                sr &= ~(value & 0x34u);
+                break;
+            case CR:
+                if((cr & Lock) != 0)
+                {
+                    this.Log(LogLevel.Warning, "Write to the locked FLASH_CR: 0x{0:X}", value);
+                    break;
+                }
+                cr = value & ~Start;
+                if((value & Start) != 0)
+                {
+                    Erase(value);
+                }
+                break;
+            case AR:
+                ar = value;
+                break;
+            }
+        }
+
+        public long Size => 0x400;
+
+        private void Erase(uint command)
+        {
+            ulong start;
+            ulong length;
+
+            if((command & MassErase) != 0)
+            {
+                start = flashBase;
+                length = flashSize;
+            }
+            else if((command & PageErase) != 0)
+            {
+                start = flashBase + (((ulong)ar - flashBase) / pageSize) * pageSize;
+                length = pageSize;
+            }
+            else
+            {
+                return;
+            }
+            machine.SystemBus.WriteBytes(Enumerable.Repeat((byte)0xFF, (int)length).ToArray(), start);
+            sr |= EndOfOperation;
+        }
+
+        private uint acr;
+        private uint cr;
+        private uint sr;
+        private uint ar;
+        private int keyStep;
+
+        private readonly IMachine machine;
+        private readonly ulong flashBase;
+        private readonly ulong flashSize;
+        private readonly ulong pageSize;
+
+        private const long ACR = 0x00;
+        private const long KEYR = 0x04;
+        private const long SR = 0x0C;
+        private const long CR = 0x10;
+        private const long AR = 0x14;
+
+        private const uint Key1 = 0x45670123;
+        private const uint Key2 = 0xCDEF89AB;
+        private const uint PageErase = 1u << 1;
+        private const uint MassErase = 1u << 2;
+        private const uint Start = 1u << 6;
+        private const uint Lock = 1u << 7;
+        private const uint EndOfOperation = 1u << 5;
+    }
+
+    // CRC calculation unit, 32-bit polynomials only. Data written 8, 16 or
+    // 32 bits at a time is fed MSB first after the REV_IN reversal
+    public class STM32F3_CRC : IBytePeripheral, IWordPeripheral, IDoubleWordPeripheral, IKnownSize
+    {
+        public STM32F3_CRC()
+        {
+            Reset();
+        }
+
+        public void Reset()
+        {
+            idr = 0;
+            cr = 0;
+            init = 0xFFFFFFFF;
+            polynomial = 0x04C11DB7;
+            crc = init;
+        }
+
+        public byte ReadByte(long offset)
+        {
+            return (byte)ReadDoubleWord(offset & ~3);
+        }
+
+        public ushort ReadWord(long offset)
+        {
+            return (ushort)ReadDoubleWord(offset & ~3);
+        }
+
+        public uint ReadDoubleWord(long offset)
+        {
+            switch(offset)
+            {
+            case DR:
+                return ((cr & 0x80) != 0) ? Reverse(crc, 32) : crc;
+            case IDR:
+                return idr;
+            case CR:
+                return cr;
+            case INIT:
+                return init;
+            case POL:
+                return polynomial;
+            default:
+                return 0;
+            }
+        }
+
+        public void WriteByte(long offset, byte value)
+        {
+            if(offset == DR)
+            {
+                Feed(value, 8);
+            }
+            else
+            {
+                WriteDoubleWord(offset, value);
+            }
+        }
+
+        public void WriteWord(long offset, ushort value)
+        {
+            if(offset == DR)
+            {
+                Feed(value, 16);
+            }
+            else
+            {
+                WriteDoubleWord(offset, value);
+            }
+        }
+
+        public void WriteDoubleWord(long offset, uint value)
+        {
+            switch(offset)
+            {
+            case DR:
+                Feed(value, 32);
+                break;
+            case IDR:
+                idr = value & 0xFF;
+                break;
+            case CR:
+                cr = value & 0xF8;
+                if((value & 1) != 0)
+                {
+                    crc = init;
+                }
+                break;
+            case INIT:
+                init = value;
+                break;
+            case POL:
+                polynomial = value;
+                break;
+            }
+        }
+
+        public long Size => 0x400;
+
+        private void Feed(uint data, int bits)
+        {
+            switch((cr >> 5) & 3)
+            {
+            case 1:
+                data = ReverseEach(data, bits, 8);
+                break;
+            case 2:
+                data = ReverseEach(data, bits, Math.Min(bits, 16));
+                break;
+            case 3:
+                data = Reverse(data, bits);
+                break;
+            }
+
+            crc ^= data << (32 - bits);
+            for(var i = 0; i < bits; i++)
+            {
+                crc = ((crc & 0x80000000) != 0) ? ((crc << 1) ^ polynomial) : (crc << 1);
+            }
+        }
+
+        private static uint ReverseEach(uint data, int bits, int width)
+        {
+            uint result = 0;
+            var mask = (width == 32) ? 0xFFFFFFFFu : ((1u << width) - 1);
+            for(var shift = 0; shift < bits; shift += width)
+            {
+                result |= Reverse((data >> shift) & mask, width) << shift;
+            }
+            return result;
+        }
+
+        private static uint Reverse(uint data, int bits)
+        {
+            uint result = 0;
+            for(var i = 0; i < bits; i++)
+            {
+                result = (result << 1) | ((data >> i) & 1);
+            }
+            return result;
+        }
+
+        private uint idr;
+        private uint cr;
+        private uint init;
+        private uint polynomial;
+        private uint crc;
+
+        private const long DR = 0x00;
+        private const long IDR = 0x04;
+        private const long CR = 0x08;
+        private const long INIT = 0x10;
+        private const long POL = 0x14;
+    }
+}
@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+"""Benchmark the firmware on the simulated STM32F3-Discovery with Renode.
+
+    make sim                                    # release build, FLOG demo
+    make sim SIM_DEMO=1 SIM_DATA=build/debug/flashlog.csv
+    bench.py --elf build/release/main --demo 4 --seconds 5
+
+Boots the ELF headless, presses the user button to reach the demo at
+--demo (the index in BSP_examples[] of main.c), lets it run for --seconds
+of simulated time and prints the instructions executed and the samples
+read from each sensor model over that window. --data replays a recording
+in the CSV format of tools/flashlog_dump.py, the sensors report a device
+lying flat and still otherwise.
+
+A firmware built with REPLAY=1 reads the sensors back from its LOG region
+instead (src/template/Src/replay.c): --log loads the image of "make
+logdump" there, and the replay counters and digest are printed as well.
+
+    make sim REPLAY=1 SIM_DEMO=2 SIM_LOG=build/debug/flashlog.bin
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import tempfile
+import time
+
+SIM_DIR = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(SIM_DIR)
+
+# The main loop debounces the button over 200 ms
+PRESS_INTERVAL = 0.3
+SENSORS = ["spi1.gyro", "i2c1.accelerometer", "i2c1.magnetometer"]
+
+# LOG region of default/STM32F303VCTx_FLASH.ld
+FLASHLOG_ADDR = 0x08026000
+# REPLAY_StatsTypeDef of replay.h: Frames, Skipped, Blocks, BadBlocks, Digest
+REPLAY_STATS = "ReplayStats"
+REPLAY_FIELDS = ["frames", "skipped", "blocks", "corrupt", "digest"]
+
+
+def interval(seconds):
+    """Renode time interval string."""
+    minutes, seconds = divmod(seconds, 60.0)
+    hours, minutes = divmod(int(minutes), 60)
+    return "%02d:%02d:%06.3f" % (hours, minutes, seconds)
+
+
+def counters():
+    return ["cpu ExecutedInstructions"] + ["%s SamplesRead" % s for s in SENSORS]
+
+
+def symbol(args, name):
+    """Address of a static variable of the ELF, renamed by LTO or not."""
+    out = subprocess.run([args.nm, args.elf], capture_output=True, text=True, check=True).stdout
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) == 3 and re.fullmatch(r"%s(\.\S+)?" % re.escape(name), fields[2]):
+            return int(fields[0], 16)
+    raise SystemExit("%s not found in %s, build with REPLAY=1" % (name, args.elf))
+
+
+def replay_reads(args):
+    """Monitor commands reading REPLAY_StatsTypeDef, one word per line."""
+    base = symbol(args, REPLAY_STATS)
+    return ["sysbus ReadDoubleWord 0x%08X" % (base + 4 * i) for i in range(len(REPLAY_FIELDS))]
+
+
+def script(args):
+    """Monitor commands of one benchmark run."""
+    cmds = ["logLevel 3",
+            "$elf=@%s" % os.path.abspath(args.elf),
+            "include @%s" % os.path.join(SIM_DIR, "stm32f3_discovery.resc")]
+    if args.data:
+        cmds += ["%s LoadSamples @%s" % (s, os.path.abspath(args.data)) for s in SENSORS]
+    if args.log:
+        cmds.append("sysbus LoadBinary @%s 0x%08X" % (os.path.abspath(args.log), FLASHLOG_ADDR))
+
+    # Boot, then one press leaves the LED loop and starts demo 0, two more
+    # presses per following demo
+    cmds.append('emulation RunFor "%s"' % interval(args.boot))
+    for _ in range(1 + 2 * args.demo):
+        cmds.append("gpioPortA.UserButton PressAndRelease")
+        cmds.append('emulation RunFor "%s"' % interval(PRESS_INTERVAL))
+
+    cmds += counters()
+    cmds.append('emulation RunFor "%s"' % interval(args.seconds))
+    cmds += counters()
+    if args.log:
+        cmds += replay_reads(args)
+    cmds.append("quit")
+    return "\n".join(cmds) + "\n"
+
+
+def run(args):
+    """Run Renode, return (counters at start, counters at end, replay
+    counters or None, wall time)."""
+    with tempfile.NamedTemporaryFile("w", suffix=".resc", delete=False) as f:
+        f.write(script(args))
+        path = f.name
+    try:
+        start = time.monotonic()
+        out = subprocess.run([args.renode, "--disable-xwt", "--console", "--plain", path],
+                             cwd=ROOT, capture_output=True, text=True, timeout=args.timeout)
+        wall = time.monotonic() - start
+    finally:
+        os.unlink(path)
+
+    # The counters are the last values the monitor prints, one per line
+    values = [int(line) for line in out.stdout.splitlines() if re.fullmatch(r"\s*\d+\s*", line)]
+    n = len(counters())
+    if out.returncode != 0 or len(values) < 2 * n:
+        sys.stderr.write(out.stdout + out.stderr)
+        raise SystemExit("renode failed, see the output above")
+    values = values[-2 * n:]
+
+    # ReadDoubleWord prints hexadecimal
+    replay = None
+    if args.log:
+        words = [int(line, 16) for line in out.stdout.splitlines()
+                 if re.fullmatch(r"\s*0x[0-9A-Fa-f]+\s*", line)]
+        replay = dict(zip(REPLAY_FIELDS, words[-len(REPLAY_FIELDS):]))
+    return values[:n], values[n:], replay, wall
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--elf", default=os.path.join(ROOT, "build", "release", "main"))
+    parser.add_argument("--demo", type=int, default=4, help="index in BSP_examples[]")
+    parser.add_argument("--seconds", type=float, default=5.0, help="simulated time measured")
+    parser.add_argument("--boot", type=float, default=2.0, help="simulated time before the first press")
+    parser.add_argument("--data", help="recording to replay, CSV of flashlog_dump.py")
+    parser.add_argument("--log", help="FLOG image for a REPLAY=1 build, flashlog.bin of make logdump")
+    parser.add_argument("--renode", default="renode")
+    parser.add_argument("--nm", default="arm-none-eabi-nm")
+    parser.add_argument("--timeout", type=float, default=600.0, help="wall time limit")
+    args = parser.parse_args()
+
+    start, end, replay, wall = run(args)
+    instructions = end[0] - start[0]
+    samples = [e - s for s, e in zip(start[1:], end[1:])]
+
+    print("demo %d, %.3f s simulated, %.1f s wall" % (args.demo, args.seconds, wall))
+    print("  instructions   %12d  %8.2f MIPS" % (instructions, instructions / args.seconds / 1e6))
+    for name, count in zip(SENSORS, samples):
+        per_sample = " %8d instr/sample" % (instructions // count) if count else ""
+        print("  %-16s %10d  %8.1f samples/s%s" % (name.split(".")[1], count, count / args.seconds,
+                                                   per_sample))
+    if replay:
+        per_frame = " %8d instr/frame" % (instructions // replay["frames"]) if replay["frames"] else ""
+        print("  replay           %10d  %8.1f frames/s%s" % (replay["frames"], replay["frames"] / args.seconds,
+                                                           per_frame))
+        print("  replay           %d skipped, %d blocks, %d corrupt, digest %08x" %
+              (replay["skipped"], replay["blocks"], replay["corrupt"], replay["digest"]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,60 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/ahrs.h
+  * @brief   Header for ahrs.c module
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AHRS_H
+#define __AHRS_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Madgwick gradient descent filter, single precision (FPU)
+  */
+typedef struct
+{
+  float Q[4];           /*!< Orientation quaternion w, x, y, z */
+  float Beta;           /*!< Gradient descent gain */
+  float SamplePeriod;   /*!< Seconds between two updates */
+} AHRS_MadgwickTypeDef;
+
+/**
+  * @brief Mahony complementary filter, fixed point.
+  *        Quaternion and unit vectors in Q4.28, rates and gains in Q16.16.
+  */
+typedef struct
+{
+  int32_t Q[4];           /*!< Orientation quaternion w, x, y, z (Q28) */
+  int32_t IntegralFB[3];  /*!< Integral feedback, rad/s (Q16) */
+  int32_t TwoKp;          /*!< 2 * proportional gain (Q16) */
+  int32_t TwoKi;          /*!< 2 * integral gain (Q16) */
+  int32_t Dt;             /*!< Sample period in s (Q28) */
+  int32_t HalfDt;         /*!< Half sample period in s (Q28) */
+} AHRS_MahonyQTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+#define AHRS_Q28_ONE              (1L << 28)
+
+/* Default tuning */
+#define AHRS_MADGWICK_BETA        0.1f
+#define AHRS_MAHONY_TWOKP_Q16     (2L * 65536L / 2)   /* Kp = 0.5  */
+#define AHRS_MAHONY_TWOKI_Q16     0L                  /* Ki = 0    */
+
+/* Exported macro ------------------------------------------------------------*/
+#define AHRS_FLOAT_TO_Q16(__X__)  ((int32_t)((__X__) * 65536.0f))
+#define AHRS_Q28_TO_FLOAT(__X__)  ((float)(__X__) * (1.0f / 268435456.0f))
+
+/* Exported functions ------------------------------------------------------- */
+void  AHRS_MadgwickInit(AHRS_MadgwickTypeDef *hahrs, float SampleFreq, float Beta);
+void  AHRS_MadgwickUpdate(AHRS_MadgwickTypeDef *hahrs, const float *pGyro, const float *pAcc, const float *pMag);
+float AHRS_MadgwickGetYaw(const AHRS_MadgwickTypeDef *hahrs);
+
+void  AHRS_MahonyQInit(AHRS_MahonyQTypeDef *hahrs, uint32_t SampleFreq, int32_t TwoKp, int32_t TwoKi);
+void  AHRS_MahonyQUpdate(AHRS_MahonyQTypeDef *hahrs, const int32_t *pGyro, const int32_t *pAcc, const int32_t *pMag);
+
+#endif /* __AHRS_H */
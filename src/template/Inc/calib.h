@@ -0,0 +1,76 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/calib.h
+  * @brief   Header for calib.c module
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CALIB_H
+#define __CALIB_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f3xx_hal.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Calibration coefficients as persisted, independent of the full scale
+  */
+typedef struct
+{
+  uint32_t Magic;         /*!< CALIB_MAGIC */
+  uint16_t Version;       /*!< CALIB_VERSION */
+  uint16_t Size;          /*!< sizeof(CALIB_DataTypeDef) */
+  float    GyroBias[3];   /*!< Zero rate offset, rad/s */
+  float    AccOffset[3];  /*!< Zero g offset, g at nominal sensitivity */
+  float    AccScale[3];   /*!< Gain correction relative to nominal sensitivity */
+} CALIB_DataTypeDef;
+
+/**
+  * @brief Per axis correction, out = Gain * raw + Offset
+  */
+typedef struct
+{
+  float Gain[3];
+  float Offset[3];
+} CALIB_LinearTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+#define CALIB_MAGIC               0x42494C43U   /* "CLIB" */
+#define CALIB_VERSION             1U
+
+/* Accelerometer faces captured by CALIB_AccCapture(), bit n of CALIB_AccFaces() */
+#define CALIB_FACE_XUP            0U
+#define CALIB_FACE_XDOWN          1U
+#define CALIB_FACE_YUP            2U
+#define CALIB_FACE_YDOWN          3U
+#define CALIB_FACE_ZUP            4U
+#define CALIB_FACE_ZDOWN          5U
+#define CALIB_FACE_ALL            0x3FU
+
+/* Averaging and acceptance limits */
+#define CALIB_GYRO_SAMPLES        512U
+#define CALIB_GYRO_STILL_MDPS     2000.0f   /*!< Max standard deviation while at rest */
+#define CALIB_ACC_SAMPLES         64U
+#define CALIB_ACC_SAMPLE_MS       20U       /*!< BSP_ACCELERO_Init() selects 50 Hz */
+#define CALIB_ACC_MIN_G           0.8f      /*!< Vertical axis must read at least this */
+#define CALIB_ACC_MAX_TILT_G      0.3f      /*!< Other axes must read less than this */
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+HAL_StatusTypeDef CALIB_Init(void);
+void              CALIB_UpdateGains(void);
+const CALIB_DataTypeDef *CALIB_GetData(void);
+
+HAL_StatusTypeDef CALIB_GyroBias(uint32_t NumSamples);
+HAL_StatusTypeDef CALIB_AccCapture(uint32_t NumSamples);
+uint8_t           CALIB_AccFaces(void);
+HAL_StatusTypeDef CALIB_AccSolve(void);
+
+HAL_StatusTypeDef CALIB_Load(void);
+HAL_StatusTypeDef CALIB_Save(void);
+
+void              CALIB_GyroApply(const int16_t *pRaw, float *pRate);
+void              CALIB_AccApply(const int16_t *pRaw, float *pAcc);
+
+#endif /* __CALIB_H */
@@ -0,0 +1,53 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/clock.h
+  * @brief   Header for clock.c module
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CLOCK_H
+#define __CLOCK_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f3xx_hal.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief System clock profiles
+  */
+typedef enum
+{
+  CLOCK_PROFILE_72MHZ     = 0,  /*!< HSE x9, APB1 36 MHz, USB at PLL / 1.5 */
+  CLOCK_PROFILE_48MHZ     = 1,  /*!< HSE x6, APB1 24 MHz, USB at PLL */
+  CLOCK_PROFILE_24MHZ     = 2,  /*!< HSE x3, APB1 24 MHz, no USB */
+  CLOCK_PROFILE_HSI_8MHZ  = 3,  /*!< HSI, HSE and PLL off, no USB */
+  CLOCK_PROFILE_COUNT
+} CLOCK_ProfileTypeDef;
+
+/**
+  * @brief Clock change notifications
+  */
+typedef enum
+{
+  CLOCK_EVENT_PRE_CHANGE  = 0,  /*!< Old clocks still running: finish transfers */
+  CLOCK_EVENT_POST_CHANGE = 1   /*!< New clocks running: retune prescalers */
+} CLOCK_EventTypeDef;
+
+typedef void (*CLOCK_CallbackTypeDef)(CLOCK_EventTypeDef Event, CLOCK_ProfileTypeDef Profile);
+
+/* Exported constants --------------------------------------------------------*/
+/* Registered callbacks at most */
+#define CLOCK_MAX_CALLBACKS   4U
+
+/* L3GD20 SPI clock limit, the SPI1 prescaler follows PCLK2 below it */
+#define CLOCK_GYRO_SPI_MAX_HZ 10000000U
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+HAL_StatusTypeDef    CLOCK_SetProfile(CLOCK_ProfileTypeDef Profile);
+CLOCK_ProfileTypeDef CLOCK_GetProfile(void);
+HAL_StatusTypeDef    CLOCK_Restore(void);
+HAL_StatusTypeDef    CLOCK_RegisterCallback(CLOCK_CallbackTypeDef Callback);
+
+#endif /* __CLOCK_H */
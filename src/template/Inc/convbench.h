@@ -0,0 +1,49 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/convbench.h
+  * @brief   Header for convbench.c module
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CONVBENCH_H
+#define __CONVBENCH_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f3xx_hal.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Time of each conversion over CONVBENCH_SAMPLES samples of three
+  *        axes, in ticks of the clock given to CONVBENCH_Run()
+  */
+typedef struct
+{
+  uint32_t LoopLe;        /*!< byte loop, little-endian */
+  uint32_t KernelLe;      /*!< MEMSCONV_Le() */
+  uint32_t LoopBe;        /*!< byte loop, big-endian */
+  uint32_t KernelBe;      /*!< MEMSCONV_Be(), REV16 */
+  uint32_t LoopScale;     /*!< 64-bit multiply per axis, to rad/s in Q16 */
+  uint32_t KernelScale;   /*!< MEMSCONV_ScaleQ(), SMULBB / SMULTT */
+  uint32_t Encode;        /*!< IMUC_Encode(), over CONVBENCH_CODEC_SAMPLES */
+  uint32_t EncodedSize;   /*!< bytes of one encoded codec block */
+  uint32_t Mismatches;    /*!< kernel results differing from their loop,
+                               and samples the codec did not restore */
+} CONVBENCH_ResultTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+/* Blocks of output registers, converted CONVBENCH_PASSES times */
+#define CONVBENCH_BLOCKS      64U
+#define CONVBENCH_PASSES      16U
+#define CONVBENCH_SAMPLES     (CONVBENCH_BLOCKS * CONVBENCH_PASSES)
+
+/* Codec block, the frame layout of the FLOG demo, encoded CONVBENCH_PASSES times */
+#define CONVBENCH_CODEC_FRAMES    64U
+#define CONVBENCH_CODEC_CHANNELS  9U
+#define CONVBENCH_CODEC_SAMPLES   (CONVBENCH_CODEC_FRAMES * CONVBENCH_CODEC_CHANNELS * CONVBENCH_PASSES)
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+const CONVBENCH_ResultTypeDef *CONVBENCH_Run(uint32_t (*Clock)(void));
+
+#endif /* __CONVBENCH_H */
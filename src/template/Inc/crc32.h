@@ -0,0 +1,22 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/crc32.h
+  * @brief   Header for crc32.c module
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CRC32_H
+#define __CRC32_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f3xx_hal.h"
+
+/* Exported types ------------------------------------------------------------*/
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+uint32_t CRC32_Calc(const void *pData, uint32_t Length);
+uint32_t CRC32_Accumulate(const void *pData, uint32_t Length);
+
+#endif /* __CRC32_H */
@@ -0,0 +1,108 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/dlog.h
+  * @brief   Header for dlog.c module
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __DLOG_H
+#define __DLOG_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "stm32f3xx_hal.h"
+#include "sections.h"
+
+/* Exported types ------------------------------------------------------------*/
+/* Exported constants --------------------------------------------------------*/
+/* Record: header, HAL_GetTick(), then one word per argument */
+#define DLOG_SYNC             0xD1U
+#define DLOG_MAX_ARGS         6U
+
+/* Format id of the record counting the records lost to a full ring */
+#define DLOG_ID_DROPPED       0xFFFFU
+
+/* Ring of record words, a power of two */
+#define DLOG_RING_WORDS       512U
+
+/* Exported macro ------------------------------------------------------------*/
+/* Header word: sync byte, argument count, format id. The id is the offset
+   of the format string in .dlog_fmt, below 64 KB (linker script) */
+#define DLOG_HEADER(__ID__, __NARGS__) \
+  ((DLOG_SYNC << 24) | ((uint32_t)(__NARGS__) << 16) | ((uint32_t)(__ID__) & 0xFFFFU))
+
+#if defined(__arm__)
+/**
+  * @brief  Record a message, formatted later by tools/dlog_decode.py.
+  *         DLOG("gyro %d %d %d", x, y, z);
+  *         Up to DLOG_MAX_ARGS arguments, each sent as one 32-bit word:
+  *           - integers, characters: any printf conversion
+  *           - float: pass DLOG_Float(x) and use %f, %e or %g
+  *           - %s: only strings that stay in flash (literals, const tables),
+  *             the tool reads them from the ELF
+  *         Safe from interrupt handlers. The format string is not loaded to
+  *         flash.
+  */
+#define DLOG(...)             DLOG_CAT(DLOG_ARGS_, DLOG_NARGS(__VA_ARGS__))(__VA_ARGS__)
+#else
+/* Host build (make host): no ELF to decode from, nothing recorded */
+#define DLOG(...)             do { } while(0)
+#endif
+
+#define DLOG_CAT(__A__, __B__)  DLOG_CAT_(__A__, __B__)
+#define DLOG_CAT_(__A__, __B__) __A__##__B__
+
+/* Number of arguments after the format */
+#define DLOG_NARGS(...)       DLOG_NARGS_(__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0, _)
+#define DLOG_NARGS_(_f, _1, _2, _3, _4, _5, _6, __N__, ...) __N__
+
+#define DLOG_ARGS_0(f)                    DLOG_EMIT(f)
+#define DLOG_ARGS_1(f, a)                 DLOG_EMIT(f, (uint32_t)(a))
+#define DLOG_ARGS_2(f, a, b)              DLOG_EMIT(f, (uint32_t)(a), (uint32_t)(b))
+#define DLOG_ARGS_3(f, a, b, c)           DLOG_EMIT(f, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c))
+#define DLOG_ARGS_4(f, a, b, c, d)        DLOG_EMIT(f, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), \
+                                                    (uint32_t)(d))
+#define DLOG_ARGS_5(f, a, b, c, d, e)     DLOG_EMIT(f, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), \
+                                                    (uint32_t)(d), (uint32_t)(e))
+#define DLOG_ARGS_6(f, a, b, c, d, e, g)  DLOG_EMIT(f, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), \
+                                                    (uint32_t)(d), (uint32_t)(e), (uint32_t)(g))
+
+/* The string only exists in .dlog_fmt, its address is the id. The tick is
+   filled in by DLOG_Write() */
+#define DLOG_EMIT(__FMT__, ...)                                               \
+  do                                                                          \
+  {                                                                           \
+    static const char dlogFmt[] __DLOG_FMT = __FMT__;                         \
+    uint32_t dlogRecord[] = { DLOG_HEADER(dlogFmt, 0U), 0U, ##__VA_ARGS__ };  \
+    DLOG_Write(dlogRecord, sizeof(dlogRecord) / sizeof(uint32_t));            \
+  } while(0)
+
+/* Exported functions ------------------------------------------------------- */
+void     DLOG_Init(void);
+void     DLOG_Write(uint32_t *pRecord, uint32_t Words);
+void     DLOG_Flush(void);
+uint32_t DLOG_GetDropped(void);
+
+/**
+  * @brief  Bits of a float argument, for %f, %e and %g.
+  * @param  Value: float to record
+  * @retval IEEE 754 single precision bits
+  */
+__STATIC_INLINE uint32_t DLOG_Float(float Value)
+{
+  uint32_t bits;
+
+  memcpy(&bits, &Value, sizeof(bits));
+  return bits;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DLOG_H */
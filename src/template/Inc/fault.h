@@ -0,0 +1,78 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/fault.h
+  * @brief   Header for fault.c module
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __FAULT_H
+#define __FAULT_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f3xx_hal.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define FAULT_MAGIC           0x544C5546U     /* "FULT" */
+#define FAULT_VERSION         1U
+
+/* Words of stack saved from the pre-exception stack pointer upwards */
+#define FAULT_STACK_WORDS     64U
+
+/* Stack of the capture code, in bytes, plain number for the handler asm */
+#define FAULT_HANDLER_STACK   512
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Crash dump, kept in __NOINIT RAM across the reset and then in the
+  *        key-value store (KV_KEY_FAULT). tools/crashdump.py mirrors it.
+  */
+typedef struct
+{
+  uint32_t Magic;         /*!< FAULT_MAGIC */
+  uint32_t Version;       /*!< FAULT_VERSION */
+  uint32_t Check;         /*!< XOR of the record words is 0 */
+  uint32_t Tick;          /*!< HAL_GetTick() at the fault */
+  uint32_t ExcReturn;     /*!< LR on exception entry */
+  uint32_t Ipsr;          /*!< 3 HardFault, 4 MemManage, 5 BusFault, 6 UsageFault */
+  uint32_t Sp;            /*!< Stack pointer before the exception frame */
+  uint32_t R[13];         /*!< r0-r12 */
+  uint32_t Lr;
+  uint32_t Pc;
+  uint32_t Xpsr;
+  uint32_t Cfsr;
+  uint32_t Hfsr;
+  uint32_t Mmfar;
+  uint32_t Bfar;
+  uint32_t Afsr;
+  uint32_t StackWords;    /*!< Valid words in Stack */
+  uint32_t Stack[FAULT_STACK_WORDS];
+} FAULT_RecordTypeDef;
+
+/* Exported macro ------------------------------------------------------------*/
+#define FAULT_STR_(__X__)     #__X__
+#define FAULT_STR(__X__)      FAULT_STR_(__X__)
+
+/* Body of the fault handlers, which must be naked: hands the exception
+   frame, EXC_RETURN and r4-r11 over to FAULT_Capture(), on a stack of its
+   own in case the fault is a stack overflow */
+#define FAULT_HANDLER_BODY()                                                  \
+  __asm volatile("tst    lr, #4                                         \n"   \
+                 "ite    eq                                             \n"   \
+                 "mrseq  r0, msp                                        \n"   \
+                 "mrsne  r0, psp                                        \n"   \
+                 "mov    r1, lr                                         \n"   \
+                 "movw   r2, #:lower16:FaultStack+" FAULT_STR(FAULT_HANDLER_STACK) "\n" \
+                 "movt   r2, #:upper16:FaultStack+" FAULT_STR(FAULT_HANDLER_STACK) "\n" \
+                 "msr    msp, r2                                        \n"   \
+                 "push   {r4-r11}                                       \n"   \
+                 "mov    r2, sp                                         \n"   \
+                 "b      FAULT_Capture                                  \n")
+
+/* Exported functions ------------------------------------------------------- */
+void                       FAULT_Init(void);
+void                       FAULT_Capture(uint32_t *pFrame, uint32_t ExcReturn, uint32_t *pCallee) __attribute__((noreturn));
+const FAULT_RecordTypeDef *FAULT_GetLast(void);
+uint8_t                    FAULT_IsNew(void);
+
+#endif /* __FAULT_H */
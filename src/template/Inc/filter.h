@@ -0,0 +1,95 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/filter.h
+  * @brief   Header for filter.c module
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __FILTER_H
+#define __FILTER_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f3xx_hal.h"
+#include "arm_math.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Kind of a pipeline stage
+  */
+typedef enum
+{
+  FILTER_STAGE_BIQUAD   = 0,  /*!< Cascade of direct form I biquads */
+  FILTER_STAGE_FIR      = 1,  /*!< FIR, even number of taps >= 4 */
+  FILTER_STAGE_MOVAVG   = 2,  /*!< Moving average over a power of two window */
+  FILTER_STAGE_DECIMATE = 3   /*!< Anti-alias FIR and downsampling by M */
+} FILTER_StageKindTypeDef;
+
+/**
+  * @brief Moving average state
+  */
+typedef struct
+{
+  q15_t    *pHistory;   /*!< Last Length input samples */
+  uint16_t  Length;     /*!< Window length, power of two */
+  uint16_t  Index;      /*!< Oldest sample in pHistory */
+  uint8_t   Shift;      /*!< log2(Length) */
+  int32_t   Sum;        /*!< Running sum of pHistory */
+} FILTER_MovAvgTypeDef;
+
+/**
+  * @brief One pipeline stage, initialise with the FILTER_Init<Kind>() functions
+  */
+typedef struct
+{
+  FILTER_StageKindTypeDef Kind;
+  union
+  {
+    arm_biquad_casd_df1_inst_q15  Biquad;
+    arm_fir_instance_q15          Fir;
+    arm_fir_decimate_instance_q15 Decimate;
+    FILTER_MovAvgTypeDef          MovAvg;
+  } Inst;
+} FILTER_StageTypeDef;
+
+/**
+  * @brief Chain of stages run block by block on one q15 channel
+  */
+typedef struct
+{
+  FILTER_StageTypeDef *Stages;      /*!< Stages in processing order */
+  uint32_t             NumStages;
+  uint32_t             BlockSize;   /*!< Largest input block of FILTER_Process() */
+  uint32_t             Decimation;  /*!< Product of the decimation factors */
+  q15_t               *pScratch;    /*!< BlockSize samples between stages */
+} FILTER_PipelineTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+/* Block length of the sensor pipelines, 16..32 samples amortise the call
+   and loop overhead of the CMSIS kernels */
+#ifndef FILTER_BLOCK_SIZE
+ #define FILTER_BLOCK_SIZE          32U
+#endif
+
+/* Largest DC gain error of FILTER_DesignLowpass() after quantisation */
+#define FILTER_DC_GAIN_TOLERANCE    0.02f
+
+/* Exported macro ------------------------------------------------------------*/
+/* Sizes, in q15_t, of the storage the stages need */
+#define FILTER_BIQUAD_COEFF_SIZE(__SECTIONS__)            (6U * (__SECTIONS__))
+#define FILTER_BIQUAD_STATE_SIZE(__SECTIONS__)            (4U * (__SECTIONS__))
+#define FILTER_FIR_STATE_SIZE(__TAPS__, __BLOCK__)        ((__TAPS__) + (__BLOCK__))
+#define FILTER_DECIMATE_STATE_SIZE(__TAPS__, __BLOCK__)   ((__TAPS__) + (__BLOCK__) - 1U)
+
+/* Exported functions ------------------------------------------------------- */
+HAL_StatusTypeDef FILTER_InitBiquad(FILTER_StageTypeDef *hstage, uint8_t NumSections, q15_t *pCoeffs, q15_t *pState, int8_t PostShift);
+HAL_StatusTypeDef FILTER_InitFir(FILTER_StageTypeDef *hstage, uint16_t NumTaps, q15_t *pCoeffs, q15_t *pState, uint32_t BlockSize);
+HAL_StatusTypeDef FILTER_InitDecimate(FILTER_StageTypeDef *hstage, uint16_t NumTaps, uint8_t Factor, q15_t *pCoeffs, q15_t *pState, uint32_t BlockSize);
+HAL_StatusTypeDef FILTER_InitMovAvg(FILTER_StageTypeDef *hstage, uint16_t Length, q15_t *pHistory);
+HAL_StatusTypeDef FILTER_DesignLowpass(q15_t *pCoeffs, float Fc, float Fs, float Q, int8_t *pPostShift);
+
+HAL_StatusTypeDef FILTER_PipelineInit(FILTER_PipelineTypeDef *hpipe, FILTER_StageTypeDef *pStages, uint32_t NumStages, uint32_t BlockSize, q15_t *pScratch);
+uint32_t          FILTER_Process(FILTER_PipelineTypeDef *hpipe, q15_t *pIn, q15_t *pOut, uint32_t Count);
+void              FILTER_Deinterleave(const int16_t *pXYZ, q15_t *pX, q15_t *pY, q15_t *pZ, uint32_t Count);
+
+#endif /* __FILTER_H */
@@ -0,0 +1,41 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/filterbench.h
+  * @brief   Header for filterbench.c module
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __FILTERBENCH_H
+#define __FILTERBENCH_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f3xx_hal.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Time of the pipeline over FILTERBENCH_SAMPLES samples, in ticks
+  *        of the clock given to FILTERBENCH_Run(), and output checks
+  */
+typedef struct
+{
+  uint32_t PerSample;     /*!< one sample per FILTER_Process() call */
+  uint32_t Block;         /*!< FILTER_BLOCK_SIZE samples per call */
+  uint32_t Mismatches;    /*!< block outputs differing from per-sample outputs */
+  int32_t  DcOutput;      /*!< settled output for a constant FILTERBENCH_DC_INPUT */
+} FILTERBENCH_ResultTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+/* Input samples, filtered FILTERBENCH_PASSES times */
+#define FILTERBENCH_LENGTH    256U
+#define FILTERBENCH_PASSES    4U
+#define FILTERBENCH_SAMPLES   (FILTERBENCH_LENGTH * FILTERBENCH_PASSES)
+
+/* Constant input of the DC check, a quarter of full scale */
+#define FILTERBENCH_DC_INPUT  8192
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+const FILTERBENCH_ResultTypeDef *FILTERBENCH_Run(uint32_t (*Clock)(void));
+
+#endif /* __FILTERBENCH_H */
@@ -0,0 +1,77 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/flashlog.h
+  * @brief   Header for flashlog.c module
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __FLASHLOG_H
+#define __FLASHLOG_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f3xx_hal.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Block header as stored in flash, followed by Length bytes of
+  *        payload. Mirrored by tools/flashlog_dump.py, keep both in sync.
+  */
+typedef struct
+{
+  uint16_t Magic;     /*!< FLOG_MAGIC, 0xFFFF: erased, rest of the page unused */
+  uint16_t Length;    /*!< Payload bytes, padded to a word */
+  uint32_t Crc;       /*!< CRC-32 from Seq to the end of the payload */
+  uint32_t Seq;       /*!< Block number, keeps increasing across sessions */
+  uint32_t Tick;      /*!< HAL_GetTick() at the first frame, ms */
+  uint16_t Session;   /*!< Incremented by every FLOG_Start() */
+  uint16_t Rate;      /*!< Frames per second */
+  uint16_t Frames;    /*!< Frames in the block */
+  uint8_t  Channels;  /*!< int16_t samples per frame */
+  uint8_t  Encoding;  /*!< FLOG_ENC_xxx */
+} FLOG_BlockTypeDef;
+
+typedef enum
+{
+  FLOG_STATE_IDLE = 0,
+  FLOG_STATE_RECORDING,
+  FLOG_STATE_FULL       /*!< No erased page left, frames are discarded */
+} FLOG_StateTypeDef;
+
+typedef struct
+{
+  uint32_t Blocks;      /*!< Blocks programmed */
+  uint32_t Overruns;    /*!< Frames lost, FLOG_Task() called too rarely */
+  uint32_t RawBytes;    /*!< Sample bytes before encoding */
+  uint32_t StoredBytes; /*!< Flash bytes used, headers included */
+} FLOG_StatsTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+#define FLOG_MAGIC            0x4C46U   /* "FL" */
+
+/* Payload encodings */
+#define FLOG_ENC_RAW          0U        /*!< Frames of int16_t, little endian */
+#define FLOG_ENC_DELTA8       1U        /*!< First frame raw, then int8_t deltas, no longer written */
+#define FLOG_ENC_PACKED       2U        /*!< IMUC_Encode() block */
+
+/* Frames per block and widest frame, a block must fit in one flash page */
+#define FLOG_BLOCK_FRAMES     64U
+#define FLOG_MAX_CHANNELS     9U
+#define FLOG_MAX_PAYLOAD      (FLOG_BLOCK_FRAMES * FLOG_MAX_CHANNELS * 2U)
+
+/* Half-words programmed per FLOG_Task() call, ~50 us each */
+#define FLOG_PROGRAM_BURST    16U
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+HAL_StatusTypeDef FLOG_Init(void);
+uint32_t          FLOG_PagesFor(uint8_t Channels, uint16_t Rate, uint32_t Seconds, uint8_t Bits);
+HAL_StatusTypeDef FLOG_Start(uint8_t Channels, uint16_t Rate, uint32_t ErasePages);
+HAL_StatusTypeDef FLOG_Write(const int16_t *pFrame);
+HAL_StatusTypeDef FLOG_Task(void);
+HAL_StatusTypeDef FLOG_Stop(void);
+HAL_StatusTypeDef FLOG_Erase(void);
+FLOG_StateTypeDef FLOG_GetState(void);
+const FLOG_StatsTypeDef *FLOG_GetStats(void);
+
+#endif /* __FLASHLOG_H */
@@ -0,0 +1,149 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/gpio_pin.hpp
+  * @brief   GPIO pins known at compile time, for C++ modules.
+  *
+  *          A pin is a type: Pin<Port::E, 9> carries its port and mask, so
+  *          every access compiles to one store to BSRR, or one load of IDR,
+  *          at a constant address. No lookup table, no HAL_GPIO_WritePin()
+  *          call. PinGroup<...> drives several pins of one port with a
+  *          single BSRR store, mixing ports is a compile error.
+  *
+  *          Pins are not configured here, HAL_GPIO_Init() or the BSP still
+  *          sets the mode once.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __GPIO_PIN_HPP
+#define __GPIO_PIN_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "stm32f3xx_hal.h"
+
+namespace gpio
+{
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief GPIO ports of the STM32F303xC, by base address
+  */
+enum class Port : uint32_t
+{
+  A = GPIOA_BASE,
+  B = GPIOB_BASE,
+  C = GPIOC_BASE,
+  D = GPIOD_BASE,
+  E = GPIOE_BASE,
+  F = GPIOF_BASE
+};
+
+/**
+  * @brief Registers of a port
+  */
+template<Port P>
+inline GPIO_TypeDef *Regs()
+{
+  return reinterpret_cast<GPIO_TypeDef *>(static_cast<uint32_t>(P));
+}
+
+/**
+  * @brief One pin. BSRR sets the low half, resets the high half, so a
+  *        write never disturbs the other pins, even from an interrupt.
+  */
+template<Port P, uint8_t N>
+struct Pin
+{
+  static_assert(N < 16U, "GPIO pins are numbered 0 to 15");
+
+  static constexpr Port     port = P;
+  static constexpr uint16_t mask = static_cast<uint16_t>(1U << N);
+
+  static void Set()
+  {
+    Regs<P>()->BSRR = mask;
+  }
+
+  static void Clear()
+  {
+    Regs<P>()->BSRR = static_cast<uint32_t>(mask) << 16;
+  }
+
+  static void Write(bool On)
+  {
+    Regs<P>()->BSRR = On ? static_cast<uint32_t>(mask) : (static_cast<uint32_t>(mask) << 16);
+  }
+
+  /* One ODR load, one BSRR store */
+  static void Toggle()
+  {
+    uint32_t odr = Regs<P>()->ODR;
+    Regs<P>()->BSRR = ((odr & mask) << 16) | (~odr & mask);
+  }
+
+  static bool Read()
+  {
+    return (Regs<P>()->IDR & mask) != 0U;
+  }
+};
+
+/**
+  * @brief Pins of one port driven together, one BSRR store per access.
+  */
+template<class First, class... Rest>
+struct PinGroup
+{
+  static constexpr Port     port = First::port;
+  static constexpr uint16_t mask = static_cast<uint16_t>(First::mask | (Rest::mask | ... | 0U));
+
+  static_assert(((Rest::port == First::port) && ...), "a pin group must stay on one port");
+  static_assert((First::mask + (Rest::mask + ... + 0U)) == mask, "a pin appears twice in the group");
+
+  /* Compile-time subset of the group, for Write() */
+  template<class... Pins>
+  static constexpr uint16_t Mask()
+  {
+    static_assert(((Pins::port == port) && ...), "pin outside the group port");
+    static_assert((((Pins::mask & mask) == Pins::mask) && ...), "pin outside the group");
+    return static_cast<uint16_t>((Pins::mask | ... | 0U));
+  }
+
+  static void Set()
+  {
+    Regs<port>()->BSRR = mask;
+  }
+
+  static void Clear()
+  {
+    Regs<port>()->BSRR = static_cast<uint32_t>(mask) << 16;
+  }
+
+  /* Pins of the group in OnMask are set, the others of the group cleared */
+  static void Write(uint16_t OnMask)
+  {
+    Regs<port>()->BSRR = (static_cast<uint32_t>(~OnMask & mask) << 16) | (OnMask & mask);
+  }
+
+  /* Set the pins of OnMask, clear the pins of OffMask, other pins unchanged */
+  static void Modify(uint16_t OnMask, uint16_t OffMask)
+  {
+    Regs<port>()->BSRR = (static_cast<uint32_t>(OffMask & mask) << 16) | (OnMask & mask);
+  }
+
+  static void Toggle(uint16_t ToggleMask = mask)
+  {
+    uint32_t odr = Regs<port>()->ODR;
+    ToggleMask &= mask;
+    Regs<port>()->BSRR = ((odr & ToggleMask) << 16) | (~odr & ToggleMask);
+  }
+
+  static uint16_t Read()
+  {
+    return static_cast<uint16_t>(Regs<port>()->IDR & mask);
+  }
+};
+
+} /* namespace gpio */
+
+#endif /* __GPIO_PIN_HPP */
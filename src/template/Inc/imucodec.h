@@ -0,0 +1,29 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/imucodec.h
+  * @brief   Header for imucodec.c module
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __IMUCODEC_H
+#define __IMUCODEC_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f3xx_hal.h"
+
+/* Exported types ------------------------------------------------------------*/
+/* Exported constants --------------------------------------------------------*/
+/* Per channel header: first sample (int16_t) and bit width (uint8_t) */
+#define IMUC_CHANNEL_HEADER     3U
+
+/* Exported macro ------------------------------------------------------------*/
+/* Worst case encoded size of a block, one byte per channel above raw */
+#define IMUC_MAX_SIZE(__FRAMES__, __CHANNELS__) \
+  ((__CHANNELS__) * (IMUC_CHANNEL_HEADER + (((__FRAMES__) - 1U) * 2U)))
+
+/* Exported functions ------------------------------------------------------- */
+uint32_t IMUC_Encode(const int16_t *pIn, uint32_t Frames, uint32_t Channels, uint8_t *pOut);
+uint32_t IMUC_Decode(const uint8_t *pIn, uint32_t Length, uint32_t Frames, uint32_t Channels, int16_t *pOut);
+
+#endif /* __IMUCODEC_H */
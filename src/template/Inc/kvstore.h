@@ -0,0 +1,49 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/kvstore.h
+  * @brief   Header for kvstore.c module
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __KVSTORE_H
+#define __KVSTORE_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f3xx_hal.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Keys of the persistent settings. Keys index a RAM table directly,
+  *        keep them dense and below KV_MAX_KEYS. Never reuse a retired key.
+  */
+typedef enum
+{
+  KV_KEY_CALIB              = 1,  /*!< CALIB_DataTypeDef */
+  KV_KEY_ACC_THRESHOLD_HIGH = 2,  /*!< int16_t, ACCELERO_MEMS_Test */
+  KV_KEY_ACC_THRESHOLD_LOW  = 3,  /*!< int16_t, ACCELERO_MEMS_Test */
+  KV_KEY_GYRO_INIT          = 4,  /*!< uint16_t, L3GD20_Init() CTRL1 | CTRL4 << 8, CTRL1 applied */
+  KV_KEY_ACC_INIT           = 5,  /*!< uint16_t, LSM303DLHC_AccInit() CTRL1 | CTRL4 << 8, CTRL1 applied */
+  KV_KEY_RESET_LOG          = 6,  /*!< WDOG_ResetLogTypeDef */
+  KV_KEY_FAULT              = 7   /*!< FAULT_RecordTypeDef */
+} KV_KeyTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+/* Size of the direct mapped key index */
+#ifndef KV_MAX_KEYS
+ #define KV_MAX_KEYS          32U
+#endif
+
+/* Largest value, a record must fit in one page with its header */
+#define KV_MAX_VALUE_SIZE     512U
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+HAL_StatusTypeDef KV_Init(void);
+HAL_StatusTypeDef KV_Format(void);
+HAL_StatusTypeDef KV_Get(uint16_t Key, void *pData, uint16_t Size, uint16_t *pLength);
+const void       *KV_GetPtr(uint16_t Key, uint16_t *pLength);
+HAL_StatusTypeDef KV_Set(uint16_t Key, const void *pData, uint16_t Length);
+HAL_StatusTypeDef KV_Delete(uint16_t Key);
+
+#endif /* __KVSTORE_H */
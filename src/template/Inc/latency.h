@@ -0,0 +1,82 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/latency.h
+  * @brief   Header for latency.c module
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LATENCY_H
+#define __LATENCY_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f3xx_hal.h"
+#include "tstamp.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Interrupt sources observed by the latency probe
+  */
+typedef enum
+{
+  LATENCY_IRQ_EXTI0     = 0,  /*!< User button / gyro INT1 line */
+  LATENCY_IRQ_SYSTICK   = 1,  /*!< HAL time base */
+  LATENCY_IRQ_DRDY_POLL = 2,  /*!< Not an interrupt: gyro data-ready edge to its
+                                   read by the polling loop of the AHRS demo */
+  LATENCY_IRQ_DRDY      = 3,  /*!< Gyro INT2/DRDY on EXTI1, from the timer
+                                   capture of the edge, AHRS demo */
+  LATENCY_IRQ_COUNT
+} LATENCY_IrqTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+/* Set to 0U (e.g. -DUSE_LATENCY_PROBE=0U) to compile the probes out of the ISRs */
+#ifndef USE_LATENCY_PROBE
+ #define USE_LATENCY_PROBE    1U
+#endif
+
+/* Histogram geometry: LATENCY_BINS linear bins of 2^LATENCY_BIN_SHIFT CPU
+   cycles each, the last bin collects everything above the range */
+#define LATENCY_BINS          32U
+#define LATENCY_BIN_SHIFT     3U
+
+/* LATENCY_Task(): software trigger of EXTI0 and report period, ms */
+#define LATENCY_PROBE_MS      100U
+#define LATENCY_REPORT_MS     10000U
+
+/**
+  * @brief Per interrupt latency statistics, all values in CPU cycles
+  */
+typedef struct
+{
+  uint32_t Count;
+  uint32_t Min;
+  uint32_t Max;
+  uint64_t Sum;
+  uint64_t SumSq;
+  uint32_t Hist[LATENCY_BINS];
+} LATENCY_StatsTypeDef;
+
+/* Exported macro ------------------------------------------------------------*/
+#if (USE_LATENCY_PROBE == 1U)
+ #define LATENCY_ENTER(__ID__)      LATENCY_Enter(__ID__)
+ #define LATENCY_ENTER_SYSTICK()    LATENCY_EnterSysTick()
+ #define LATENCY_ENTER_CAPTURE(__ID__, __SRC__)  LATENCY_EnterCapture((__ID__), (__SRC__))
+#else
+ #define LATENCY_ENTER(__ID__)      ((void)0U)
+ #define LATENCY_ENTER_SYSTICK()    ((void)0U)
+ #define LATENCY_ENTER_CAPTURE(__ID__, __SRC__)  ((void)0U)
+#endif /* USE_LATENCY_PROBE */
+
+/* Exported functions ------------------------------------------------------- */
+void     LATENCY_Init(void);
+void     LATENCY_Reset(void);
+void     LATENCY_Trigger(LATENCY_IrqTypeDef Id, IRQn_Type IRQn);
+void     LATENCY_Enter(LATENCY_IrqTypeDef Id);
+void     LATENCY_EnterSysTick(void);
+void     LATENCY_EnterCapture(LATENCY_IrqTypeDef Id, TSTAMP_SourceTypeDef Source);
+void     LATENCY_Record(LATENCY_IrqTypeDef Id, uint32_t Cycles);
+void     LATENCY_GetStats(LATENCY_IrqTypeDef Id, LATENCY_StatsTypeDef *pStats);
+void     LATENCY_Task(void);
+void     LATENCY_Report(void);
+
+#endif /* __LATENCY_H */
@@ -0,0 +1,45 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/leds.h
+  * @brief   Header for leds.cpp module
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LEDS_H
+#define __LEDS_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f3_discovery.h"
+
+/* Exported types ------------------------------------------------------------*/
+/* Exported constants --------------------------------------------------------*/
+/* LED masks, combined with | to drive several LEDs in one write. The eight
+   LEDs share GPIOE, leds.cpp checks these against its pin types. */
+#define LEDS_LED3             LED3_PIN
+#define LEDS_LED4             LED4_PIN
+#define LEDS_LED5             LED5_PIN
+#define LEDS_LED6             LED6_PIN
+#define LEDS_LED7             LED7_PIN
+#define LEDS_LED8             LED8_PIN
+#define LEDS_LED9             LED9_PIN
+#define LEDS_LED10            LED10_PIN
+#define LEDS_ALL              (LEDS_LED3 | LEDS_LED4 | LEDS_LED5 | LEDS_LED6 | \
+                               LEDS_LED7 | LEDS_LED8 | LEDS_LED9 | LEDS_LED10)
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+void LEDS_On(uint16_t Mask);
+void LEDS_Off(uint16_t Mask);
+void LEDS_Toggle(uint16_t Mask);
+void LEDS_Write(uint16_t OnMask);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LEDS_H */
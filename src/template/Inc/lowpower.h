@@ -0,0 +1,44 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/lowpower.h
+  * @brief   Header for lowpower.c module
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LOWPOWER_H
+#define __LOWPOWER_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f3xx_hal.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Idle depth
+  */
+typedef enum
+{
+  LPWR_SLEEP = 0,     /*!< Core stopped, clocks and peripherals running */
+  LPWR_STOP  = 1      /*!< All clocks stopped, regulator in low-power mode,
+                           clock profile restored on wakeup */
+} LPWR_ModeTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+/* No wakeup timer, only an interrupt ends the idle period */
+#define LPWR_WAIT_FOREVER     0xFFFFFFFFU
+
+/* Longest idle period the wakeup timer can time, longer ones are split */
+#define LPWR_MAX_IDLE_MS      20000U
+
+/* Shortest delay worth a STOP: the HSE and PLL restart takes about 2 ms */
+#define LPWR_STOP_MIN_MS      20U
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+HAL_StatusTypeDef LPWR_Init(void);
+void              LPWR_Calibrate(void);
+uint32_t          LPWR_Idle(LPWR_ModeTypeDef Mode, uint32_t Timeout);
+void              LPWR_Delay(uint32_t Delay, LPWR_ModeTypeDef Mode);
+void              LPWR_IRQHandler(void);
+
+#endif /* __LOWPOWER_H */
@@ -42,6 +42,18 @@
 #include "stm32f3_discovery_gyroscope.h"
 #include "stm32f3_discovery_accelerometer.h"
 #include "mems.h"
+#include "latency.h"
+#include "mempool.h"
+#include "kvstore.h"
+#include "flashlog.h"
+#include "lowpower.h"
+#include "clock.h"
+#include "wdog.h"
+#include "fault.h"
+#include "replay.h"
+#include "leds.h"
+#include "serial.h"
+#include "dlog.h"
 #include <stdio.h>
 
 /* Exported types ------------------------------------------------------------*/
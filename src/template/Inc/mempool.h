@@ -0,0 +1,74 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/mempool.h
+  * @brief   Header for mempool.c module
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __MEMPOOL_H
+#define __MEMPOOL_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f3xx_hal.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Fixed-block pool, use MEMPOOL_DEFINE() to instantiate one
+  */
+typedef struct
+{
+  void     *FreeList;     /*!< Singly linked list of free blocks */
+  uint8_t  *Storage;      /*!< Backing storage, BlockSize * BlockCount bytes */
+  uint32_t *InUse;        /*!< One bit per block, set while allocated */
+  uint16_t  BlockSize;    /*!< Block size in bytes, multiple of 4 */
+  uint16_t  BlockCount;   /*!< Number of blocks in the pool */
+  uint16_t  Used;         /*!< Blocks currently allocated */
+  uint16_t  HighWater;    /*!< Highest value Used has reached */
+  uint32_t  Failed;       /*!< Allocations refused because the pool was empty */
+} MEMPOOL_HandleTypeDef;
+
+/**
+  * @brief Pool usage snapshot
+  */
+typedef struct
+{
+  uint16_t BlockSize;
+  uint16_t BlockCount;
+  uint16_t Used;
+  uint16_t HighWater;
+  uint32_t Failed;
+} MEMPOOL_StatsTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+/* Pool geometry, override from the compiler command line if needed.
+   A sample block holds one flashlog.c block of frames (FLOG_MAX_PAYLOAD):
+   the recorder takes both, the gyro batch demo one */
+#ifndef MEMPOOL_SAMPLE_BLOCK_SIZE
+ #define MEMPOOL_SAMPLE_BLOCK_SIZE    1152U
+#endif
+#ifndef MEMPOOL_SAMPLE_BLOCK_COUNT
+ #define MEMPOOL_SAMPLE_BLOCK_COUNT   2U
+#endif
+
+/* Exported macro ------------------------------------------------------------*/
+#define MEMPOOL_ALIGN(__SIZE__)      ((((__SIZE__) < 4U ? 4U : (__SIZE__)) + 3U) & ~3U)
+
+/* Statically allocate a pool of __COUNT__ blocks of __SIZE__ bytes */
+#define MEMPOOL_DEFINE(__NAME__, __SIZE__, __COUNT__)                                  \
+  static uint32_t __NAME__##_Storage[(MEMPOOL_ALIGN(__SIZE__) / 4U) * (__COUNT__)];   \
+  static uint32_t __NAME__##_InUse[((__COUNT__) + 31U) / 32U];                          \
+  MEMPOOL_HandleTypeDef __NAME__ = { 0, (uint8_t *)__NAME__##_Storage, __NAME__##_InUse, \
+                                     MEMPOOL_ALIGN(__SIZE__), (__COUNT__), 0, 0, 0 }
+
+/* Exported variables --------------------------------------------------------*/
+extern MEMPOOL_HandleTypeDef MEMPOOL_Sample;
+
+/* Exported functions ------------------------------------------------------- */
+void              MEMPOOL_InitPools(void);
+void              MEMPOOL_Init(MEMPOOL_HandleTypeDef *hpool);
+void             *MEMPOOL_Alloc(MEMPOOL_HandleTypeDef *hpool);
+HAL_StatusTypeDef MEMPOOL_Free(MEMPOOL_HandleTypeDef *hpool, void *pBlock);
+void              MEMPOOL_GetStats(MEMPOOL_HandleTypeDef *hpool, MEMPOOL_StatsTypeDef *pStats);
+
+#endif /* __MEMPOOL_H */
@@ -49,6 +49,11 @@
 /* Exported functions ------------------------------------------------------- */
 void ACCELERO_MEMS_Test(void);
 void GYRO_MEMS_Test(void);
+void AHRS_MEMS_Test(void);
+void CALIB_MEMS_Test(void);
+void FLOG_MEMS_Test(void);
+void BATCH_MEMS_Test(void);
+void CONV_MEMS_Test(void);
 #endif /* __MEMS_H */
 
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,135 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/mems_conv.h
+  * @brief   Sample conversion kernels of the L3GD20 / LSM303DLHC drivers.
+  *
+  *          The six output registers of a sensor are three packed
+  *          halfwords. In little-endian (BLE = 0) they already are the
+  *          int16_t samples of the core: read them straight into the
+  *          sample array, nothing to assemble. In big-endian one REV16 per
+  *          word swaps two samples at once. The fixed-point scaling
+  *          multiplies the halfwords in place with SMULBB / SMULTT, without
+  *          unpacking them first.
+  *
+  *          The FPv4-SP unit of the Cortex-M4 has no vector instructions:
+  *          a float conversion stays one VCVT and one VMUL (or VFMA) per
+  *          axis, which the compiler already emits for a constant scale.
+  *
+  *          convbench.c times these kernels against the byte loops.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __MEMS_CONV_H
+#define __MEMS_CONV_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "stm32f3xx_hal.h"
+
+/* Exported types ------------------------------------------------------------*/
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Gain of MEMSCONV_ScaleQ() for a scale per LSB, with Shift extra fraction
+   bits: the result must fit in an int16_t, choose Shift accordingly */
+#define MEMSCONV_GAIN(__SCALE__, __SHIFT__) \
+  ((int16_t)(((__SCALE__) * (double)(1UL << (__SHIFT__))) + 0.5))
+
+/* Exported functions ------------------------------------------------------- */
+/**
+  * @brief  Signed 16 x 16 multiply of the bottom halfwords (SMULBB).
+  * @param  a: first factor in bits 15:0
+  * @param  b: second factor in bits 15:0
+  * @retval Product
+  */
+__STATIC_INLINE int32_t MEMSCONV_MulBB(uint32_t a, uint32_t b)
+{
+#if defined(__arm__)
+  int32_t result;
+
+  __asm("smulbb %0, %1, %2" : "=r" (result) : "r" (a), "r" (b));
+  return result;
+#else
+  return (int32_t)(int16_t)a * (int16_t)b;
+#endif
+}
+
+/**
+  * @brief  Signed 16 x 16 multiply of the top halfwords (SMULTT).
+  * @param  a: first factor in bits 31:16
+  * @param  b: second factor in bits 31:16
+  * @retval Product
+  */
+__STATIC_INLINE int32_t MEMSCONV_MulTT(uint32_t a, uint32_t b)
+{
+#if defined(__arm__)
+  int32_t result;
+
+  __asm("smultt %0, %1, %2" : "=r" (result) : "r" (a), "r" (b));
+  return result;
+#else
+  return (int32_t)(int16_t)(a >> 16) * (int16_t)(b >> 16);
+#endif
+}
+
+/**
+  * @brief  Three samples from little-endian output registers.
+  * @note   Reading the registers straight into pData needs no call at all,
+  *         this copy is for a separate buffer.
+  * @param  pBuffer: six output registers, any alignment
+  * @param  pData: X, Y, Z
+  * @retval None
+  */
+__STATIC_INLINE void MEMSCONV_Le(const uint8_t *pBuffer, int16_t *pData)
+{
+  memcpy(pData, pBuffer, 6U);
+}
+
+/**
+  * @brief  Three samples from big-endian output registers, two REV16.
+  * @param  pBuffer: six output registers, any alignment, may be pData
+  * @param  pData: X, Y, Z
+  * @retval None
+  */
+__STATIC_INLINE void MEMSCONV_Be(const uint8_t *pBuffer, int16_t *pData)
+{
+  uint32_t xy;
+  uint16_t z;
+
+  memcpy(&xy, pBuffer, 4U);
+  memcpy(&z, &pBuffer[4], 2U);
+  xy = __REV16(xy);
+  z = (uint16_t)__REV16(z);
+  memcpy(pData, &xy, 4U);
+  memcpy(&pData[2], &z, 2U);
+}
+
+/**
+  * @brief  Fixed-point scaling of three samples by one gain, on the packed
+  *         halfwords: pOut[i] = (pData[i] * Gain) >> Shift.
+  * @param  pData: X, Y, Z
+  * @param  Gain: scale per LSB in Q(Shift), see MEMSCONV_GAIN()
+  * @param  Shift: fraction bits of Gain removed from the product
+  * @param  pOut: X, Y, Z
+  * @retval None
+  */
+__STATIC_INLINE void MEMSCONV_ScaleQ(const int16_t *pData, int16_t Gain, uint32_t Shift, int32_t *pOut)
+{
+  uint32_t gain = (uint16_t)Gain * 0x00010001U;
+  uint32_t xy;
+
+  memcpy(&xy, pData, 4U);
+  pOut[0] = MEMSCONV_MulBB(xy, gain) >> Shift;
+  pOut[1] = MEMSCONV_MulTT(xy, gain) >> Shift;
+  pOut[2] = MEMSCONV_MulBB((uint16_t)pData[2], gain) >> Shift;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MEMS_CONV_H */
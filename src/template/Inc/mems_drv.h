@@ -0,0 +1,72 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/mems_drv.h
+  * @brief   Extensions of the L3GD20 / LSM303DLHC component drivers
+  *          (l3gd20.c, lsm303dlhc.c) not covered by the BSP driver structures.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __MEMS_DRV_H
+#define __MEMS_DRV_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported types ------------------------------------------------------------*/
+/* Exported constants --------------------------------------------------------*/
+/* L3GD20 STATUS_REG: new X, Y and Z data available */
+#define L3GD20_STATUS_ZYXDA                 0x08
+
+/* L3GD20 FIFO, 32 samples deep */
+#define L3GD20_FIFO_DEPTH                   32
+#define L3GD20_FIFO_EN                      0x40    /* CTRL_REG5 */
+#define L3GD20_I2_WTM                       0x04    /* CTRL_REG3, watermark on INT2 */
+#define L3GD20_FIFO_MODE_BYPASS             0x00    /* FIFO_CTRL_REG FM[2:0] */
+#define L3GD20_FIFO_MODE_STREAM             0x40
+#define L3GD20_FIFO_WTM_MASK                0x1F
+#define L3GD20_FIFO_SRC_OVRN                0x40    /* FIFO_SRC_REG */
+#define L3GD20_FIFO_SRC_FSS                 0x1F
+
+/* LSM303DLHC CRA_REG_M output data rate */
+#define LSM303DLHC_MAG_ODR_30_HZ            0x14
+#define LSM303DLHC_MAG_ODR_75_HZ            0x18
+#define LSM303DLHC_MAG_ODR_220_HZ           0x1C
+
+/* LSM303DLHC CRB_REG_M full scale */
+#define LSM303DLHC_MAG_FS_1_3_GA            0x20
+#define LSM303DLHC_MAG_FS_1_9_GA            0x40
+#define LSM303DLHC_MAG_FS_2_5_GA            0x60
+
+/* LSM303DLHC MR_REG_M mode */
+#define LSM303DLHC_MAG_CONTINUOUS           0x00
+#define LSM303DLHC_MAG_SLEEP                0x03
+
+/* LSM303DLHC magnetometer gain at +/-1.3 gauss, Z differs from X/Y */
+#define LSM303DLHC_MAG_LSB_PER_GAUSS_XY_1_3 1100
+#define LSM303DLHC_MAG_LSB_PER_GAUSS_Z_1_3  980
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+void  L3GD20_ReadXYZRaw(int16_t *pData);
+float L3GD20_GetSensitivity(void);
+void  L3GD20_FifoConfig(uint8_t Watermark);
+uint8_t L3GD20_FifoRead(int16_t *pData, uint8_t MaxSamples);
+
+void  LSM303DLHC_AccReadXYZRaw(int16_t* pData);
+float LSM303DLHC_AccGetSensitivity(void);
+void  LSM303DLHC_MagInit(uint8_t DataRate, uint8_t FullScale, uint8_t Mode);
+void  LSM303DLHC_MagReadXYZ(int16_t* pData);
+
+/* Burst read of the accelerometer / magnetometer bus, stm32f3_discovery.c */
+void  COMPASSACCELERO_IO_ReadBuffer(uint16_t DeviceAddr, uint8_t RegisterAddr, uint8_t *pBuffer, uint16_t NumByteToRead);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MEMS_DRV_H */
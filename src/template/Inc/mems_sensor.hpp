@@ -0,0 +1,373 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/mems_sensor.hpp
+  * @brief   L3GD20 and LSM303DLHC drivers configured at compile time, for
+  *          C++ modules.
+  *
+  *          Data rate, full scale, data alignment and filters are template
+  *          parameters. The control register values and the sensitivity
+  *          are constants of the type: Init() writes them, the read path is
+  *          one burst read of the six output registers straight into the
+  *          samples, swapped by REV16 in big-endian only (mems_conv.h).
+  *          No control register is read back and
+  *          no sample goes through a branch on the configuration, where
+  *          L3GD20_ReadXYZRaw() reads CTRL_REG4 before every sample and
+  *          LSM303DLHC_AccReadXYZRaw() makes seven I2C transfers.
+  *
+  *          The bus functions are those of the component drivers, so the
+  *          replay (replay.c) serves both.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __MEMS_SENSOR_HPP
+#define __MEMS_SENSOR_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "mems_drv.h"
+#include "mems_conv.h"
+/* Bus functions of stm32f3_discovery.c, C linkage */
+extern "C"
+{
+#include <../Components/l3gd20/l3gd20.h>
+#include <../Components/lsm303dlhc/lsm303dlhc.h>
+}
+
+namespace mems
+{
+
+/* Exported constants --------------------------------------------------------*/
+/* Register map, from the L3GD20 and LSM303DLHC datasheets */
+namespace reg
+{
+constexpr uint8_t GyroCtrl1     = 0x20;   /* CTRL_REG1 to CTRL_REG5 follow */
+constexpr uint8_t GyroOutXL     = 0x28;
+constexpr uint8_t GyroFifoSrc   = 0x2F;
+constexpr uint8_t AccAddress    = 0x32;
+constexpr uint8_t AccCtrl1      = 0x20;
+constexpr uint8_t AccCtrl2      = 0x21;
+constexpr uint8_t AccCtrl4      = 0x23;
+constexpr uint8_t AccOutXL      = 0x28;
+constexpr uint8_t AccIncrement  = 0x80;   /* subaddress MSB: auto-increment */
+constexpr uint8_t MagAddress    = 0x3C;
+constexpr uint8_t MagCra        = 0x00;
+constexpr uint8_t MagCrb        = 0x01;
+constexpr uint8_t MagMr         = 0x02;
+constexpr uint8_t MagOutXH      = 0x03;   /* X, Z, Y, big-endian */
+}
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Byte order of the output registers (BLE bit of CTRL_REG4)
+  */
+enum class Endian : uint8_t
+{
+  Little = 0x00,
+  Big    = 0x40
+};
+
+/**
+  * @brief L3GD20 output data rate, CTRL_REG1 DR
+  */
+enum class GyroOdr : uint8_t
+{
+  Hz95  = 0x00,
+  Hz190 = 0x40,
+  Hz380 = 0x80,
+  Hz760 = 0xC0
+};
+
+/**
+  * @brief L3GD20 low-pass bandwidth, CTRL_REG1 BW, cut-off set by the data
+  *        rate (datasheet table 21)
+  */
+enum class GyroBandwidth : uint8_t
+{
+  Bw1 = 0x00,
+  Bw2 = 0x10,
+  Bw3 = 0x20,
+  Bw4 = 0x30
+};
+
+/**
+  * @brief L3GD20 full scale, CTRL_REG4 FS
+  */
+enum class GyroScale : uint8_t
+{
+  Dps250  = 0x00,
+  Dps500  = 0x10,
+  Dps2000 = 0x20
+};
+
+/**
+  * @brief L3GD20 high-pass filter on the output, CTRL_REG2 HPCF cut-off
+  *        code (datasheet table 26), or Off
+  */
+enum class GyroHighPass : uint8_t
+{
+  Cf0 = 0, Cf1, Cf2, Cf3, Cf4, Cf5, Cf6, Cf7, Cf8, Cf9,
+  Off = 0xFF
+};
+
+/**
+  * @brief LSM303DLHC accelerometer data rate, CTRL_REG1_A ODR
+  */
+enum class AccOdr : uint8_t
+{
+  Hz1    = 0x10,
+  Hz10   = 0x20,
+  Hz25   = 0x30,
+  Hz50   = 0x40,
+  Hz100  = 0x50,
+  Hz200  = 0x60,
+  Hz400  = 0x70,
+  Hz1344 = 0x90
+};
+
+/**
+  * @brief LSM303DLHC accelerometer full scale, CTRL_REG4_A FS
+  */
+enum class AccScale : uint8_t
+{
+  G2  = 0x00,
+  G4  = 0x10,
+  G8  = 0x20,
+  G16 = 0x30
+};
+
+/**
+  * @brief LSM303DLHC accelerometer high-pass filter on the output,
+  *        CTRL_REG2_A HPCF, or Off
+  */
+enum class AccHighPass : uint8_t
+{
+  Cf0 = 0x00,
+  Cf1 = 0x10,
+  Cf2 = 0x20,
+  Cf3 = 0x30,
+  Off = 0xFF
+};
+
+/**
+  * @brief LSM303DLHC magnetometer data rate, CRA_REG_M DO
+  */
+enum class MagOdr : uint8_t
+{
+  Hz15  = 0x10,
+  Hz30  = 0x14,
+  Hz75  = 0x18,
+  Hz220 = 0x1C
+};
+
+/**
+  * @brief LSM303DLHC magnetometer range, CRB_REG_M GN
+  */
+enum class MagScale : uint8_t
+{
+  Ga1_3 = 0x20,
+  Ga1_9 = 0x40,
+  Ga2_5 = 0x60,
+  Ga4_0 = 0x80,
+  Ga4_7 = 0xA0,
+  Ga5_6 = 0xC0,
+  Ga8_1 = 0xE0
+};
+
+/* Exported functions ------------------------------------------------------- */
+/**
+  * @brief Three axes read as output registers into pData, to the byte
+  *        order of the core: nothing to do in little-endian.
+  */
+template<Endian Order>
+inline void Decode(int16_t *pData)
+{
+  if constexpr(Order == Endian::Big)
+  {
+    MEMSCONV_Be(reinterpret_cast<const uint8_t *>(pData), pData);
+  }
+}
+
+/**
+  * @brief L3GD20 gyroscope. Block data update stays continuous: at 760 Hz
+  *        the burst read ends well before the next sample.
+  */
+template<GyroOdr Odr, GyroScale Scale, Endian Order = Endian::Little,
+         GyroBandwidth Bandwidth = GyroBandwidth::Bw4, GyroHighPass HighPass = GyroHighPass::Off>
+struct L3gd20
+{
+  /* Power on, X, Y and Z enabled */
+  static constexpr uint8_t ctrl1 = static_cast<uint8_t>(Odr) | static_cast<uint8_t>(Bandwidth) | 0x0FU;
+  /* Normal high-pass mode, cut-off code */
+  static constexpr uint8_t ctrl2 = (HighPass == GyroHighPass::Off) ? 0x00U : static_cast<uint8_t>(HighPass);
+  static constexpr uint8_t ctrl4 = static_cast<uint8_t>(Order) | static_cast<uint8_t>(Scale);
+  /* HPen, output registers after the high-pass filter */
+  static constexpr uint8_t ctrl5 = (HighPass == GyroHighPass::Off) ? 0x00U : 0x11U;
+
+  /* mdps per LSB */
+  static constexpr float sensitivity = (Scale == GyroScale::Dps250) ? 8.75f :
+                                       (Scale == GyroScale::Dps500) ? 17.50f : 70.00f;
+
+  /* All five control registers in one write, interrupts (CTRL_REG3) and
+     FIFO off until configured */
+  static void Init()
+  {
+    uint8_t ctrl[5] = { ctrl1, ctrl2, 0x00U, ctrl4, ctrl5 };
+
+    GYRO_IO_Init();
+    GYRO_IO_Write(ctrl, reg::GyroCtrl1, sizeof(ctrl));
+  }
+
+  /* X, Y, Z in LSB */
+  static void ReadRaw(int16_t *pData)
+  {
+    GYRO_IO_Read(reinterpret_cast<uint8_t *>(pData), reg::GyroOutXL, 6);
+    Decode<Order>(pData);
+  }
+
+  /* X, Y, Z in mdps, as L3GD20_ReadXYZAngRate() */
+  static void Read(float *pData)
+  {
+    int16_t raw[3];
+
+    ReadRaw(raw);
+    for(uint32_t i = 0; i < 3U; i++)
+    {
+      pData[i] = static_cast<float>(raw[i]) * sensitivity;
+    }
+  }
+
+  /* Drain the FIFO set up by L3GD20_FifoConfig(), X, Y, Z in LSB per
+     sample, oldest first. Returns the samples read. */
+  static uint8_t FifoRead(int16_t *pData, uint8_t MaxSamples)
+  {
+    uint8_t src, count;
+
+    GYRO_IO_Read(&src, reg::GyroFifoSrc, 1);
+
+    /* FSS counts up to 31, a full FIFO is flagged as overrun in stream mode */
+    count = (src & L3GD20_FIFO_SRC_OVRN) ? L3GD20_FIFO_DEPTH : (src & L3GD20_FIFO_SRC_FSS);
+    if(count > MaxSamples)
+    {
+      count = MaxSamples;
+    }
+
+    /* Each read of the output registers pops one sample */
+    for(uint8_t n = 0; n < count; n++)
+    {
+      ReadRaw(&pData[3U * n]);
+    }
+    return count;
+  }
+};
+
+/**
+  * @brief LSM303DLHC accelerometer. The output is left aligned, 12 bits in
+  *        high resolution, 10 bits otherwise: the sensitivity per LSB of the
+  *        16-bit value is the same in both.
+  */
+template<AccOdr Odr, AccScale Scale, Endian Order = Endian::Little,
+         bool HighResolution = true, AccHighPass HighPass = AccHighPass::Off>
+struct Lsm303dlhcAcc
+{
+  /* Normal power, X, Y and Z enabled */
+  static constexpr uint8_t ctrl1 = static_cast<uint8_t>(Odr) | 0x07U;
+  /* Normal high-pass mode, cut-off, FDS: filtered output registers */
+  static constexpr uint8_t ctrl2 = (HighPass == AccHighPass::Off) ? 0x00U :
+                                   static_cast<uint8_t>(0x80U | static_cast<uint8_t>(HighPass) | 0x08U);
+  static constexpr uint8_t ctrl4 = static_cast<uint8_t>(Order) | static_cast<uint8_t>(Scale) |
+                                   (HighResolution ? 0x08U : 0x00U);
+
+  /* mg per LSB, the datasheet gives 1, 2, 4 and 12 mg per 12-bit LSB */
+  static constexpr float sensitivity = ((Scale == AccScale::G2) ? 1.0f :
+                                        (Scale == AccScale::G4) ? 2.0f :
+                                        (Scale == AccScale::G8) ? 4.0f : 12.0f) / 16.0f;
+
+  static void Init()
+  {
+    COMPASSACCELERO_IO_Init();
+    COMPASSACCELERO_IO_Write(reg::AccAddress, reg::AccCtrl1, ctrl1);
+    COMPASSACCELERO_IO_Write(reg::AccAddress, reg::AccCtrl2, ctrl2);
+    COMPASSACCELERO_IO_Write(reg::AccAddress, reg::AccCtrl4, ctrl4);
+  }
+
+  /* X, Y, Z in LSB, one I2C transfer */
+  static void ReadRaw(int16_t *pData)
+  {
+    COMPASSACCELERO_IO_ReadBuffer(reg::AccAddress, reg::AccOutXL | reg::AccIncrement,
+                                  reinterpret_cast<uint8_t *>(pData), 6);
+    Decode<Order>(pData);
+  }
+
+  /* X, Y, Z in mg */
+  static void Read(float *pData)
+  {
+    int16_t raw[3];
+
+    ReadRaw(raw);
+    for(uint32_t i = 0; i < 3U; i++)
+    {
+      pData[i] = static_cast<float>(raw[i]) * sensitivity;
+    }
+  }
+};
+
+/**
+  * @brief LSM303DLHC magnetometer, continuous conversion. Its output is
+  *        always big-endian and the Z gain differs from X and Y.
+  */
+template<MagOdr Odr, MagScale Scale>
+struct Lsm303dlhcMag
+{
+  static constexpr uint8_t cra = static_cast<uint8_t>(Odr);
+  static constexpr uint8_t crb = static_cast<uint8_t>(Scale);
+  static constexpr uint8_t mr  = 0x00U;
+
+  /* LSB per gauss, datasheet table 3 */
+  static constexpr float gainXY = (Scale == MagScale::Ga1_3) ? 1100.0f :
+                                  (Scale == MagScale::Ga1_9) ? 855.0f :
+                                  (Scale == MagScale::Ga2_5) ? 670.0f :
+                                  (Scale == MagScale::Ga4_0) ? 450.0f :
+                                  (Scale == MagScale::Ga4_7) ? 400.0f :
+                                  (Scale == MagScale::Ga5_6) ? 330.0f : 230.0f;
+  static constexpr float gainZ  = (Scale == MagScale::Ga1_3) ? 980.0f :
+                                  (Scale == MagScale::Ga1_9) ? 760.0f :
+                                  (Scale == MagScale::Ga2_5) ? 600.0f :
+                                  (Scale == MagScale::Ga4_0) ? 400.0f :
+                                  (Scale == MagScale::Ga4_7) ? 355.0f :
+                                  (Scale == MagScale::Ga5_6) ? 295.0f : 205.0f;
+
+  static void Init()
+  {
+    COMPASSACCELERO_IO_Write(reg::MagAddress, reg::MagCra, cra);
+    COMPASSACCELERO_IO_Write(reg::MagAddress, reg::MagCrb, crb);
+    COMPASSACCELERO_IO_Write(reg::MagAddress, reg::MagMr, mr);
+  }
+
+  /* X, Y, Z in LSB, one I2C transfer */
+  static void ReadRaw(int16_t *pData)
+  {
+    int16_t xzy[3];
+
+    COMPASSACCELERO_IO_ReadBuffer(reg::MagAddress, reg::MagOutXH, reinterpret_cast<uint8_t *>(xzy), 6);
+    Decode<Endian::Big>(xzy);
+    pData[0] = xzy[0];
+    pData[1] = xzy[2];
+    pData[2] = xzy[1];
+  }
+
+  /* X, Y, Z in gauss, by the reciprocal of the gains */
+  static void Read(float *pData)
+  {
+    int16_t raw[3];
+
+    ReadRaw(raw);
+    pData[0] = static_cast<float>(raw[0]) * (1.0f / gainXY);
+    pData[1] = static_cast<float>(raw[1]) * (1.0f / gainXY);
+    pData[2] = static_cast<float>(raw[2]) * (1.0f / gainZ);
+  }
+};
+
+} /* namespace mems */
+
+#endif /* __MEMS_SENSOR_HPP */
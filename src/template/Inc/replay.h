@@ -0,0 +1,67 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/replay.h
+  * @brief   Header for replay.c module
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __REPLAY_H
+#define __REPLAY_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f3xx_hal.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Replay counters
+  */
+typedef struct
+{
+  uint32_t Frames;      /*!< Gyroscope frames read by the firmware */
+  uint32_t Skipped;     /*!< Frames overwritten before they were read, real-time only */
+  uint32_t Blocks;      /*!< Log blocks decoded */
+  uint32_t BadBlocks;   /*!< Blocks of the session failing their CRC, skipped */
+  uint32_t Digest;      /*!< REPLAY_Check() hash */
+} REPLAY_StatsTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+/* Speed of REPLAY_Start(): multiple of the recorded rate, or as fast as the
+   firmware reads, each read of the output registers returns the next frame */
+#define REPLAY_SPEED_FAST     0U
+#define REPLAY_SPEED_REALTIME 1U
+
+/* Speed of the firmware replay build (make REPLAY=1) */
+#ifndef REPLAY_SPEED
+ #define REPLAY_SPEED         REPLAY_SPEED_REALTIME
+#endif
+
+/* Session argument of REPLAY_Start() selecting the last recorded one */
+#define REPLAY_LAST_SESSION   0U
+
+/* Sensor bus addresses, as passed to COMPASSACCELERO_IO_Read() */
+#define REPLAY_ACC_ADDRESS    0x32U
+#define REPLAY_MAG_ADDRESS    0x3CU
+
+/* Initial value of REPLAY_Hash(), FNV-1a 32-bit */
+#define REPLAY_HASH_INIT      0x811C9DC5U
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+void              REPLAY_Init(const uint8_t *pImage, uint32_t Size);
+HAL_StatusTypeDef REPLAY_Start(uint16_t Session, uint32_t Speed, uint32_t (*pMicros)(void));
+void              REPLAY_Stop(void);
+uint8_t           REPLAY_IsActive(void);
+uint8_t           REPLAY_IsDone(void);
+uint16_t          REPLAY_GetRate(void);
+
+void              REPLAY_GyroRead(uint8_t *pBuffer, uint8_t ReadAddr, uint16_t NumByteToRead);
+void              REPLAY_GyroWrite(const uint8_t *pBuffer, uint8_t WriteAddr, uint16_t NumByteToWrite);
+uint8_t           REPLAY_AccMagRead(uint16_t DeviceAddr, uint8_t RegisterAddr);
+void              REPLAY_AccMagWrite(uint16_t DeviceAddr, uint8_t RegisterAddr, uint8_t Value);
+
+void              REPLAY_Check(const void *pData, uint32_t Length);
+uint32_t          REPLAY_Hash(uint32_t Hash, const void *pData, uint32_t Length);
+const REPLAY_StatsTypeDef *REPLAY_GetStats(void);
+
+#endif /* __REPLAY_H */
@@ -0,0 +1,49 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/ringbuf.h
+  * @brief   Header for ringbuf.c module
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __RINGBUF_H
+#define __RINGBUF_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f3xx_hal.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Single producer / single consumer ring of fixed size elements.
+  *        Head is only written by the producer, Tail only by the consumer.
+  *        Both run freely and wrap at 2^32, the slot index is (x & Mask).
+  */
+typedef struct
+{
+  uint8_t      *Buffer;     /*!< Storage, ElemSize * Capacity bytes */
+  uint32_t      ElemSize;   /*!< Element size in bytes */
+  uint32_t      Capacity;   /*!< Number of elements, power of two */
+  uint32_t      Mask;       /*!< Capacity - 1 */
+  __IO uint32_t Head;       /*!< Producer position */
+  __IO uint32_t Tail;       /*!< Consumer position */
+  __IO uint32_t Overflow;   /*!< Elements dropped by the producer, ring full */
+} RING_HandleTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+HAL_StatusTypeDef RING_Init(RING_HandleTypeDef *hring, void *pBuffer, uint32_t ElemSize, uint32_t Capacity);
+uint32_t RING_Count(const RING_HandleTypeDef *hring);
+uint32_t RING_Space(const RING_HandleTypeDef *hring);
+
+/* Producer side */
+uint32_t RING_Push(RING_HandleTypeDef *hring, const void *pData, uint32_t Count);
+uint32_t RING_WritePtr(RING_HandleTypeDef *hring, void **ppData);
+void     RING_Commit(RING_HandleTypeDef *hring, uint32_t Count);
+
+/* Consumer side */
+uint32_t RING_Pop(RING_HandleTypeDef *hring, void *pData, uint32_t Count);
+uint32_t RING_ReadPtr(RING_HandleTypeDef *hring, void **ppData);
+void     RING_Consume(RING_HandleTypeDef *hring, uint32_t Count);
+
+#endif /* __RINGBUF_H */
@@ -0,0 +1,56 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/sections.h
+  * @brief   Placement attributes for the memory regions of
+  *          default/STM32F303VCTx_FLASH.ld.
+  *          Functions placed in RAM or CCM-RAM keep running while the FLASH
+  *          is busy with an erase or program operation, as long as they do
+  *          not call back into FLASH.
+  *
+  *          CCM-RAM (8 KB at 0x10000000) is zero wait state and sits on its
+  *          own bus, so CPU accesses there never contend with DMA on SRAM.
+  *          It is not reachable by DMA: keep DMA buffers out of it.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SECTIONS_H
+#define __SECTIONS_H
+
+/* Exported macro ------------------------------------------------------------*/
+#if defined(__arm__)
+/* Initialized data in CCM-RAM, init-values copied by SystemInit() */
+#define __CCMRAM          __attribute__((section(".ccmram")))
+
+/* Zero initialized data in CCM-RAM, cleared by SystemInit() */
+#define __CCMRAM_BSS      __attribute__((section(".ccmbss")))
+
+/* Code executed from CCM-RAM. CCM is out of BL range of FLASH, so
+   use the attribute on the prototype as well when called directly */
+#define __CCMRAM_FUNC     __attribute__((section(".ccmram.text"), noinline, long_call))
+
+/* Code executed from SRAM. At 72 MHz every FLASH fetch costs two wait
+   states the prefetch buffer only partly hides, SRAM runs without them */
+#define __RAMFUNC         __attribute__((section(".ramfunc"), noinline, long_call))
+
+/* Data in SRAM left alone by the startup code: it keeps its content across
+   a reset, but is garbage after power-up, validate it before use */
+#define __NOINIT          __attribute__((section(".noinit")))
+
+/* Format strings of DLOG() (dlog.h): linked at address 0 and up, not
+   loaded to FLASH, read back from the ELF by tools/dlog_decode.py */
+#define __DLOG_FMT        __attribute__((section(".dlog_fmt"), used))
+
+#else
+/* Host build (make host): a single memory, placement does not apply */
+#define __CCMRAM
+#define __CCMRAM_BSS
+#define __CCMRAM_FUNC
+#define __RAMFUNC
+#define __NOINIT
+#define __DLOG_FMT
+#endif
+
+/* Exported functions ------------------------------------------------------- */
+
+#endif /* __SECTIONS_H */
@@ -0,0 +1,38 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/sensors.h
+  * @brief   Header for sensors.cpp module
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SENSORS_H
+#define __SENSORS_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported types ------------------------------------------------------------*/
+/* Exported constants --------------------------------------------------------*/
+/* Gyroscope scale of the settings in sensors.cpp, 500 dps, checked there */
+#define SENSORS_GYRO_MDPS_PER_LSB    17.50f
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+void    SENSORS_Init(void);
+void    SENSORS_InitBatch(void);
+void    SENSORS_GyroReadRaw(int16_t *pData);
+uint8_t SENSORS_GyroFifoRead(int16_t *pData, uint8_t MaxSamples);
+void    SENSORS_AccReadRaw(int16_t *pData);
+void    SENSORS_MagReadRaw(int16_t *pData);
+void    SENSORS_MagRead(float *pData);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SENSORS_H */
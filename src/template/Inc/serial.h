@@ -0,0 +1,48 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/serial.h
+  * @brief   Header for serial.c module
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SERIAL_H
+#define __SERIAL_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f3xx_hal.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Bytes lost on either side since SERIAL_Init()
+  */
+typedef struct
+{
+  uint32_t TxDropped;     /*!< Written while the transmit ring was full */
+  uint32_t RxOverrun;     /*!< Overwritten by the DMA before SERIAL_Read() */
+} SERIAL_StatsTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+/* 8N1, oversampling by 8: reached exactly by PCLK2 at 24, 48 and 72 MHz */
+#define SERIAL_BAUDRATE       3000000U
+
+/* Transmit ring and circular receive buffer, powers of two */
+#define SERIAL_TX_SIZE        2048U
+#define SERIAL_RX_SIZE        256U
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+HAL_StatusTypeDef          SERIAL_Init(void);
+uint32_t                   SERIAL_Write(const void *pData, uint32_t Size);
+uint32_t                   SERIAL_TxSpace(void);
+uint32_t                   SERIAL_Read(uint8_t *pData, uint32_t Size);
+uint32_t                   SERIAL_RxCount(void);
+uint8_t                    SERIAL_IsBusy(void);
+const SERIAL_StatsTypeDef *SERIAL_GetStats(void);
+
+/* Interrupt handlers of USART1, DMA1 channel 4 (TX) and 5 (RX) */
+void                       SERIAL_IRQHandler(void);
+void                       SERIAL_DmaTxIRQHandler(void);
+void                       SERIAL_DmaRxIRQHandler(void);
+
+#endif /* __SERIAL_H */
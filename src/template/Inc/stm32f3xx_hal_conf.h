@@ -72,7 +72,7 @@
 //#define HAL_SDADC_MODULE_ENABLED
 //#define HAL_SMARTCARD_MODULE_ENABLED
 #define HAL_SPI_MODULE_ENABLED
-//#define HAL_TIM_MODULE_ENABLED
+#define HAL_TIM_MODULE_ENABLED
 #define HAL_UART_MODULE_ENABLED
 #define HAL_USART_MODULE_ENABLED
 #define HAL_WWDG_MODULE_ENABLED
@@ -57,8 +57,13 @@ void DebugMon_Handler(void);
 void PendSV_Handler(void);
 void SysTick_Handler(void);
 void EXTI0_IRQHandler(void);
+void EXTI1_IRQHandler(void);
 void EXTI2_TS_IRQHandler(void);
 void EXTI15_10_IRQHandler(void);
+void RTC_WKUP_IRQHandler(void);
+void USART1_IRQHandler(void);
+void DMA1_Channel4_IRQHandler(void);
+void DMA1_Channel5_IRQHandler(void);
 
 #ifdef __cplusplus
 }
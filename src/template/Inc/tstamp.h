@@ -0,0 +1,41 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/tstamp.h
+  * @brief   Header for tstamp.c module
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __TSTAMP_H
+#define __TSTAMP_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f3xx_hal.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Data-ready lines captured by a timer input
+  */
+typedef enum
+{
+  TSTAMP_GYRO  = 0,   /*!< L3GD20 INT2/DRDY, PE1, TIM17_CH1 */
+  TSTAMP_ACC   = 1,   /*!< LSM303DLHC INT1 (DRDY1), PE4, TIM3_CH3 */
+  TSTAMP_MAG   = 2,   /*!< LSM303DLHC DRDY, PE2, TIM3_CH1 */
+  TSTAMP_COUNT
+} TSTAMP_SourceTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+/* Resolution of all timestamps */
+#define TSTAMP_FREQ           1000000U
+
+/* Exported macro ------------------------------------------------------------*/
+/* Elapsed microseconds, correct across the 32-bit wrap (71 minutes) */
+#define TSTAMP_ELAPSED(__FROM__, __TO__)  ((uint32_t)((__TO__) - (__FROM__)))
+
+/* Exported functions ------------------------------------------------------- */
+void              TSTAMP_Init(void);
+uint32_t          TSTAMP_Now(void);
+HAL_StatusTypeDef TSTAMP_Get(TSTAMP_SourceTypeDef Source, uint32_t *pTimestamp);
+HAL_StatusTypeDef TSTAMP_Latch(TSTAMP_SourceTypeDef Source, uint32_t *pTimestamp);
+
+#endif /* __TSTAMP_H */
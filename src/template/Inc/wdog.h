@@ -0,0 +1,80 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Inc/wdog.h
+  * @brief   Header for wdog.c module
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __WDOG_H
+#define __WDOG_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f3xx_hal.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Supervised tasks, each with its own check-in period
+  */
+typedef enum
+{
+  WDOG_TASK_MAIN  = 0,    /*!< Main loop and demo loops, always supervised */
+  WDOG_TASK_FLOG  = 1,    /*!< Flash log writer, while recording */
+  WDOG_TASK_COUNT
+} WDOG_TaskTypeDef;
+
+/**
+  * @brief Reset causes, from the RCC_CSR flags
+  */
+typedef enum
+{
+  WDOG_RESET_POWER    = 0,  /*!< Power-on or brown-out */
+  WDOG_RESET_PIN      = 1,  /*!< NRST pin, reset button or debugger */
+  WDOG_RESET_SOFTWARE = 2,  /*!< NVIC_SystemReset() */
+  WDOG_RESET_IWDG     = 3,  /*!< A task missed its check-in */
+  WDOG_RESET_WWDG     = 4,
+  WDOG_RESET_LOWPOWER = 5,  /*!< Illegal STOP / STANDBY entry */
+  WDOG_RESET_OPTION   = 6,  /*!< Option byte load */
+  WDOG_RESET_COUNT
+} WDOG_ResetTypeDef;
+
+/**
+  * @brief Reset history kept in the key-value store (KV_KEY_RESET_LOG).
+  *        Power-on and pin resets are not logged, to spare the flash.
+  */
+typedef struct
+{
+  uint32_t Counts[WDOG_RESET_COUNT];  /*!< Logged resets per cause */
+  uint32_t LastCause;                 /*!< WDOG_ResetTypeDef */
+  uint32_t LastTask;                  /*!< Task that stalled, WDOG_NO_TASK if unknown */
+  uint32_t LastTick;                  /*!< HAL_GetTick() when it was found stalled */
+} WDOG_ResetLogTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+/* IWDG timeout, LSI at 40 kHz nominal: 1.6 s to 2.7 s over the LSI range */
+#define WDOG_TIMEOUT_MS       2000U
+
+/* Check-in periods */
+#define WDOG_PERIOD_MAIN_MS   3000U
+#define WDOG_PERIOD_FLOG_MS   500U
+
+/* Supervision interval, from SysTick */
+#define WDOG_SERVICE_MS       100U
+
+/* Longest stretch without SysTick, i.e. a tickless idle period */
+#define WDOG_MAX_IDLE_MS      1000U
+
+#define WDOG_NO_TASK          0xFFFFFFFFU
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+void                        WDOG_Init(void);
+void                        WDOG_TaskStart(WDOG_TaskTypeDef Task);
+void                        WDOG_TaskStop(WDOG_TaskTypeDef Task);
+void                        WDOG_CheckIn(WDOG_TaskTypeDef Task);
+void                        WDOG_Service(void);
+uint8_t                     WDOG_IsRunning(void);
+WDOG_ResetTypeDef           WDOG_GetResetCause(void);
+const WDOG_ResetLogTypeDef *WDOG_GetResetLog(void);
+
+#endif /* __WDOG_H */
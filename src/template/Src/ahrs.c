@@ -0,0 +1,437 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Src/ahrs.c
+  * @brief   Attitude and heading reference: fuses L3GD20 rates, LSM303DLHC
+  *          acceleration and magnetic field into an orientation quaternion.
+  *
+  *          Two filters are provided:
+  *          - Madgwick gradient descent (MARG, or IMU when no field is given),
+  *            single precision, for the Cortex-M4 FPU.
+  *          - Mahony complementary filter in fixed point (Q4.28 quaternion,
+  *            Q16.16 rates), for builds without FPU context or when the
+  *            filter has to run inside an ISR that must not stack S0-S31.
+  *
+  *          Cycle budget at 72 MHz, gyro ODR 760 Hz: 94736 cycles per sample.
+  *          Both update functions run from SRAM (no FLASH wait states).
+  *          Estimates from the operation counts at -O2, not measurements:
+  *          - Madgwick MARG  ~ 1500 cycles (~1.6 %), IMU ~ 700 cycles
+  *          - Mahony fixed   ~ 2000 cycles (~2.1 %), IMU ~ 1100 cycles
+  *          The fixed point cost is dominated by 64-bit products (SMULL) and
+  *          the Newton inverse square roots. The AHRS demo (mems.c) measures
+  *          the Madgwick update with DWT->CYCCNT and logs its mean and worst
+  *          case through DLOG; the Mahony filter has no target caller.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include "ahrs.h"
+#include "sections.h"
+
+/** @addtogroup BSP_Examples
+  * @{
+  */
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+#define Q28_HALF        (1L << 27)
+
+/* Newton iterations of the fixed point inverse square root, the linear
+   first guess is within 18 %, 4 steps reach the Q29 resolution */
+#define RSQRT_ITERATIONS  4U
+
+/* Private macro -------------------------------------------------------------*/
+/* Q28 x Q28 -> Q28 */
+#define QMUL(__A__, __B__)  ((int32_t)(((int64_t)(__A__) * (__B__)) >> 28))
+
+/* Private variables ---------------------------------------------------------*/
+/* Private function prototypes -----------------------------------------------*/
+static float   AHRS_InvSqrt(float x);
+static int32_t AHRS_QRsqrt(uint32_t m);
+static int32_t AHRS_QNormalize(const int32_t *pIn, int32_t *pOut, uint32_t n);
+static int32_t AHRS_QNorm2(int32_t x, int32_t y);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Reset the Madgwick filter to the identity orientation.
+  * @param  hahrs: filter handle
+  * @param  SampleFreq: update rate in Hz (gyro ODR)
+  * @param  Beta: gradient descent gain, AHRS_MADGWICK_BETA by default
+  * @retval None
+  */
+void AHRS_MadgwickInit(AHRS_MadgwickTypeDef *hahrs, float SampleFreq, float Beta)
+{
+  hahrs->Q[0] = 1.0f;
+  hahrs->Q[1] = 0.0f;
+  hahrs->Q[2] = 0.0f;
+  hahrs->Q[3] = 0.0f;
+  hahrs->Beta = Beta;
+  hahrs->SamplePeriod = 1.0f / SampleFreq;
+}
+
+/**
+  * @brief  One Madgwick update step.
+  * @param  hahrs: filter handle
+  * @param  pGyro: angular rate X, Y, Z in rad/s
+  * @param  pAcc: acceleration X, Y, Z, any unit, NULL to integrate the gyro only
+  * @param  pMag: magnetic field X, Y, Z, any unit, NULL for the IMU variant
+  * @retval None
+  */
+__RAMFUNC void AHRS_MadgwickUpdate(AHRS_MadgwickTypeDef *hahrs, const float *pGyro, const float *pAcc, const float *pMag)
+{
+  float q0 = hahrs->Q[0], q1 = hahrs->Q[1], q2 = hahrs->Q[2], q3 = hahrs->Q[3];
+  float gx = pGyro[0], gy = pGyro[1], gz = pGyro[2];
+  float ax, ay, az, mx, my, mz;
+  float s0, s1, s2, s3;
+  float qDot0, qDot1, qDot2, qDot3;
+  float recipNorm;
+
+  /* Rate of change of quaternion from gyroscope */
+  qDot0 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+  qDot1 = 0.5f * ( q0 * gx + q2 * gz - q3 * gy);
+  qDot2 = 0.5f * ( q0 * gy - q1 * gz + q3 * gx);
+  qDot3 = 0.5f * ( q0 * gz + q1 * gy - q2 * gx);
+
+  if((pAcc != 0) && !((pAcc[0] == 0.0f) && (pAcc[1] == 0.0f) && (pAcc[2] == 0.0f)))
+  {
+    recipNorm = AHRS_InvSqrt(pAcc[0] * pAcc[0] + pAcc[1] * pAcc[1] + pAcc[2] * pAcc[2]);
+    ax = pAcc[0] * recipNorm;
+    ay = pAcc[1] * recipNorm;
+    az = pAcc[2] * recipNorm;
+
+    if((pMag != 0) && !((pMag[0] == 0.0f) && (pMag[1] == 0.0f) && (pMag[2] == 0.0f)))
+    {
+      float hx, hy, _2bx, _2bz, _4bx, _4bz;
+      float _2q0mx, _2q0my, _2q0mz, _2q1mx;
+      float _2q0, _2q1, _2q2, _2q3, _2q0q2, _2q2q3;
+      float q0q0, q0q1, q0q2, q0q3, q1q1, q1q2, q1q3, q2q2, q2q3, q3q3;
+      float ex, ey, ez, fx, fy, fz;
+
+      recipNorm = AHRS_InvSqrt(pMag[0] * pMag[0] + pMag[1] * pMag[1] + pMag[2] * pMag[2]);
+      mx = pMag[0] * recipNorm;
+      my = pMag[1] * recipNorm;
+      mz = pMag[2] * recipNorm;
+
+      _2q0mx = 2.0f * q0 * mx;
+      _2q0my = 2.0f * q0 * my;
+      _2q0mz = 2.0f * q0 * mz;
+      _2q1mx = 2.0f * q1 * mx;
+      _2q0 = 2.0f * q0;
+      _2q1 = 2.0f * q1;
+      _2q2 = 2.0f * q2;
+      _2q3 = 2.0f * q3;
+      _2q0q2 = 2.0f * q0 * q2;
+      _2q2q3 = 2.0f * q2 * q3;
+      q0q0 = q0 * q0;
+      q0q1 = q0 * q1;
+      q0q2 = q0 * q2;
+      q0q3 = q0 * q3;
+      q1q1 = q1 * q1;
+      q1q2 = q1 * q2;
+      q1q3 = q1 * q3;
+      q2q2 = q2 * q2;
+      q2q3 = q2 * q3;
+      q3q3 = q3 * q3;
+
+      /* Reference direction of Earth's magnetic field */
+      hx = mx * q0q0 - _2q0my * q3 + _2q0mz * q2 + mx * q1q1 + _2q1 * my * q2 + _2q1 * mz * q3 - mx * q2q2 - mx * q3q3;
+      hy = _2q0mx * q3 + my * q0q0 - _2q0mz * q1 + _2q1mx * q2 - my * q1q1 + my * q2q2 + _2q2 * mz * q3 - my * q3q3;
+      _2bx = sqrtf(hx * hx + hy * hy);
+      _2bz = -_2q0mx * q2 + _2q0my * q1 + mz * q0q0 + _2q1mx * q3 - mz * q1q1 + _2q2 * my * q3 - mz * q2q2 + mz * q3q3;
+      _4bx = 2.0f * _2bx;
+      _4bz = 2.0f * _2bz;
+
+      /* Objective function residuals: gravity (e) and field (f) */
+      ex = 2.0f * q1q3 - _2q0q2 - ax;
+      ey = 2.0f * q0q1 + _2q2q3 - ay;
+      ez = 1.0f - 2.0f * q1q1 - 2.0f * q2q2 - az;
+      fx = _2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx;
+      fy = _2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my;
+      fz = _2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz;
+
+      /* Gradient, transposed Jacobian times residuals */
+      s0 = -_2q2 * ex + _2q1 * ey - _2bz * q2 * fx + (-_2bx * q3 + _2bz * q1) * fy + _2bx * q2 * fz;
+      s1 = _2q3 * ex + _2q0 * ey - 4.0f * q1 * ez + _2bz * q3 * fx + (_2bx * q2 + _2bz * q0) * fy + (_2bx * q3 - _4bz * q1) * fz;
+      s2 = -_2q0 * ex + _2q3 * ey - 4.0f * q2 * ez + (-_4bx * q2 - _2bz * q0) * fx + (_2bx * q1 + _2bz * q3) * fy + (_2bx * q0 - _4bz * q2) * fz;
+      s3 = _2q1 * ex + _2q2 * ey + (-_4bx * q3 + _2bz * q1) * fx + (-_2bx * q0 + _2bz * q2) * fy + _2bx * q1 * fz;
+    }
+    else
+    {
+      float _2q0 = 2.0f * q0, _2q1 = 2.0f * q1, _2q2 = 2.0f * q2, _2q3 = 2.0f * q3;
+      float _4q0 = 4.0f * q0, _4q1 = 4.0f * q1, _4q2 = 4.0f * q2;
+      float _8q1 = 8.0f * q1, _8q2 = 8.0f * q2;
+      float q0q0 = q0 * q0, q1q1 = q1 * q1, q2q2 = q2 * q2, q3q3 = q3 * q3;
+
+      s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+      s1 = _4q1 * q3q3 - _2q3 * ax + 4.0f * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+      s2 = 4.0f * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+      s3 = 4.0f * q1q1 * q3 - _2q1 * ax + 4.0f * q2q2 * q3 - _2q2 * ay;
+    }
+
+    /* Gradient descent step, skipped when already at the minimum */
+    recipNorm = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+    if(recipNorm > 0.0f)
+    {
+      recipNorm = hahrs->Beta * AHRS_InvSqrt(recipNorm);
+      qDot0 -= s0 * recipNorm;
+      qDot1 -= s1 * recipNorm;
+      qDot2 -= s2 * recipNorm;
+      qDot3 -= s3 * recipNorm;
+    }
+  }
+
+  /* Integrate and renormalise */
+  q0 += qDot0 * hahrs->SamplePeriod;
+  q1 += qDot1 * hahrs->SamplePeriod;
+  q2 += qDot2 * hahrs->SamplePeriod;
+  q3 += qDot3 * hahrs->SamplePeriod;
+
+  recipNorm = AHRS_InvSqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+  hahrs->Q[0] = q0 * recipNorm;
+  hahrs->Q[1] = q1 * recipNorm;
+  hahrs->Q[2] = q2 * recipNorm;
+  hahrs->Q[3] = q3 * recipNorm;
+}
+
+/**
+  * @brief  Heading of the current orientation.
+  * @param  hahrs: filter handle
+  * @retval Yaw angle in radians, -pi..pi
+  */
+float AHRS_MadgwickGetYaw(const AHRS_MadgwickTypeDef *hahrs)
+{
+  const float *q = hahrs->Q;
+
+  return atan2f(2.0f * (q[1] * q[2] + q[0] * q[3]),
+                q[0] * q[0] + q[1] * q[1] - q[2] * q[2] - q[3] * q[3]);
+}
+
+/**
+  * @brief  Reset the fixed point Mahony filter to the identity orientation.
+  * @param  hahrs: filter handle
+  * @param  SampleFreq: update rate in Hz (gyro ODR)
+  * @param  TwoKp: 2 * proportional gain, Q16 (AHRS_MAHONY_TWOKP_Q16)
+  * @param  TwoKi: 2 * integral gain, Q16, 0 disables gyro bias estimation
+  * @retval None
+  */
+void AHRS_MahonyQInit(AHRS_MahonyQTypeDef *hahrs, uint32_t SampleFreq, int32_t TwoKp, int32_t TwoKi)
+{
+  hahrs->Q[0] = AHRS_Q28_ONE;
+  hahrs->Q[1] = 0;
+  hahrs->Q[2] = 0;
+  hahrs->Q[3] = 0;
+  hahrs->IntegralFB[0] = 0;
+  hahrs->IntegralFB[1] = 0;
+  hahrs->IntegralFB[2] = 0;
+  hahrs->TwoKp = TwoKp;
+  hahrs->TwoKi = TwoKi;
+  hahrs->Dt = (int32_t)((AHRS_Q28_ONE + (SampleFreq / 2U)) / SampleFreq);
+  hahrs->HalfDt = (int32_t)((Q28_HALF + (SampleFreq / 2U)) / SampleFreq);
+}
+
+/**
+  * @brief  One fixed point Mahony update step.
+  * @param  hahrs: filter handle
+  * @param  pGyro: angular rate X, Y, Z in rad/s, Q16
+  * @param  pAcc: acceleration X, Y, Z, raw or scaled, NULL to integrate the gyro only
+  * @param  pMag: magnetic field X, Y, Z, raw or scaled, NULL for the IMU variant
+  * @retval None
+  */
+__RAMFUNC void AHRS_MahonyQUpdate(AHRS_MahonyQTypeDef *hahrs, const int32_t *pGyro, const int32_t *pAcc, const int32_t *pMag)
+{
+  int32_t q0 = hahrs->Q[0], q1 = hahrs->Q[1], q2 = hahrs->Q[2], q3 = hahrs->Q[3];
+  int32_t gx = pGyro[0], gy = pGyro[1], gz = pGyro[2];
+  int32_t a[3], m[3];
+  int32_t qa, qb, qc;
+
+  if((pAcc != 0) && AHRS_QNormalize(pAcc, a, 3U))
+  {
+    int32_t q0q0 = QMUL(q0, q0), q0q1 = QMUL(q0, q1), q0q2 = QMUL(q0, q2), q0q3 = QMUL(q0, q3);
+    int32_t q1q1 = QMUL(q1, q1), q1q2 = QMUL(q1, q2), q1q3 = QMUL(q1, q3);
+    int32_t q2q2 = QMUL(q2, q2), q2q3 = QMUL(q2, q3), q3q3 = QMUL(q3, q3);
+    int32_t halfvx, halfvy, halfvz, halfex, halfey, halfez;
+
+    /* Estimated direction of gravity, error is cross product with measured */
+    halfvx = q1q3 - q0q2;
+    halfvy = q0q1 + q2q3;
+    halfvz = q0q0 - Q28_HALF + q3q3;
+    halfex = QMUL(a[1], halfvz) - QMUL(a[2], halfvy);
+    halfey = QMUL(a[2], halfvx) - QMUL(a[0], halfvz);
+    halfez = QMUL(a[0], halfvy) - QMUL(a[1], halfvx);
+
+    if((pMag != 0) && AHRS_QNormalize(pMag, m, 3U))
+    {
+      int32_t hx, hy, bx, bz, halfwx, halfwy, halfwz;
+
+      /* Reference direction of Earth's magnetic field */
+      hx = 2 * (QMUL(m[0], Q28_HALF - q2q2 - q3q3) + QMUL(m[1], q1q2 - q0q3) + QMUL(m[2], q1q3 + q0q2));
+      hy = 2 * (QMUL(m[0], q1q2 + q0q3) + QMUL(m[1], Q28_HALF - q1q1 - q3q3) + QMUL(m[2], q2q3 - q0q1));
+      bx = AHRS_QNorm2(hx, hy);
+      bz = 2 * (QMUL(m[0], q1q3 - q0q2) + QMUL(m[1], q2q3 + q0q1) + QMUL(m[2], Q28_HALF - q1q1 - q2q2));
+
+      /* Estimated direction of the field, error is cross product with measured */
+      halfwx = QMUL(bx, Q28_HALF - q2q2 - q3q3) + QMUL(bz, q1q3 - q0q2);
+      halfwy = QMUL(bx, q1q2 - q0q3) + QMUL(bz, q0q1 + q2q3);
+      halfwz = QMUL(bx, q0q2 + q1q3) + QMUL(bz, Q28_HALF - q1q1 - q2q2);
+      halfex += QMUL(m[1], halfwz) - QMUL(m[2], halfwy);
+      halfey += QMUL(m[2], halfwx) - QMUL(m[0], halfwz);
+      halfez += QMUL(m[0], halfwy) - QMUL(m[1], halfwx);
+    }
+
+    /* Integral feedback, Q16 gain x Q28 error -> Q16, times Q28 dt -> Q16 */
+    if(hahrs->TwoKi > 0)
+    {
+      hahrs->IntegralFB[0] += QMUL(QMUL(hahrs->TwoKi, halfex), hahrs->Dt);
+      hahrs->IntegralFB[1] += QMUL(QMUL(hahrs->TwoKi, halfey), hahrs->Dt);
+      hahrs->IntegralFB[2] += QMUL(QMUL(hahrs->TwoKi, halfez), hahrs->Dt);
+      gx += hahrs->IntegralFB[0];
+      gy += hahrs->IntegralFB[1];
+      gz += hahrs->IntegralFB[2];
+    }
+    else
+    {
+      hahrs->IntegralFB[0] = 0;
+      hahrs->IntegralFB[1] = 0;
+      hahrs->IntegralFB[2] = 0;
+    }
+
+    /* Proportional feedback */
+    gx += QMUL(hahrs->TwoKp, halfex);
+    gy += QMUL(hahrs->TwoKp, halfey);
+    gz += QMUL(hahrs->TwoKp, halfez);
+  }
+
+  /* Half angle increment, Q16 rad/s x Q28 s -> Q28 rad */
+  gx = (int32_t)(((int64_t)gx * hahrs->HalfDt) >> 16);
+  gy = (int32_t)(((int64_t)gy * hahrs->HalfDt) >> 16);
+  gz = (int32_t)(((int64_t)gz * hahrs->HalfDt) >> 16);
+
+  qa = q0;
+  qb = q1;
+  qc = q2;
+  q0 += -QMUL(qb, gx) - QMUL(qc, gy) - QMUL(q3, gz);
+  q1 +=  QMUL(qa, gx) + QMUL(qc, gz) - QMUL(q3, gy);
+  q2 +=  QMUL(qa, gy) - QMUL(qb, gz) + QMUL(q3, gx);
+  q3 +=  QMUL(qa, gz) + QMUL(qb, gy) - QMUL(qc, gx);
+
+  hahrs->Q[0] = q0;
+  hahrs->Q[1] = q1;
+  hahrs->Q[2] = q2;
+  hahrs->Q[3] = q3;
+  AHRS_QNormalize(hahrs->Q, hahrs->Q, 4U);
+}
+
+/**
+  * @brief  1 / sqrt(x) with the FPU (VSQRT + VDIV, 28 cycles).
+  * @param  x: positive value
+  * @retval Inverse square root
+  */
+static float AHRS_InvSqrt(float x)
+{
+  return 1.0f / sqrtf(x);
+}
+
+/**
+  * @brief  Fixed point inverse square root.
+  * @param  m: M in Q30, 0.25 <= M < 1 (2^28 <= m < 2^30)
+  * @retval 1 / sqrt(M) in Q29 (1 < result <= 2)
+  */
+static int32_t AHRS_QRsqrt(uint32_t m)
+{
+  /* Line through (0.25, 2) and (1, 1): y0 = 7/3 - 4/3 M */
+  int64_t y = ((7LL << 29) - 2LL * m) / 3;
+  int64_t yy;
+  uint32_t i;
+
+  for(i = 0; i < RSQRT_ITERATIONS; i++)
+  {
+    /* y = y * (3 - M * y^2) / 2 */
+    yy = (y * y) >> 28;
+    yy = ((int64_t)m * yy) >> 30;
+    y = (y * ((3LL << 30) - yy)) >> 31;
+  }
+
+  return (int32_t)y;
+}
+
+/**
+  * @brief  Scale a vector of any magnitude to unit length in Q28.
+  * @param  pIn: input vector
+  * @param  pOut: normalised vector (Q28), may alias pIn
+  * @param  n: number of components
+  * @retval 0 for a zero vector, pOut left untouched
+  */
+static int32_t AHRS_QNormalize(const int32_t *pIn, int32_t *pOut, uint32_t n)
+{
+  uint64_t n2 = 0;
+  int32_t msb, s, k;
+  uint32_t i, mant;
+  int32_t y;
+
+  for(i = 0; i < n; i++)
+  {
+    n2 += (uint64_t)((int64_t)pIn[i] * pIn[i]);
+  }
+  if(n2 == 0U)
+  {
+    return 0;
+  }
+
+  /* n2 = mant * 2^s with s even and mant in [2^28, 2^30) */
+  msb = 63 - __builtin_clzll(n2);
+  s = msb - 29;
+  if(s & 1)
+  {
+    s++;
+  }
+  mant = (s >= 0) ? (uint32_t)(n2 >> s) : (uint32_t)(n2 << -s);
+  y = AHRS_QRsqrt(mant);
+
+  /* out = v * y / 2^29 * 2^-(30 + s)/2 * 2^28, k >= 2 since s >= -28 */
+  k = 1 + ((30 + s) / 2);
+  for(i = 0; i < n; i++)
+  {
+    pOut[i] = (int32_t)(((int64_t)pIn[i] * y) >> k);
+  }
+
+  return 1;
+}
+
+/**
+  * @brief  Euclidean norm of a 2D Q28 vector.
+  * @param  x: first component, Q28
+  * @param  y: second component, Q28
+  * @retval sqrt(x^2 + y^2) in Q28
+  */
+static int32_t AHRS_QNorm2(int32_t x, int32_t y)
+{
+  /* The Q56 sum of squares, read as an integer, has the Q28 root as its root */
+  uint64_t n2 = (uint64_t)((int64_t)x * x) + (uint64_t)((int64_t)y * y);
+  int32_t msb, s;
+  uint32_t mant;
+  int64_t root;
+
+  if(n2 == 0U)
+  {
+    return 0;
+  }
+
+  msb = 63 - __builtin_clzll(n2);
+  s = msb - 29;
+  if(s & 1)
+  {
+    s++;
+  }
+  mant = (s >= 0) ? (uint32_t)(n2 >> s) : (uint32_t)(n2 << -s);
+
+  /* sqrt(M) = M / sqrt(M), Q30 x Q29 >> 29 -> Q30, then scale by 2^((s - 30) / 2) */
+  root = ((int64_t)mant * AHRS_QRsqrt(mant)) >> 29;
+  s = (s - 30) / 2;
+
+  return (int32_t)((s >= 0) ? (root << s) : (root >> -s));
+}
+
+/**
+  * @}
+  */
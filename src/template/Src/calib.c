@@ -0,0 +1,349 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Src/calib.c
+  * @brief   Gyroscope bias and accelerometer offset / scale calibration.
+  *
+  *          - Gyro: zero rate bias averaged with the board at rest, rejected
+  *            when the spread shows the board was moving.
+  *          - Accelerometer: six position calibration, one capture with each
+  *            axis pointing up and down gives offset and gain per axis.
+  *
+  *          Coefficients are stored in physical units so they survive a
+  *          change of full scale. CALIB_UpdateGains() folds them together
+  *          with the datasheet sensitivity of the current full scale into
+  *          one gain and offset per axis: the correction is then a single
+  *          fused multiply-add (VFMA) per axis, in place of the sensitivity
+  *          multiply the drivers do anyway.
+  *
+  *          The record is persisted in the key-value store (KV_KEY_CALIB).
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include <string.h>
+#include "calib.h"
+#include "kvstore.h"
+#include "wdog.h"
+#include "mems_drv.h"
+#include "stm32f3_discovery_gyroscope.h"
+#include "sections.h"
+
+/** @addtogroup BSP_Examples
+  * @{
+  */
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+#define CALIB_MDPS_TO_RADS    (3.14159265f / 180000.0f)
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static CALIB_DataTypeDef   CalibData;
+/* Applied to every sample, next to the fusion state in CCM-RAM */
+static CALIB_LinearTypeDef CalibGyro __CCMRAM_BSS;
+static CALIB_LinearTypeDef CalibAcc __CCMRAM_BSS;
+
+/* Mean raw reading of each captured face */
+static float   AccCapture[6][3];
+static uint8_t AccFaces;
+
+/* Private function prototypes -----------------------------------------------*/
+static void CALIB_Defaults(void);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Load the stored coefficients, or neutral ones, and compute the gains.
+  *         The sensors must be initialised, their full scale is read back.
+  * @param  None
+  * @retval HAL_ERROR if no valid record was found, defaults are in use
+  */
+HAL_StatusTypeDef CALIB_Init(void)
+{
+  HAL_StatusTypeDef status = CALIB_Load();
+
+  if(status != HAL_OK)
+  {
+    CALIB_Defaults();
+  }
+  AccFaces = 0;
+  CALIB_UpdateGains();
+
+  return status;
+}
+
+/**
+  * @brief  Recompute the per axis gain and offset, call after a full scale change.
+  * @param  None
+  * @retval None
+  */
+void CALIB_UpdateGains(void)
+{
+  float gyroSens = L3GD20_GetSensitivity() * CALIB_MDPS_TO_RADS;
+  float accSens = LSM303DLHC_AccGetSensitivity() * 0.001f;
+  uint32_t i;
+
+  for(i = 0; i < 3; i++)
+  {
+    /* rate = sens * raw - bias */
+    CalibGyro.Gain[i] = gyroSens;
+    CalibGyro.Offset[i] = -CalibData.GyroBias[i];
+
+    /* acc = scale * (sens * raw - offset) */
+    CalibAcc.Gain[i] = CalibData.AccScale[i] * accSens;
+    CalibAcc.Offset[i] = -CalibData.AccScale[i] * CalibData.AccOffset[i];
+  }
+}
+
+/**
+  * @brief  Coefficients in use.
+  * @param  None
+  * @retval Pointer to the current record
+  */
+const CALIB_DataTypeDef *CALIB_GetData(void)
+{
+  return &CalibData;
+}
+
+/**
+  * @brief  Estimate the gyroscope zero rate bias. The board must be at rest.
+  * @param  NumSamples: samples to average, CALIB_GYRO_SAMPLES by default
+  * @retval HAL_ERROR if the board moved during the measurement
+  */
+HAL_StatusTypeDef CALIB_GyroBias(uint32_t NumSamples)
+{
+  float sens = L3GD20_GetSensitivity();
+  float sum[3] = {0};
+  float sumSq[3] = {0};
+  float mean, var;
+  int16_t raw[3];
+  uint32_t n, i;
+
+  if(NumSamples < 2U)
+  {
+    return HAL_ERROR;
+  }
+
+  for(n = 0; n < NumSamples; n++)
+  {
+    while((L3GD20_GetDataStatus() & L3GD20_STATUS_ZYXDA) == 0)
+    {
+    }
+    /* Several seconds at the default rate, longer than a check-in period */
+    WDOG_CheckIn(WDOG_TASK_MAIN);
+    L3GD20_ReadXYZRaw(raw);
+    for(i = 0; i < 3; i++)
+    {
+      sum[i] += raw[i];
+      sumSq[i] += (float)raw[i] * raw[i];
+    }
+  }
+
+  for(i = 0; i < 3; i++)
+  {
+    mean = sum[i] / NumSamples;
+    var = (sumSq[i] - (sum[i] * mean)) / (NumSamples - 1U);
+    if(sqrtf(fabsf(var)) * sens > CALIB_GYRO_STILL_MDPS)
+    {
+      return HAL_ERROR;
+    }
+  }
+
+  for(i = 0; i < 3; i++)
+  {
+    CalibData.GyroBias[i] = (sum[i] / NumSamples) * sens * CALIB_MDPS_TO_RADS;
+  }
+  CALIB_UpdateGains();
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Capture one face of the six position calibration. The face is
+  *         detected from the axis that sees gravity, hold the board still
+  *         with one axis pointing straight up or down.
+  * @param  NumSamples: samples to average, CALIB_ACC_SAMPLES by default
+  * @retval HAL_ERROR if no axis is close enough to vertical
+  */
+HAL_StatusTypeDef CALIB_AccCapture(uint32_t NumSamples)
+{
+  float sens = LSM303DLHC_AccGetSensitivity() * 0.001f;
+  float mean[3] = {0};
+  int16_t raw[3];
+  uint32_t axis = 0;
+  uint32_t face;
+  uint32_t n, i;
+
+  if(NumSamples == 0U)
+  {
+    return HAL_ERROR;
+  }
+
+  for(n = 0; n < NumSamples; n++)
+  {
+    HAL_Delay(CALIB_ACC_SAMPLE_MS);
+    LSM303DLHC_AccReadXYZRaw(raw);
+    for(i = 0; i < 3; i++)
+    {
+      mean[i] += raw[i];
+    }
+  }
+
+  for(i = 0; i < 3; i++)
+  {
+    mean[i] /= NumSamples;
+    if(fabsf(mean[i]) > fabsf(mean[axis]))
+    {
+      axis = i;
+    }
+  }
+
+  if(fabsf(mean[axis] * sens) < CALIB_ACC_MIN_G)
+  {
+    return HAL_ERROR;
+  }
+  for(i = 0; i < 3; i++)
+  {
+    if((i != axis) && (fabsf(mean[i] * sens) > CALIB_ACC_MAX_TILT_G))
+    {
+      return HAL_ERROR;
+    }
+  }
+
+  face = (2U * axis) + ((mean[axis] < 0.0f) ? 1U : 0U);
+  memcpy(AccCapture[face], mean, sizeof(mean));
+  AccFaces |= (uint8_t)(1U << face);
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Faces captured so far.
+  * @param  None
+  * @retval Bit mask of CALIB_FACE_xxx, CALIB_FACE_ALL when complete
+  */
+uint8_t CALIB_AccFaces(void)
+{
+  return AccFaces;
+}
+
+/**
+  * @brief  Solve offset and scale from the six captured faces.
+  * @param  None
+  * @retval HAL_ERROR if faces are missing or the result is implausible
+  */
+HAL_StatusTypeDef CALIB_AccSolve(void)
+{
+  float sens = LSM303DLHC_AccGetSensitivity() * 0.001f;
+  float offset[3], scale[3];
+  float up, down;
+  uint32_t i;
+
+  if(AccFaces != CALIB_FACE_ALL)
+  {
+    return HAL_ERROR;
+  }
+
+  for(i = 0; i < 3; i++)
+  {
+    up = AccCapture[2U * i][i] * sens;
+    down = AccCapture[(2U * i) + 1U][i] * sens;
+
+    /* +1 g and -1 g readings: midpoint is the offset, span is 2 g */
+    offset[i] = (up + down) * 0.5f;
+    scale[i] = 2.0f / (up - down);
+    if((scale[i] < 0.8f) || (scale[i] > 1.25f))
+    {
+      return HAL_ERROR;
+    }
+  }
+
+  memcpy(CalibData.AccOffset, offset, sizeof(offset));
+  memcpy(CalibData.AccScale, scale, sizeof(scale));
+  CALIB_UpdateGains();
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Read the record from the key-value store.
+  * @param  None
+  * @retval HAL_ERROR if no compatible record is stored, current values kept
+  */
+HAL_StatusTypeDef CALIB_Load(void)
+{
+  uint16_t length;
+  const CALIB_DataTypeDef *stored = (const CALIB_DataTypeDef *)KV_GetPtr(KV_KEY_CALIB, &length);
+
+  if((stored == 0) || (length != sizeof(CALIB_DataTypeDef)) ||
+     (stored->Magic != CALIB_MAGIC) || (stored->Version != CALIB_VERSION) ||
+     (stored->Size != sizeof(CALIB_DataTypeDef)))
+  {
+    return HAL_ERROR;
+  }
+
+  memcpy(&CalibData, stored, sizeof(CalibData));
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Write the current record to the key-value store.
+  * @param  None
+  * @retval HAL status
+  */
+HAL_StatusTypeDef CALIB_Save(void)
+{
+  CalibData.Magic = CALIB_MAGIC;
+  CalibData.Version = CALIB_VERSION;
+  CalibData.Size = sizeof(CALIB_DataTypeDef);
+
+  return KV_Set(KV_KEY_CALIB, &CalibData, sizeof(CalibData));
+}
+
+/**
+  * @brief  Convert a raw gyroscope sample.
+  * @param  pRaw: X, Y, Z from L3GD20_ReadXYZRaw()
+  * @param  pRate: X, Y, Z in rad/s, bias removed
+  * @retval None
+  */
+__RAMFUNC void CALIB_GyroApply(const int16_t *pRaw, float *pRate)
+{
+  pRate[0] = fmaf(CalibGyro.Gain[0], (float)pRaw[0], CalibGyro.Offset[0]);
+  pRate[1] = fmaf(CalibGyro.Gain[1], (float)pRaw[1], CalibGyro.Offset[1]);
+  pRate[2] = fmaf(CalibGyro.Gain[2], (float)pRaw[2], CalibGyro.Offset[2]);
+}
+
+/**
+  * @brief  Convert a raw accelerometer sample.
+  * @param  pRaw: X, Y, Z from LSM303DLHC_AccReadXYZRaw()
+  * @param  pAcc: X, Y, Z in g, offset and scale corrected
+  * @retval None
+  */
+__RAMFUNC void CALIB_AccApply(const int16_t *pRaw, float *pAcc)
+{
+  pAcc[0] = fmaf(CalibAcc.Gain[0], (float)pRaw[0], CalibAcc.Offset[0]);
+  pAcc[1] = fmaf(CalibAcc.Gain[1], (float)pRaw[1], CalibAcc.Offset[1]);
+  pAcc[2] = fmaf(CalibAcc.Gain[2], (float)pRaw[2], CalibAcc.Offset[2]);
+}
+
+/**
+  * @brief  Neutral coefficients: no bias, nominal sensitivity.
+  * @param  None
+  * @retval None
+  */
+static void CALIB_Defaults(void)
+{
+  uint32_t i;
+
+  memset(&CalibData, 0, sizeof(CalibData));
+  for(i = 0; i < 3; i++)
+  {
+    CalibData.AccScale[i] = 1.0f;
+  }
+}
+
+/**
+  * @}
+  */
@@ -0,0 +1,274 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Src/clock.c
+  * @brief   System clock profiles switched at run time.
+  *
+  *          A profile fixes SYSCLK, the APB dividers, the flash latency and
+  *          the USB clock. CLOCK_SetProfile() switches between them:
+  *            - registered callbacks get CLOCK_EVENT_PRE_CHANGE
+  *            - the system runs from the HSI while the PLL is reprogrammed,
+  *              the PLL cannot change while it clocks the core
+  *            - HAL_RCC_ClockConfig() raises the flash latency before
+  *              a faster clock and lowers it after a slower one, and
+  *              reloads SysTick for 1 ms at the new HCLK
+  *            - SPI1 (L3GD20) is set to the fastest prescaler under
+  *              CLOCK_GYRO_SPI_MAX_HZ
+  *            - registered callbacks get CLOCK_EVENT_POST_CHANGE
+  *
+  *          I2C1 (LSM303DLHC) is kept on the 8 MHz HSI kernel clock, which
+  *          the BSP timing is computed for: it is not affected by the
+  *          profile.
+  *
+  *          Run slowly through light load, CLOCK_PROFILE_HSI_8MHZ also
+  *          wakes from STOP without the HSE and PLL restart, and ramp up
+  *          to CLOCK_PROFILE_72MHZ for processing bursts.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "clock.h"
+
+/** @addtogroup BSP_Examples
+  * @{
+  */
+
+/* Private typedef -----------------------------------------------------------*/
+/**
+  * @brief Settings of a profile
+  */
+typedef struct
+{
+  uint32_t PllMul;      /* RCC_PLL_MULx of the 8 MHz HSE, 0 to run on the HSI */
+  uint32_t Apb1Div;     /* PCLK1 at most 36 MHz */
+  uint32_t Latency;     /* 0 up to 24 MHz, 1 up to 48 MHz, 2 up to 72 MHz */
+  uint32_t UsbClock;    /* RCC_USBCLKSOURCE_xxx giving 48 MHz */
+  uint8_t  Usb;         /* UsbClock is valid */
+} CLOCK_ConfigTypeDef;
+
+/* Private define ------------------------------------------------------------*/
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static const CLOCK_ConfigTypeDef ClockConfigs[CLOCK_PROFILE_COUNT] =
+{
+  { RCC_PLL_MUL9, RCC_HCLK_DIV2, FLASH_LATENCY_2, RCC_USBCLKSOURCE_PLL_DIV1_5, 1 },
+  { RCC_PLL_MUL6, RCC_HCLK_DIV2, FLASH_LATENCY_1, RCC_USBCLKSOURCE_PLL,       1 },
+  { RCC_PLL_MUL3, RCC_HCLK_DIV1, FLASH_LATENCY_0, 0,                          0 },
+  { 0,            RCC_HCLK_DIV1, FLASH_LATENCY_0, 0,                          0 },
+};
+
+/* Out of reset the core runs on the HSI */
+static CLOCK_ProfileTypeDef ClockProfile = CLOCK_PROFILE_HSI_8MHZ;
+static CLOCK_CallbackTypeDef ClockCallbacks[CLOCK_MAX_CALLBACKS];
+static uint32_t ClockCallbackCount;
+
+/* Private function prototypes -----------------------------------------------*/
+static HAL_StatusTypeDef CLOCK_Apply(const CLOCK_ConfigTypeDef *pConfig);
+static void              CLOCK_Notify(CLOCK_EventTypeDef Event);
+static void              CLOCK_RetuneSpi(void);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Switch to a clock profile.
+  * @note   Not from interrupt handlers. Transfers in progress must be
+  *         completed by the PRE_CHANGE callbacks.
+  * @param  Profile: CLOCK_PROFILE_xxx
+  * @retval HAL_ERROR if an oscillator fails to start, the core then runs
+  *         on the HSI
+  */
+HAL_StatusTypeDef CLOCK_SetProfile(CLOCK_ProfileTypeDef Profile)
+{
+  HAL_StatusTypeDef status;
+
+  if(Profile >= CLOCK_PROFILE_COUNT)
+  {
+    return HAL_ERROR;
+  }
+  if(Profile == ClockProfile)
+  {
+    return HAL_OK;
+  }
+
+  CLOCK_Notify(CLOCK_EVENT_PRE_CHANGE);
+
+  status = CLOCK_Apply(&ClockConfigs[Profile]);
+  ClockProfile = (status == HAL_OK) ? Profile : CLOCK_PROFILE_HSI_8MHZ;
+  CLOCK_RetuneSpi();
+
+  CLOCK_Notify(CLOCK_EVENT_POST_CHANGE);
+
+  return status;
+}
+
+/**
+  * @brief  Current clock profile.
+  * @param  None
+  * @retval CLOCK_PROFILE_xxx
+  */
+CLOCK_ProfileTypeDef CLOCK_GetProfile(void)
+{
+  return ClockProfile;
+}
+
+/**
+  * @brief  Restart the oscillators of the current profile after a STOP,
+  *         which leaves the core on the HSI with the dividers unchanged.
+  *         No callback is notified, the peripherals see the same clocks.
+  * @param  None
+  * @retval HAL_ERROR if an oscillator fails to start
+  */
+HAL_StatusTypeDef CLOCK_Restore(void)
+{
+  return CLOCK_Apply(&ClockConfigs[ClockProfile]);
+}
+
+/**
+  * @brief  Register a clock change callback, once per function.
+  * @param  Callback: called before and after every profile change
+  * @retval HAL_ERROR if CLOCK_MAX_CALLBACKS are already registered
+  */
+HAL_StatusTypeDef CLOCK_RegisterCallback(CLOCK_CallbackTypeDef Callback)
+{
+  uint32_t i;
+
+  for(i = 0; i < ClockCallbackCount; i++)
+  {
+    if(ClockCallbacks[i] == Callback)
+    {
+      return HAL_OK;
+    }
+  }
+  if(ClockCallbackCount >= CLOCK_MAX_CALLBACKS)
+  {
+    return HAL_ERROR;
+  }
+  ClockCallbacks[ClockCallbackCount++] = Callback;
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Program the oscillators, the PLL and the dividers of a profile.
+  * @param  pConfig: profile settings
+  * @retval HAL status
+  */
+static HAL_StatusTypeDef CLOCK_Apply(const CLOCK_ConfigTypeDef *pConfig)
+{
+  RCC_ClkInitTypeDef clk;
+  RCC_OscInitTypeDef osc = {0};
+  RCC_PeriphCLKInitTypeDef periph = {0};
+
+  /* Leave the PLL, keeping the current latency which suits the HSI too */
+  if(__HAL_RCC_GET_SYSCLK_SOURCE() != RCC_SYSCLKSOURCE_STATUS_HSI)
+  {
+    clk.ClockType = RCC_CLOCKTYPE_SYSCLK;
+    clk.SYSCLKSource = RCC_SYSCLKSOURCE_HSI;
+    if(HAL_RCC_ClockConfig(&clk, __HAL_FLASH_GET_LATENCY()) != HAL_OK)
+    {
+      return HAL_ERROR;
+    }
+  }
+
+  if(pConfig->PllMul != 0U)
+  {
+    osc.OscillatorType = RCC_OSCILLATORTYPE_HSE;
+    osc.HSEState = RCC_HSE_ON;
+    osc.HSEPredivValue = RCC_HSE_PREDIV_DIV1;
+    osc.PLL.PLLState = RCC_PLL_ON;
+    osc.PLL.PLLSource = RCC_PLLSOURCE_HSE;
+    osc.PLL.PLLMUL = pConfig->PllMul;
+    if(HAL_RCC_OscConfig(&osc) != HAL_OK)
+    {
+      return HAL_ERROR;
+    }
+  }
+  else
+  {
+    /* PLL off before its HSE input */
+    osc.OscillatorType = RCC_OSCILLATORTYPE_NONE;
+    osc.PLL.PLLState = RCC_PLL_OFF;
+    if(HAL_RCC_OscConfig(&osc) != HAL_OK)
+    {
+      return HAL_ERROR;
+    }
+    osc.OscillatorType = RCC_OSCILLATORTYPE_HSE;
+    osc.HSEState = RCC_HSE_OFF;
+    osc.PLL.PLLState = RCC_PLL_NONE;
+    if(HAL_RCC_OscConfig(&osc) != HAL_OK)
+    {
+      return HAL_ERROR;
+    }
+  }
+
+  clk.ClockType = (RCC_CLOCKTYPE_SYSCLK | RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2);
+  clk.SYSCLKSource = (pConfig->PllMul != 0U) ? RCC_SYSCLKSOURCE_PLLCLK : RCC_SYSCLKSOURCE_HSI;
+  clk.AHBCLKDivider = RCC_SYSCLK_DIV1;
+  clk.APB1CLKDivider = pConfig->Apb1Div;
+  clk.APB2CLKDivider = RCC_HCLK_DIV1;
+  if(HAL_RCC_ClockConfig(&clk, pConfig->Latency) != HAL_OK)
+  {
+    return HAL_ERROR;
+  }
+
+  periph.PeriphClockSelection = RCC_PERIPHCLK_I2C1;
+  periph.I2c1ClockSelection = RCC_I2C1CLKSOURCE_HSI;
+  if(pConfig->Usb != 0U)
+  {
+    periph.PeriphClockSelection |= RCC_PERIPHCLK_USB;
+    periph.USBClockSelection = pConfig->UsbClock;
+  }
+
+  return HAL_RCCEx_PeriphCLKConfig(&periph);
+}
+
+/**
+  * @brief  Call the registered callbacks.
+  * @param  Event: CLOCK_EVENT_PRE_CHANGE or CLOCK_EVENT_POST_CHANGE
+  * @retval None
+  */
+static void CLOCK_Notify(CLOCK_EventTypeDef Event)
+{
+  uint32_t i;
+
+  for(i = 0; i < ClockCallbackCount; i++)
+  {
+    ClockCallbacks[i](Event, ClockProfile);
+  }
+}
+
+/**
+  * @brief  Fastest SPI1 prescaler within CLOCK_GYRO_SPI_MAX_HZ of PCLK2.
+  * @note   The BSP handle of SPI1 is private to stm32f3_discovery.c, the
+  *         register is changed directly, between transfers.
+  * @param  None
+  * @retval None
+  */
+static void CLOCK_RetuneSpi(void)
+{
+  uint32_t pclk2 = HAL_RCC_GetPCLK2Freq();
+  uint32_t br = 0;
+  uint32_t cr1;
+
+  if((RCC->APB2ENR & RCC_APB2ENR_SPI1EN) == 0U)
+  {
+    return;
+  }
+
+  /* BR = n divides PCLK2 by 2^(n + 1) */
+  while(((pclk2 >> (br + 1U)) > CLOCK_GYRO_SPI_MAX_HZ) && (br < 7U))
+  {
+    br++;
+  }
+
+  while((SPI1->SR & SPI_SR_BSY) != 0U)
+  {
+  }
+  cr1 = SPI1->CR1;
+  SPI1->CR1 = cr1 & ~SPI_CR1_SPE;
+  SPI1->CR1 = (cr1 & ~(SPI_CR1_SPE | SPI_CR1_BR)) | (br * SPI_CR1_BR_0);
+  SPI1->CR1 = (cr1 & ~SPI_CR1_BR) | (br * SPI_CR1_BR_0);
+}
+
+/**
+  * @}
+  */
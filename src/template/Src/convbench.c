@@ -0,0 +1,312 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Src/convbench.c
+  * @brief   Benchmark of the sample conversion kernels of mems_conv.h
+  *          against the byte loops they replace.
+  *
+  *          Pseudo-random blocks of output registers go through both, each
+  *          conversion timed over CONVBENCH_SAMPLES samples with the clock
+  *          of the caller:
+  *            - target: CONV demo (mems.c), DWT->CYCCNT, CPU cycles. Read
+  *              ConvBenchResult with the debugger
+  *            - host: build/host/convbench (make host), nanoseconds
+  *          Conversions:
+  *            - little-endian and big-endian: the shift and add loops of
+  *              l3gd20.c, branching on a CTRL_REG4 copy, against the
+  *              halfword copy and REV16
+  *            - rad/s in Q16 at 500 dps: the 64-bit multiply of the host
+  *              Mahony input against SMULBB / SMULTT with a 16-bit gain
+  *            - IMUC_Encode() of imucodec.c on a block of 64 frames of 9
+  *              channels, sensor noise of +/-8 LSB around fixed levels.
+  *              Encode is the time of the whole block, divide by
+  *              CONVBENCH_CODEC_SAMPLES for the cost per sample
+  *          Decoded samples must match exactly, scaled ones within the
+  *          rounding of the 16-bit gain, the codec block must decode back
+  *          to its input; others count in Mismatches.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdlib.h>
+#include "convbench.h"
+#include "mems_conv.h"
+#include "imucodec.h"
+
+/** @addtogroup BSP_Examples
+  * @{
+  */
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/* CTRL_REG4 BLE bit, big-endian output registers */
+#define CONVBENCH_BLE_MSB     0x40U
+
+/* rad/s in Q16 per LSB at 500 dps (17.50 mdps) */
+#define CONVBENCH_RADS_Q16    (17.50e-3 * (3.14159265358979 / 180.0) * 65536.0)
+#define CONVBENCH_GAIN_Q32    ((int64_t)((CONVBENCH_RADS_Q16 * 65536.0) + 0.5))
+#define CONVBENCH_SHIFT       10U
+#define CONVBENCH_GAIN        MEMSCONV_GAIN(CONVBENCH_RADS_Q16, CONVBENCH_SHIFT)
+
+/* Half an LSB of the 16-bit gain over the full input range, plus flooring */
+#define CONVBENCH_Q_TOLERANCE ((0x8000 >> (CONVBENCH_SHIFT + 1U)) + 1)
+
+/* Seed of the codec block, regenerated to check the decoded block */
+#define CONVBENCH_CODEC_SEED  7U
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Output registers, CTRL_REG4 as the drivers read it */
+static uint8_t ConvBenchRegs[CONVBENCH_BLOCKS][6];
+static volatile uint8_t ConvBenchCtrl4;
+
+/* [0]: loops, [1]: kernels */
+static int16_t ConvBenchRaw[2][CONVBENCH_BLOCKS][3];
+static int32_t ConvBenchQ[2][CONVBENCH_BLOCKS][3];
+
+/* Codec block, decoded back in place for the check */
+static int16_t ConvBenchFrames[CONVBENCH_CODEC_FRAMES * CONVBENCH_CODEC_CHANNELS];
+static uint8_t ConvBenchCode[IMUC_MAX_SIZE(CONVBENCH_CODEC_FRAMES, CONVBENCH_CODEC_CHANNELS)];
+
+static CONVBENCH_ResultTypeDef ConvBenchResult;
+
+/* Private function prototypes -----------------------------------------------*/
+static void     CONVBENCH_LoopDecode(void);
+static void     CONVBENCH_KernelDecode(void);
+static void     CONVBENCH_LoopScale(void);
+static void     CONVBENCH_KernelScale(void);
+static uint32_t CONVBENCH_Time(uint32_t (*Clock)(void), void (*Convert)(void));
+static uint32_t CONVBENCH_Compare(int32_t Tolerance);
+static void     CONVBENCH_Encode(void);
+static uint32_t CONVBENCH_CodecFill(int16_t *pFrames, uint32_t Check);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Time every conversion, little-endian then big-endian.
+  * @param  Clock: free running counter, e.g. DWT->CYCCNT
+  * @retval Times and mismatches
+  */
+const CONVBENCH_ResultTypeDef *CONVBENCH_Run(uint32_t (*Clock)(void))
+{
+  uint32_t seed = 1U;
+  uint32_t n, i;
+
+  for(n = 0; n < CONVBENCH_BLOCKS; n++)
+  {
+    for(i = 0; i < 6U; i++)
+    {
+      seed = (seed * 1664525U) + 1013904223U;
+      ConvBenchRegs[n][i] = (uint8_t)(seed >> 24);
+    }
+  }
+  ConvBenchResult.Mismatches = 0;
+
+  ConvBenchCtrl4 = 0;
+  ConvBenchResult.LoopLe = CONVBENCH_Time(Clock, CONVBENCH_LoopDecode);
+  ConvBenchResult.KernelLe = CONVBENCH_Time(Clock, CONVBENCH_KernelDecode);
+  ConvBenchResult.Mismatches += CONVBENCH_Compare(-1);
+
+  ConvBenchCtrl4 = CONVBENCH_BLE_MSB;
+  ConvBenchResult.LoopBe = CONVBENCH_Time(Clock, CONVBENCH_LoopDecode);
+  ConvBenchResult.KernelBe = CONVBENCH_Time(Clock, CONVBENCH_KernelDecode);
+  ConvBenchResult.Mismatches += CONVBENCH_Compare(-1);
+
+  ConvBenchResult.LoopScale = CONVBENCH_Time(Clock, CONVBENCH_LoopScale);
+  ConvBenchResult.KernelScale = CONVBENCH_Time(Clock, CONVBENCH_KernelScale);
+  ConvBenchResult.Mismatches += CONVBENCH_Compare(CONVBENCH_Q_TOLERANCE);
+
+  CONVBENCH_CodecFill(ConvBenchFrames, 0);
+  ConvBenchResult.Encode = CONVBENCH_Time(Clock, CONVBENCH_Encode);
+  if(IMUC_Decode(ConvBenchCode, ConvBenchResult.EncodedSize, CONVBENCH_CODEC_FRAMES,
+                 CONVBENCH_CODEC_CHANNELS, ConvBenchFrames) != ConvBenchResult.EncodedSize)
+  {
+    ConvBenchResult.Mismatches += CONVBENCH_CODEC_FRAMES * CONVBENCH_CODEC_CHANNELS;
+  }
+  else
+  {
+    ConvBenchResult.Mismatches += CONVBENCH_CodecFill(ConvBenchFrames, 1);
+  }
+
+  return &ConvBenchResult;
+}
+
+/**
+  * @brief  Byte loops of l3gd20.c before mems_conv.h.
+  * @param  None
+  * @retval None
+  */
+static void CONVBENCH_LoopDecode(void)
+{
+  const uint8_t *buffer;
+  int16_t *data;
+  uint32_t n, i;
+
+  for(n = 0; n < CONVBENCH_BLOCKS; n++)
+  {
+    buffer = ConvBenchRegs[n];
+    data = ConvBenchRaw[0][n];
+    if(!(ConvBenchCtrl4 & CONVBENCH_BLE_MSB))
+    {
+      for(i = 0; i < 3U; i++)
+      {
+        data[i] = (int16_t)(((uint16_t)buffer[(2U * i) + 1U] << 8) + buffer[2U * i]);
+      }
+    }
+    else
+    {
+      for(i = 0; i < 3U; i++)
+      {
+        data[i] = (int16_t)(((uint16_t)buffer[2U * i] << 8) + buffer[(2U * i) + 1U]);
+      }
+    }
+  }
+}
+
+/**
+  * @brief  Halfword kernels, as the drivers use them now.
+  * @param  None
+  * @retval None
+  */
+static void CONVBENCH_KernelDecode(void)
+{
+  uint32_t n;
+
+  for(n = 0; n < CONVBENCH_BLOCKS; n++)
+  {
+    if(!(ConvBenchCtrl4 & CONVBENCH_BLE_MSB))
+    {
+      MEMSCONV_Le(ConvBenchRegs[n], ConvBenchRaw[1][n]);
+    }
+    else
+    {
+      MEMSCONV_Be(ConvBenchRegs[n], ConvBenchRaw[1][n]);
+    }
+  }
+}
+
+/**
+  * @brief  64-bit multiply per axis, as the host Mahony input before.
+  * @param  None
+  * @retval None
+  */
+static void CONVBENCH_LoopScale(void)
+{
+  uint32_t n, i;
+
+  for(n = 0; n < CONVBENCH_BLOCKS; n++)
+  {
+    for(i = 0; i < 3U; i++)
+    {
+      ConvBenchQ[0][n][i] = (int32_t)((ConvBenchRaw[0][n][i] * CONVBENCH_GAIN_Q32) >> 16);
+    }
+  }
+}
+
+/**
+  * @brief  Halfword multiplies on the packed samples.
+  * @param  None
+  * @retval None
+  */
+static void CONVBENCH_KernelScale(void)
+{
+  uint32_t n;
+
+  for(n = 0; n < CONVBENCH_BLOCKS; n++)
+  {
+    MEMSCONV_ScaleQ(ConvBenchRaw[1][n], CONVBENCH_GAIN, CONVBENCH_SHIFT, ConvBenchQ[1][n]);
+  }
+}
+
+/**
+  * @brief  Encode the codec block, as flashlog.c does for each FLASH block.
+  * @param  None
+  * @retval None
+  */
+static void CONVBENCH_Encode(void)
+{
+  ConvBenchResult.EncodedSize = IMUC_Encode(ConvBenchFrames, CONVBENCH_CODEC_FRAMES,
+                                            CONVBENCH_CODEC_CHANNELS, ConvBenchCode);
+}
+
+/**
+  * @brief  Generate the codec block, or compare a block against it.
+  * @param  pFrames: CONVBENCH_CODEC_FRAMES frames of CONVBENCH_CODEC_CHANNELS
+  * @param  Check: 0 to fill pFrames, 1 to compare pFrames with the block
+  * @retval Samples differing from the block, 0 when filling
+  */
+static uint32_t CONVBENCH_CodecFill(int16_t *pFrames, uint32_t Check)
+{
+  uint32_t seed = CONVBENCH_CODEC_SEED;
+  uint32_t count = 0;
+  uint32_t n, c;
+  int16_t sample;
+
+  for(n = 0; n < CONVBENCH_CODEC_FRAMES; n++)
+  {
+    for(c = 0; c < CONVBENCH_CODEC_CHANNELS; c++)
+    {
+      seed = (seed * 1664525U) + 1013904223U;
+      sample = (int16_t)((((int32_t)c - 4) * 1000) + (int32_t)(seed >> 28) - 8);
+      if(Check == 0U)
+      {
+        *pFrames = sample;
+      }
+      else
+      {
+        count += (*pFrames != sample) ? 1U : 0U;
+      }
+      pFrames++;
+    }
+  }
+  return count;
+}
+
+/**
+  * @brief  Run a conversion over all blocks CONVBENCH_PASSES times.
+  * @param  Clock: free running counter
+  * @param  Convert: conversion of all blocks
+  * @retval Elapsed clock ticks
+  */
+static uint32_t CONVBENCH_Time(uint32_t (*Clock)(void), void (*Convert)(void))
+{
+  uint32_t start = Clock();
+  uint32_t pass;
+
+  for(pass = 0; pass < CONVBENCH_PASSES; pass++)
+  {
+    Convert();
+  }
+  return Clock() - start;
+}
+
+/**
+  * @brief  Count kernel results differing from the loop results.
+  * @param  Tolerance: -1 to compare the decoded samples exactly, otherwise
+  *         the largest difference allowed between the scaled samples
+  * @retval Samples out of tolerance
+  */
+static uint32_t CONVBENCH_Compare(int32_t Tolerance)
+{
+  uint32_t count = 0;
+  uint32_t n, i;
+
+  for(n = 0; n < CONVBENCH_BLOCKS; n++)
+  {
+    for(i = 0; i < 3U; i++)
+    {
+      if(Tolerance < 0)
+      {
+        count += (ConvBenchRaw[0][n][i] != ConvBenchRaw[1][n][i]) ? 1U : 0U;
+      }
+      else
+      {
+        count += (abs(ConvBenchQ[0][n][i] - ConvBenchQ[1][n][i]) > Tolerance) ? 1U : 0U;
+      }
+    }
+  }
+  return count;
+}
+
+/**
+  * @}
+  */
@@ -0,0 +1,69 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Src/crc32.c
+  * @brief   CRC-32 on the CRC calculation unit.
+  *
+  *          Configured for the IEEE 802.3 / zlib CRC-32 (reflected input and
+  *          output, final XOR), so records written by the firmware can be
+  *          checked on the host with zlib.crc32() / binascii.crc32().
+  *
+  *          The unit holds a single running computation: call from thread
+  *          context only, not from interrupt handlers.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "crc32.h"
+
+/** @addtogroup BSP_Examples
+  * @{
+  */
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static CRC_HandleTypeDef CrcHandle;
+
+/* Private function prototypes -----------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  CRC-32 of a byte buffer.
+  * @param  pData: data
+  * @param  Length: size in bytes
+  * @retval CRC-32, same value as zlib crc32(0, pData, Length)
+  */
+uint32_t CRC32_Calc(const void *pData, uint32_t Length)
+{
+  if(CrcHandle.Instance == 0)
+  {
+    __HAL_RCC_CRC_CLK_ENABLE();
+
+    CrcHandle.Instance = CRC;
+    CrcHandle.Init.DefaultPolynomialUse = DEFAULT_POLYNOMIAL_ENABLE;
+    CrcHandle.Init.DefaultInitValueUse = DEFAULT_INIT_VALUE_ENABLE;
+    CrcHandle.Init.InputDataInversionMode = CRC_INPUTDATA_INVERSION_BYTE;
+    CrcHandle.Init.OutputDataInversionMode = CRC_OUTPUTDATA_INVERSION_ENABLE;
+    CrcHandle.InputDataFormat = CRC_INPUTDATA_FORMAT_BYTES;
+    HAL_CRC_Init(&CrcHandle);
+  }
+
+  return HAL_CRC_Calculate(&CrcHandle, (uint32_t *)pData, Length) ^ 0xFFFFFFFFU;
+}
+
+/**
+  * @brief  Extend the CRC of the previous CRC32_Calc() / CRC32_Accumulate()
+  *         call with more data, for records that are not contiguous in memory.
+  * @param  pData: data
+  * @param  Length: size in bytes
+  * @retval CRC-32 of all data since the last CRC32_Calc()
+  */
+uint32_t CRC32_Accumulate(const void *pData, uint32_t Length)
+{
+  return HAL_CRC_Accumulate(&CrcHandle, (uint32_t *)pData, Length) ^ 0xFFFFFFFFU;
+}
+
+/**
+  * @}
+  */
@@ -0,0 +1,148 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Src/dlog.c
+  * @brief   Deferred log: records of format id and raw arguments, formatted
+  *          on the host.
+  *
+  *          DLOG() stores no text and calls no formatter. A record is a few
+  *          words copied into a ring under a short PRIMASK section, so any
+  *          context may log:
+  *            - header: DLOG_SYNC, argument count, format id
+  *            - HAL_GetTick() in ms
+  *            - one word per argument
+  *          The format string lives in the .dlog_fmt section of the ELF,
+  *          which is never loaded: the firmware carries neither the
+  *          strings nor printf.
+  *
+  *          DLOG_Flush() hands the ring to the telemetry UART (serial.c)
+  *          from thread mode, as far as its transmit ring has room. Records
+  *          that find the ring full are dropped and reported by the next
+  *          flush as one DLOG_ID_DROPPED record.
+  *
+  *          tools/dlog_decode.py --elf build/release/main capture.bin
+  *          expands the stream; other output on the UART, such as printf,
+  *          passes through as text.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "dlog.h"
+#include "ringbuf.h"
+#include "serial.h"
+
+/** @addtogroup BSP_Examples
+  * @{
+  */
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static RING_HandleTypeDef DlogRing;
+static uint32_t           DlogBuffer[DLOG_RING_WORDS];
+static __IO uint32_t      DlogDropped;      /* Records since the last report */
+static uint32_t           DlogDroppedTotal;
+
+/* Private function prototypes -----------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Empty the record ring.
+  * @param  None
+  * @retval None
+  */
+void DLOG_Init(void)
+{
+  RING_Init(&DlogRing, DlogBuffer, sizeof(uint32_t), DLOG_RING_WORDS);
+  DlogDropped = 0;
+  DlogDroppedTotal = 0;
+}
+
+/**
+  * @brief  Queue a record built by DLOG().
+  * @param  pRecord: header with the format id, room for the tick, arguments
+  * @param  Words: record length, 2 + number of arguments
+  * @retval None
+  */
+void DLOG_Write(uint32_t *pRecord, uint32_t Words)
+{
+  uint32_t primask = __get_PRIMASK();
+  uint32_t *buffer = (uint32_t *)DlogRing.Buffer;
+  uint32_t head, i;
+
+  pRecord[0] |= (Words - 2U) << 16;
+
+  __disable_irq();
+  if(RING_Space(&DlogRing) < Words)
+  {
+    DlogDropped++;
+  }
+  else
+  {
+    pRecord[1] = HAL_GetTick();
+    head = DlogRing.Head;
+    for(i = 0; i < Words; i++)
+    {
+      buffer[(head + i) & DlogRing.Mask] = pRecord[i];
+    }
+    RING_Commit(&DlogRing, Words);
+  }
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Move queued records to the telemetry UART, never waits.
+  * @note   Thread mode only: the UART ring has a single producer. A record
+  *         may be split between two flushes, the byte stream stays whole.
+  * @param  None
+  * @retval None
+  */
+void DLOG_Flush(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  uint32_t record[3];
+  uint32_t room, count;
+  void *span;
+
+  /* Report the loss once there is room for it */
+  __disable_irq();
+  if((DlogDropped != 0U) && (RING_Space(&DlogRing) >= 3U))
+  {
+    record[0] = DLOG_HEADER(DLOG_ID_DROPPED, 0U);
+    record[2] = DlogDropped;
+    DlogDroppedTotal += DlogDropped;
+    DlogDropped = 0;
+    DLOG_Write(record, 3U);
+  }
+  __set_PRIMASK(primask);
+
+  for(;;)
+  {
+    count = RING_ReadPtr(&DlogRing, &span);
+    room = SERIAL_TxSpace() / sizeof(uint32_t);
+    if(count > room)
+    {
+      count = room;
+    }
+    if(count == 0U)
+    {
+      break;
+    }
+    SERIAL_Write(span, count * sizeof(uint32_t));
+    RING_Consume(&DlogRing, count);
+  }
+}
+
+/**
+  * @brief  Records lost to a full ring, reported by DLOG_Flush() so far.
+  * @param  None
+  * @retval Record count
+  */
+uint32_t DLOG_GetDropped(void)
+{
+  return DlogDroppedTotal;
+}
+
+/**
+  * @}
+  */
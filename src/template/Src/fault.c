@@ -0,0 +1,233 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Src/fault.c
+  * @brief   Crash dump of HardFault, MemManage, BusFault and UsageFault.
+  *
+  *          The fault handlers are naked and run FAULT_HANDLER_BODY(): it
+  *          picks the exception frame from MSP or PSP, switches to a stack
+  *          of its own, pushes r4-r11 and jumps to FAULT_Capture(). The
+  *          capture fills a __NOINIT record with:
+  *            - the stacked r0-r3, r12, lr, pc, xpsr and r4-r11
+  *            - the stack pointer before the exception, allowing for an
+  *              extended FPU frame and the 8-byte alignment padding
+  *            - CFSR, HFSR, MMFAR, BFAR and AFSR
+  *            - FAULT_STACK_WORDS words of stack above it
+  *          and resets the device with NVIC_SystemReset(), logged as a
+  *          software reset by the watchdog module. Pointers are checked
+  *          against SRAM and CCM RAM before they are read, so that a
+  *          corrupt stack pointer does not fault the capture again.
+  *
+  *          At the next boot FAULT_Init() moves a valid record to the
+  *          key-value store (KV_KEY_FAULT), where it stays until the next
+  *          fault. tools/crashdump.py decodes and symbolizes it from a
+  *          store dump ("make crashdump").
+  *
+  *          The CRC unit is not used in the fault path, the record is
+  *          checked with a plain XOR of its words.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "fault.h"
+#include "kvstore.h"
+#include "sections.h"
+
+/** @addtogroup BSP_Examples
+  * @{
+  */
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/* STM32F303VC memories */
+#define FAULT_SRAM_SIZE       0xA000U
+#define FAULT_CCM_SIZE        0x2000U
+
+#define FAULT_RECORD_WORDS    (sizeof(FAULT_RecordTypeDef) / 4U)
+
+/* EXC_RETURN bit 4 clear: the frame holds the FPU registers */
+#define FAULT_EXC_RETURN_FTYPE  0x10U
+#define FAULT_FRAME_WORDS       8U
+#define FAULT_FRAME_FP_WORDS    26U
+
+/* xPSR bit 9: the frame was aligned to 8 bytes with one word of padding */
+#define FAULT_XPSR_STKALIGN     (1U << 9)
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Stack of FAULT_Capture(), referenced from FAULT_HANDLER_BODY() */
+uint32_t FaultStack[FAULT_HANDLER_STACK / 4] __attribute__((used, externally_visible, aligned(8)));
+
+static FAULT_RecordTypeDef FaultRecord __NOINIT;
+static FAULT_RecordTypeDef FaultLast;
+static uint8_t             FaultLastValid;
+static uint8_t             FaultNew;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint8_t  FAULT_IsRam(uint32_t Address, uint32_t Size);
+static uint32_t FAULT_Xor(const FAULT_RecordTypeDef *pRecord);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Enable the configurable fault handlers and keep the dump of a
+  *         fault that caused the last reset.
+  * @note   Call after KV_Init().
+  * @param  None
+  * @retval None
+  */
+void FAULT_Init(void)
+{
+  /* MemManage, BusFault and UsageFault have their own handler instead of
+     escalating to HardFault, the dump tells them apart */
+  SCB->SHCSR |= SCB_SHCSR_USGFAULTENA_Msk | SCB_SHCSR_BUSFAULTENA_Msk |
+                SCB_SHCSR_MEMFAULTENA_Msk;
+
+  FaultNew = 0;
+  if((FaultRecord.Magic == FAULT_MAGIC) && (FaultRecord.Version == FAULT_VERSION) &&
+     (FaultRecord.StackWords <= FAULT_STACK_WORDS) && (FAULT_Xor(&FaultRecord) == 0U))
+  {
+    KV_Set(KV_KEY_FAULT, &FaultRecord, sizeof(FaultRecord));
+    FaultNew = 1;
+  }
+  FaultRecord.Magic = 0;
+
+  FaultLastValid = 0;
+  if(KV_Get(KV_KEY_FAULT, &FaultLast, sizeof(FaultLast), NULL) == HAL_OK)
+  {
+    FaultLastValid = 1;
+  }
+}
+
+/**
+  * @brief  Fill the crash dump and reset. Entered from FAULT_HANDLER_BODY()
+  *         only, on the fault stack.
+  * @param  pFrame: exception frame, as stacked on MSP or PSP
+  * @param  ExcReturn: LR on exception entry
+  * @param  pCallee: r4-r11, as pushed on the fault stack
+  * @retval None
+  */
+__attribute__((used, externally_visible)) void FAULT_Capture(uint32_t *pFrame, uint32_t ExcReturn, uint32_t *pCallee)
+{
+  FAULT_RecordTypeDef *rec = &FaultRecord;
+  uint32_t frame = (uint32_t)pFrame;
+  uint32_t sp = frame;
+  uint32_t *stack;
+  uint32_t i;
+
+  memset(rec, 0, sizeof(*rec));
+  rec->Magic = FAULT_MAGIC;
+  rec->Version = FAULT_VERSION;
+  rec->Tick = HAL_GetTick();
+  rec->ExcReturn = ExcReturn;
+  rec->Ipsr = __get_IPSR();
+
+  rec->Cfsr = SCB->CFSR;
+  rec->Hfsr = SCB->HFSR;
+  rec->Mmfar = SCB->MMFAR;
+  rec->Bfar = SCB->BFAR;
+  rec->Afsr = SCB->AFSR;
+
+  for(i = 0; i < 8U; i++)
+  {
+    rec->R[4U + i] = pCallee[i];
+  }
+
+  /* A stacking fault leaves no frame behind: keep what is readable */
+  if(FAULT_IsRam(frame, FAULT_FRAME_WORDS * 4U) != 0U)
+  {
+    rec->R[0] = pFrame[0];
+    rec->R[1] = pFrame[1];
+    rec->R[2] = pFrame[2];
+    rec->R[3] = pFrame[3];
+    rec->R[12] = pFrame[4];
+    rec->Lr = pFrame[5];
+    rec->Pc = pFrame[6];
+    rec->Xpsr = pFrame[7];
+
+    sp += (((ExcReturn & FAULT_EXC_RETURN_FTYPE) == 0U) ? FAULT_FRAME_FP_WORDS : FAULT_FRAME_WORDS) * 4U;
+    if((rec->Xpsr & FAULT_XPSR_STKALIGN) != 0U)
+    {
+      sp += 4U;
+    }
+  }
+  rec->Sp = sp;
+
+  stack = (uint32_t *)sp;
+  for(i = 0; (i < FAULT_STACK_WORDS) && (FAULT_IsRam(sp + (i * 4U), 4U) != 0U); i++)
+  {
+    rec->Stack[i] = stack[i];
+  }
+  rec->StackWords = i;
+
+  rec->Check = FAULT_Xor(rec);
+
+  /* The record is in RAM, which keeps its content over a system reset */
+  __DSB();
+  NVIC_SystemReset();
+}
+
+/**
+  * @brief  Dump of the last fault, kept in the key-value store.
+  * @param  None
+  * @retval Pointer to the dump, NULL if the device never faulted
+  */
+const FAULT_RecordTypeDef *FAULT_GetLast(void)
+{
+  return (FaultLastValid != 0U) ? &FaultLast : NULL;
+}
+
+/**
+  * @brief  Whether the last reset was caused by a fault.
+  * @param  None
+  * @retval 1 if FAULT_GetLast() was captured just before this boot, 0 otherwise
+  */
+uint8_t FAULT_IsNew(void)
+{
+  return FaultNew;
+}
+
+/**
+  * @brief  Whether a memory range lies in SRAM or CCM RAM.
+  * @param  Address: start of the range
+  * @param  Size: size in bytes
+  * @retval 1 if readable, 0 otherwise
+  */
+static uint8_t FAULT_IsRam(uint32_t Address, uint32_t Size)
+{
+  if((Address & 3U) != 0U)
+  {
+    return 0;
+  }
+  if((Address >= SRAM_BASE) && (Address <= (SRAM_BASE + FAULT_SRAM_SIZE - Size)))
+  {
+    return 1;
+  }
+  if((Address >= CCMDATARAM_BASE) && (Address <= (CCMDATARAM_BASE + FAULT_CCM_SIZE - Size)))
+  {
+    return 1;
+  }
+  return 0;
+}
+
+/**
+  * @brief  XOR of all words of a record, Check included.
+  * @param  pRecord: record
+  * @retval 0 for an intact record once Check is set
+  */
+static uint32_t FAULT_Xor(const FAULT_RecordTypeDef *pRecord)
+{
+  const uint32_t *word = (const uint32_t *)pRecord;
+  uint32_t x = 0;
+  uint32_t i;
+
+  for(i = 0; i < FAULT_RECORD_WORDS; i++)
+  {
+    x ^= word[i];
+  }
+  return x;
+}
+
+/**
+  * @}
+  */
@@ -0,0 +1,353 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Src/filter.c
+  * @brief   Block based q15 filter pipeline on CMSIS-DSP.
+  *
+  *          A pipeline is a chain of biquad IIR, FIR, moving average and
+  *          decimation stages applied to one sensor channel. Each call runs
+  *          a block of up to BlockSize samples through every stage,
+  *          ping-ponging between the caller's output buffer and a scratch
+  *          block.
+  *
+  *          Biquad, FIR and decimation use the CMSIS "fast" q15 kernels: the
+  *          Cortex-M4 SIMD MACs (SMLAD/SMLALD) process two samples or taps
+  *          per instruction from packed 32-bit loads, and the state copy and
+  *          loop setup are paid once per block instead of once per sample.
+  *          filterbench.c times a pipeline fed by blocks against the same
+  *          pipeline fed sample by sample, in CPU cycles (CONV demo).
+  *
+  *          The fast kernels use 32-bit accumulators: scale the input or the
+  *          coefficients so that intermediate sums stay within q15 range.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include "filter.h"
+
+/** @addtogroup BSP_Examples
+  * @{
+  */
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Private function prototypes -----------------------------------------------*/
+static void FILTER_MovAvg(FILTER_MovAvgTypeDef *havg, const q15_t *pSrc, q15_t *pDst, uint32_t Count);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Initialise a biquad cascade stage.
+  * @param  hstage: stage to initialise
+  * @param  NumSections: number of second order sections
+  * @param  pCoeffs: {b0, 0, b1, b2, a1, a2} per section, scaled by 2^-PostShift,
+  *         FILTER_BIQUAD_COEFF_SIZE(NumSections) elements
+  * @param  pState: FILTER_BIQUAD_STATE_SIZE(NumSections) elements
+  * @param  PostShift: coefficient scaling, 1 for coefficients in [-2, 2)
+  * @retval HAL_OK
+  */
+HAL_StatusTypeDef FILTER_InitBiquad(FILTER_StageTypeDef *hstage, uint8_t NumSections, q15_t *pCoeffs, q15_t *pState, int8_t PostShift)
+{
+  hstage->Kind = FILTER_STAGE_BIQUAD;
+  arm_biquad_cascade_df1_init_q15(&hstage->Inst.Biquad, NumSections, pCoeffs, pState, PostShift);
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Initialise a FIR stage.
+  * @param  hstage: stage to initialise
+  * @param  NumTaps: filter length, even and >= 4
+  * @param  pCoeffs: coefficients in time reversed order
+  * @param  pState: FILTER_FIR_STATE_SIZE(NumTaps, BlockSize) elements
+  * @param  BlockSize: largest block this stage will be given
+  * @retval HAL_ERROR if NumTaps is not supported by the fast kernel
+  */
+HAL_StatusTypeDef FILTER_InitFir(FILTER_StageTypeDef *hstage, uint16_t NumTaps, q15_t *pCoeffs, q15_t *pState, uint32_t BlockSize)
+{
+  hstage->Kind = FILTER_STAGE_FIR;
+  if(arm_fir_init_q15(&hstage->Inst.Fir, NumTaps, pCoeffs, pState, BlockSize) != ARM_MATH_SUCCESS)
+  {
+    return HAL_ERROR;
+  }
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Initialise a decimation stage (anti-alias FIR, keep every Factor-th sample).
+  * @param  hstage: stage to initialise
+  * @param  NumTaps: anti-alias filter length
+  * @param  Factor: decimation factor M
+  * @param  pCoeffs: coefficients in time reversed order
+  * @param  pState: FILTER_DECIMATE_STATE_SIZE(NumTaps, BlockSize) elements
+  * @param  BlockSize: input block of this stage, multiple of Factor
+  * @retval HAL_ERROR if BlockSize is not a multiple of Factor
+  */
+HAL_StatusTypeDef FILTER_InitDecimate(FILTER_StageTypeDef *hstage, uint16_t NumTaps, uint8_t Factor, q15_t *pCoeffs, q15_t *pState, uint32_t BlockSize)
+{
+  hstage->Kind = FILTER_STAGE_DECIMATE;
+  if(arm_fir_decimate_init_q15(&hstage->Inst.Decimate, NumTaps, Factor, pCoeffs, pState, BlockSize) != ARM_MATH_SUCCESS)
+  {
+    return HAL_ERROR;
+  }
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Initialise a moving average stage.
+  * @param  hstage: stage to initialise
+  * @param  Length: window length, power of two up to 2^15
+  * @param  pHistory: Length elements
+  * @retval HAL_ERROR if Length is not a power of two
+  */
+HAL_StatusTypeDef FILTER_InitMovAvg(FILTER_StageTypeDef *hstage, uint16_t Length, q15_t *pHistory)
+{
+  FILTER_MovAvgTypeDef *havg = &hstage->Inst.MovAvg;
+
+  if((Length == 0U) || ((Length & (Length - 1U)) != 0U) || (Length > 0x8000U))
+  {
+    return HAL_ERROR;
+  }
+
+  hstage->Kind = FILTER_STAGE_MOVAVG;
+  havg->pHistory = pHistory;
+  havg->Length = Length;
+  havg->Index = 0;
+  havg->Shift = (uint8_t)(31U - __CLZ(Length));
+  havg->Sum = 0;
+  arm_fill_q15(0, pHistory, Length);
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Second order Butterworth style lowpass (RBJ cookbook) as one biquad section.
+  *         The coefficient scaling is the smallest that holds every
+  *         coefficient in q15: a1 approaches 2 at low cut-off frequencies.
+  *         A design that quantisation detunes is rejected, both must stay
+  *         within FILTER_DC_GAIN_TOLERANCE:
+  *           - the DC gain of the q15 coefficients, off 1 (fails as well
+  *             when the pole reaches the unit circle)
+  *           - the output truncation of the fast kernel, one LSB per
+  *             sample amplified by the feedback, against full scale
+  * @param  pCoeffs: FILTER_BIQUAD_COEFF_SIZE(1) elements
+  * @param  Fc: cut-off frequency in Hz, below Fs / 2
+  * @param  Fs: sample rate in Hz
+  * @param  Q: quality factor, 0.7071 for Butterworth
+  * @param  pPostShift: set to the coefficient scaling to pass to FILTER_InitBiquad()
+  * @retval HAL_ERROR if the parameters are out of range or the q15 design
+  *         is detuned, Fc too low for the sample rate
+  */
+HAL_StatusTypeDef FILTER_DesignLowpass(q15_t *pCoeffs, float Fc, float Fs, float Q, int8_t *pPostShift)
+{
+  float w0, cosw0, alpha, scale;
+  float coeffs[5];
+  int32_t quant[5];
+  int32_t num, den;
+  int8_t shift;
+  uint32_t i;
+
+  if((Fc <= 0.0f) || (Fc >= (0.5f * Fs)) || (Q <= 0.0f))
+  {
+    return HAL_ERROR;
+  }
+
+  w0 = 2.0f * PI * Fc / Fs;
+  cosw0 = cosf(w0);
+  alpha = sinf(w0) / (2.0f * Q);
+
+  /* b0, b1, b2, a1, a2 normalised by a0. CMSIS sign convention:
+     y = b0 x0 + b1 x1 + b2 x2 + a1 y1 + a2 y2 */
+  coeffs[0] = ((1.0f - cosw0) * 0.5f) / (1.0f + alpha);
+  coeffs[1] = 2.0f * coeffs[0];
+  coeffs[2] = coeffs[0];
+  coeffs[3] = (2.0f * cosw0) / (1.0f + alpha);
+  coeffs[4] = -(1.0f - alpha) / (1.0f + alpha);
+
+  for(shift = 0; shift < 15; shift++)
+  {
+    scale = (float)(1UL << (15 - shift));
+    for(i = 0; i < 5U; i++)
+    {
+      quant[i] = (int32_t)lroundf(coeffs[i] * scale);
+      if((quant[i] > 32767) || (quant[i] < -32768))
+      {
+        break;
+      }
+    }
+    if(i == 5U)
+    {
+      break;
+    }
+  }
+
+  /* DC gain of the quantised filter sum(b) / (1 - a1 - a2), and the DC
+     gain 1 / (1 - a1 - a2) the truncated output sees */
+  num = quant[0] + quant[1] + quant[2];
+  den = (int32_t)(1UL << (15 - shift)) - quant[3] - quant[4];
+  if((shift == 15) || (den <= 0) ||
+     (fabsf(((float)num / (float)den) - 1.0f) > FILTER_DC_GAIN_TOLERANCE) ||
+     ((float)(1UL << (15 - shift)) > (FILTER_DC_GAIN_TOLERANCE * 32768.0f * (float)den)))
+  {
+    return HAL_ERROR;
+  }
+
+  pCoeffs[0] = (q15_t)quant[0];
+  pCoeffs[1] = 0;
+  pCoeffs[2] = (q15_t)quant[1];
+  pCoeffs[3] = (q15_t)quant[2];
+  pCoeffs[4] = (q15_t)quant[3];
+  pCoeffs[5] = (q15_t)quant[4];
+  *pPostShift = shift;
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Assemble initialised stages into a pipeline.
+  * @param  hpipe: pipeline handle
+  * @param  pStages: stages in processing order
+  * @param  NumStages: number of stages
+  * @param  BlockSize: input samples per FILTER_Process() call
+  * @param  pScratch: BlockSize elements, needed when NumStages > 1
+  * @retval HAL_ERROR if a decimation stage does not divide the block it receives
+  */
+HAL_StatusTypeDef FILTER_PipelineInit(FILTER_PipelineTypeDef *hpipe, FILTER_StageTypeDef *pStages, uint32_t NumStages, uint32_t BlockSize, q15_t *pScratch)
+{
+  uint32_t block = BlockSize;
+  uint32_t decimation = 1;
+  uint32_t i;
+
+  if((NumStages == 0U) || ((NumStages > 1U) && (pScratch == 0)))
+  {
+    return HAL_ERROR;
+  }
+
+  for(i = 0; i < NumStages; i++)
+  {
+    if(pStages[i].Kind == FILTER_STAGE_DECIMATE)
+    {
+      if((block % pStages[i].Inst.Decimate.M) != 0U)
+      {
+        return HAL_ERROR;
+      }
+      block /= pStages[i].Inst.Decimate.M;
+      decimation *= pStages[i].Inst.Decimate.M;
+    }
+  }
+
+  hpipe->Stages = pStages;
+  hpipe->NumStages = NumStages;
+  hpipe->BlockSize = BlockSize;
+  hpipe->Decimation = decimation;
+  hpipe->pScratch = pScratch;
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Run one input block through all stages.
+  * @param  hpipe: pipeline handle
+  * @param  pIn: Count input samples, left untouched
+  * @param  pOut: output samples, Count elements, must not alias pIn
+  * @param  Count: input samples, at most BlockSize and a multiple of the
+  *         decimation factors
+  * @retval Number of output samples (Count divided by the decimation
+  *         factors), 0 if Count is not accepted
+  */
+uint32_t FILTER_Process(FILTER_PipelineTypeDef *hpipe, q15_t *pIn, q15_t *pOut, uint32_t Count)
+{
+  uint32_t block = Count;
+  q15_t *src = pIn;
+  q15_t *dst;
+  uint32_t i;
+
+  if((Count > hpipe->BlockSize) || ((Count % hpipe->Decimation) != 0U))
+  {
+    return 0;
+  }
+
+  for(i = 0; i < hpipe->NumStages; i++)
+  {
+    FILTER_StageTypeDef *stage = &hpipe->Stages[i];
+
+    /* Alternate so that the last stage lands in pOut */
+    dst = (((hpipe->NumStages - 1U - i) & 1U) == 0U) ? pOut : hpipe->pScratch;
+
+    switch(stage->Kind)
+    {
+    case FILTER_STAGE_BIQUAD:
+      arm_biquad_cascade_df1_fast_q15(&stage->Inst.Biquad, src, dst, block);
+      break;
+    case FILTER_STAGE_FIR:
+      arm_fir_fast_q15(&stage->Inst.Fir, src, dst, block);
+      break;
+    case FILTER_STAGE_DECIMATE:
+      arm_fir_decimate_fast_q15(&stage->Inst.Decimate, src, dst, block);
+      block /= stage->Inst.Decimate.M;
+      break;
+    case FILTER_STAGE_MOVAVG:
+    default:
+      FILTER_MovAvg(&stage->Inst.MovAvg, src, dst, block);
+      break;
+    }
+    src = dst;
+  }
+
+  return block;
+}
+
+/**
+  * @brief  Split interleaved X, Y, Z samples (BSP_ACCELERO_GetXYZ layout) into channels.
+  * @param  pXYZ: Count interleaved triples
+  * @param  pX: Count X samples
+  * @param  pY: Count Y samples
+  * @param  pZ: Count Z samples
+  * @param  Count: number of triples
+  * @retval None
+  */
+void FILTER_Deinterleave(const int16_t *pXYZ, q15_t *pX, q15_t *pY, q15_t *pZ, uint32_t Count)
+{
+  while(Count--)
+  {
+    *pX++ = *pXYZ++;
+    *pY++ = *pXYZ++;
+    *pZ++ = *pXYZ++;
+  }
+}
+
+/**
+  * @brief  Moving average, running sum updated with the entering and leaving sample.
+  * @param  havg: moving average state
+  * @param  pSrc: input samples
+  * @param  pDst: output samples
+  * @param  Count: number of samples
+  * @retval None
+  */
+static void FILTER_MovAvg(FILTER_MovAvgTypeDef *havg, const q15_t *pSrc, q15_t *pDst, uint32_t Count)
+{
+  uint32_t mask = havg->Length - 1U;
+  uint32_t index = havg->Index;
+  int32_t sum = havg->Sum;
+  q15_t in;
+
+  while(Count--)
+  {
+    in = *pSrc++;
+    sum += in - havg->pHistory[index];
+    havg->pHistory[index] = in;
+    index = (index + 1U) & mask;
+    *pDst++ = (q15_t)(sum >> havg->Shift);
+  }
+
+  havg->Index = (uint16_t)index;
+  havg->Sum = sum;
+}
+
+/**
+  * @}
+  */
@@ -0,0 +1,208 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Src/filterbench.c
+  * @brief   Benchmark of the filter pipeline of filter.c, fed by blocks
+  *          against fed sample by sample.
+  *
+  *          Two identical pipelines (lowpass biquad, 8-tap FIR, moving
+  *          average of 4) filter the same pseudo-random gyro samples
+  *          FILTERBENCH_PASSES times, timed with the clock of the caller:
+  *            - FILTER_BLOCK_SIZE samples per FILTER_Process() call
+  *            - one sample per call, the cost of filtering inside a
+  *              per-sample read loop
+  *          The CONV demo (mems.c) runs it with DWT->CYCCNT, CPU cycles,
+  *          and sends the result to the deferred log. Target only: the
+  *          CMSIS-DSP kernels are not part of the host build.
+  *
+  *          The kernels carry their state across calls, both outputs must
+  *          match exactly; others count in Mismatches. A constant input
+  *          must then come out of the block pipeline unchanged once settled,
+  *          within FILTER_DC_GAIN_TOLERANCE of full scale: this checks the
+  *          q15 design of the coefficients.
+  *
+  *          Buffers are two sample blocks of mempool.c, held for the run.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "filterbench.h"
+#include "filter.h"
+#include "mempool.h"
+#include "sections.h"
+
+/** @addtogroup BSP_Examples
+  * @{
+  */
+
+/* Private typedef -----------------------------------------------------------*/
+/**
+  * @brief Pipeline under test and its storage
+  */
+typedef struct
+{
+  FILTER_PipelineTypeDef Pipe;
+  FILTER_StageTypeDef    Stages[3];
+  q15_t                  BiquadState[FILTER_BIQUAD_STATE_SIZE(1)];
+  q15_t                  FirState[FILTER_FIR_STATE_SIZE(8U, FILTER_BLOCK_SIZE)];
+  q15_t                  AvgHistory[4];
+  q15_t                  Scratch[FILTER_BLOCK_SIZE];
+} FILTERBENCH_ChainTypeDef;
+
+/* Private define ------------------------------------------------------------*/
+/* Lowpass of the biquad stage, gyroscope data rate */
+#define FILTERBENCH_FS        760.0f
+#define FILTERBENCH_FC        50.0f
+
+/* Constant input blocks before the DC output is read */
+#define FILTERBENCH_DC_BLOCKS 16U
+
+/* Input, per-sample output in the first pool block, block output in the second */
+#if ((FILTERBENCH_LENGTH * 2U * 2U) > MEMPOOL_SAMPLE_BLOCK_SIZE)
+ #error "two benchmark buffers must fit in a mempool.c sample block"
+#endif
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* [0]: sample by sample, [1]: blocks. Kernel state in CCM-RAM, as for
+   the filters of the demos */
+static FILTERBENCH_ChainTypeDef FilterBenchChain[2] __CCMRAM_BSS;
+
+static q15_t  FilterBenchBiquad[FILTER_BIQUAD_COEFF_SIZE(1)];
+static int8_t FilterBenchShift;
+
+/* Triangular window 1 2 3 4 4 3 2 1 / 20, unit DC gain. Symmetric, the
+   time reversed order CMSIS expects is the same */
+static q15_t FilterBenchFir[8] = { 1638, 3277, 4915, 6554, 6554, 4915, 3277, 1638 };
+
+static FILTERBENCH_ResultTypeDef FilterBenchResult;
+
+/* Private function prototypes -----------------------------------------------*/
+static HAL_StatusTypeDef FILTERBENCH_ChainInit(FILTERBENCH_ChainTypeDef *hchain);
+static void              FILTERBENCH_Measure(uint32_t (*Clock)(void), q15_t *pInput, q15_t *pOutput);
+static uint32_t          FILTERBENCH_Time(uint32_t (*Clock)(void), FILTERBENCH_ChainTypeDef *hchain,
+                                          q15_t *pIn, q15_t *pOut, uint32_t Count);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Time the pipeline per sample and per block, then check its output.
+  * @param  Clock: free running counter, e.g. DWT->CYCCNT
+  * @retval Times and checks, NULL if the pool or the filter design failed
+  */
+const FILTERBENCH_ResultTypeDef *FILTERBENCH_Run(uint32_t (*Clock)(void))
+{
+  q15_t *input = MEMPOOL_Alloc(&MEMPOOL_Sample);
+  q15_t *output = MEMPOOL_Alloc(&MEMPOOL_Sample);
+  const FILTERBENCH_ResultTypeDef *result = NULL;
+
+  if((input != NULL) && (output != NULL) &&
+     (FILTER_DesignLowpass(FilterBenchBiquad, FILTERBENCH_FC, FILTERBENCH_FS, 0.7071f,
+                           &FilterBenchShift) == HAL_OK) &&
+     (FILTERBENCH_ChainInit(&FilterBenchChain[0]) == HAL_OK) &&
+     (FILTERBENCH_ChainInit(&FilterBenchChain[1]) == HAL_OK))
+  {
+    FILTERBENCH_Measure(Clock, input, output);
+    result = &FilterBenchResult;
+  }
+
+  if(input != NULL)
+  {
+    MEMPOOL_Free(&MEMPOOL_Sample, input);
+  }
+  if(output != NULL)
+  {
+    MEMPOOL_Free(&MEMPOOL_Sample, output);
+  }
+  return result;
+}
+
+/**
+  * @brief  Fill FilterBenchResult with pipelines ready to run.
+  * @param  Clock: free running counter
+  * @param  pInput: sample block, input then per-sample output
+  * @param  pOutput: sample block, block output
+  * @retval None
+  */
+static void FILTERBENCH_Measure(uint32_t (*Clock)(void), q15_t *pInput, q15_t *pOutput)
+{
+  uint32_t seed = 1U;
+  uint32_t n;
+
+  /* Gyro-like samples, a quarter of full scale keeps the 32-bit sums of
+     the fast kernels in range */
+  for(n = 0; n < FILTERBENCH_LENGTH; n++)
+  {
+    seed = (seed * 1664525U) + 1013904223U;
+    pInput[n] = (q15_t)((int32_t)seed >> 18);
+  }
+
+  FilterBenchResult.PerSample = FILTERBENCH_Time(Clock, &FilterBenchChain[0], pInput,
+                                                 &pInput[FILTERBENCH_LENGTH], 1U);
+  FilterBenchResult.Block = FILTERBENCH_Time(Clock, &FilterBenchChain[1], pInput,
+                                             pOutput, FILTER_BLOCK_SIZE);
+
+  FilterBenchResult.Mismatches = 0;
+  for(n = 0; n < FILTERBENCH_LENGTH; n++)
+  {
+    FilterBenchResult.Mismatches += (pInput[FILTERBENCH_LENGTH + n] != pOutput[n]) ? 1U : 0U;
+  }
+
+  /* Step to a constant, the last output of the last block */
+  FILTERBENCH_ChainInit(&FilterBenchChain[1]);
+  for(n = 0; n < FILTER_BLOCK_SIZE; n++)
+  {
+    pInput[n] = FILTERBENCH_DC_INPUT;
+  }
+  for(n = 0; n < FILTERBENCH_DC_BLOCKS; n++)
+  {
+    FILTER_Process(&FilterBenchChain[1].Pipe, pInput, pOutput, FILTER_BLOCK_SIZE);
+  }
+  FilterBenchResult.DcOutput = pOutput[FILTER_BLOCK_SIZE - 1U];
+}
+
+/**
+  * @brief  Set up a pipeline with cleared state.
+  * @param  hchain: pipeline and storage
+  * @retval HAL status
+  */
+static HAL_StatusTypeDef FILTERBENCH_ChainInit(FILTERBENCH_ChainTypeDef *hchain)
+{
+  if((FILTER_InitBiquad(&hchain->Stages[0], 1U, FilterBenchBiquad, hchain->BiquadState,
+                        FilterBenchShift) != HAL_OK) ||
+     (FILTER_InitFir(&hchain->Stages[1], 8U, FilterBenchFir, hchain->FirState,
+                     FILTER_BLOCK_SIZE) != HAL_OK) ||
+     (FILTER_InitMovAvg(&hchain->Stages[2], 4U, hchain->AvgHistory) != HAL_OK))
+  {
+    return HAL_ERROR;
+  }
+  return FILTER_PipelineInit(&hchain->Pipe, hchain->Stages, 3U, FILTER_BLOCK_SIZE, hchain->Scratch);
+}
+
+/**
+  * @brief  Filter the input FILTERBENCH_PASSES times, Count samples per call.
+  * @param  Clock: free running counter
+  * @param  hchain: pipeline
+  * @param  pIn: FILTERBENCH_LENGTH samples
+  * @param  pOut: FILTERBENCH_LENGTH samples, output of the last pass
+  * @param  Count: samples per FILTER_Process() call, divides FILTERBENCH_LENGTH
+  * @retval Elapsed clock ticks
+  */
+static uint32_t FILTERBENCH_Time(uint32_t (*Clock)(void), FILTERBENCH_ChainTypeDef *hchain,
+                                 q15_t *pIn, q15_t *pOut, uint32_t Count)
+{
+  uint32_t start = Clock();
+  uint32_t pass, n;
+
+  for(pass = 0; pass < FILTERBENCH_PASSES; pass++)
+  {
+    for(n = 0; n < FILTERBENCH_LENGTH; n += Count)
+    {
+      FILTER_Process(&hchain->Pipe, &pIn[n], &pOut[n], Count);
+    }
+  }
+  return Clock() - start;
+}
+
+/**
+  * @}
+  */
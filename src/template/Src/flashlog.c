@@ -0,0 +1,585 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Src/flashlog.c
+  * @brief   Sensor recording to the LOG flash pages, log structured.
+  *
+  *          Frames of up to FLOG_MAX_CHANNELS int16_t samples are collected
+  *          in one of two RAM buffers by FLOG_Write(), sample blocks of
+  *          mempool.c held from FLOG_Start() to FLOG_Stop(). A full buffer becomes
+  *          one block: header, CRC-32 and imucodec.c packed payload, built in
+  *          RAM as one contiguous half-word image and then programmed
+  *          linearly, FLOG_PROGRAM_BURST half-words per FLOG_Task() call,
+  *          while the other buffer fills.
+  *
+  *          Blocks never span a page and are only appended. The pages form
+  *          a ring ordered by the block sequence number, a new session
+  *          overwrites the oldest data. FLOG_Init() locates the end of the
+  *          log after a reset, a block torn by a reset fails its CRC and is
+  *          skipped, by the firmware and by tools/flashlog_dump.py alike.
+  *
+  *          A page erase stalls every flash access for up to 40 ms, far
+  *          longer than a sample period. FLOG_Start() therefore erases the
+  *          pages ahead of the write position before recording begins, and
+  *          no erase happens while recording: the log is FULL once the
+  *          erased pages are used up. Erasing only what a session needs,
+  *          see FLOG_PagesFor(), keeps the older sessions in the rest of
+  *          the ring.
+  *
+  *          The region is outside the application image, reprogramming the
+  *          application leaves it untouched. Read it back with
+  *          "make logdump".
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <string.h>
+#include "flashlog.h"
+#include "crc32.h"
+#include "imucodec.h"
+#include "wdog.h"
+#include "mempool.h"
+
+/** @addtogroup BSP_Examples
+  * @{
+  */
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+#define FLOG_ERASED           0xFFFFFFFFU
+#define FLOG_CRC_OFFSET       offsetof(FLOG_BlockTypeDef, Seq)
+
+#if (MEMPOOL_SAMPLE_BLOCK_SIZE < FLOG_MAX_PAYLOAD)
+ #error "a mempool.c sample block must hold FLOG_BLOCK_FRAMES frames"
+#endif
+
+/* Private macro -------------------------------------------------------------*/
+#define FLOG_BLOCK_SIZE(__LEN__)  (sizeof(FLOG_BlockTypeDef) + (__LEN__))
+#define FLOG_PAGE_ADDR(__PAGE__)  (LogBase + ((__PAGE__) * FLASH_PAGE_SIZE))
+
+/* Private variables ---------------------------------------------------------*/
+/* LOG region, see default/STM32F303VCTx_FLASH.ld */
+extern uint32_t _sflashlog[];
+extern uint32_t _eflashlog[];
+
+static uint32_t LogBase;
+static uint32_t LogPages;
+static uint32_t WritePage;
+static uint32_t WriteAddr;
+static uint32_t BlankPages;     /* erased pages after WritePage */
+static uint32_t NextSeq;
+static uint16_t Session;
+static uint8_t  LogChannels;
+static uint16_t LogRate;
+static FLOG_StateTypeDef LogState = FLOG_STATE_IDLE;
+static FLOG_StatsTypeDef LogStats;
+
+/* Frame double buffer, one filling while the other is encoded. Taken from
+   MEMPOOL_Sample while recording only */
+static int16_t *FrameBuf[2];
+static uint32_t FrameTick[2];
+static uint16_t FrameCount[2];
+static uint8_t  FillBuf;
+static volatile int8_t PendingBuf = -1;
+
+/* Block being programmed, word aligned for the header, room for the
+   encoder worst case before the raw fallback */
+static uint32_t Image[(sizeof(FLOG_BlockTypeDef) + IMUC_MAX_SIZE(FLOG_BLOCK_FRAMES, FLOG_MAX_CHANNELS) + 3U) / 4U];
+static uint32_t ImageAddr;
+static uint32_t ImageLen;       /* half-words */
+static uint32_t ImagePos;       /* half-words programmed */
+
+/* Private function prototypes -----------------------------------------------*/
+static uint8_t           FLOG_BlockValid(const FLOG_BlockTypeDef *pBlock);
+static uint8_t           FLOG_Blank(uint32_t Address, uint32_t End);
+static HAL_StatusTypeDef FLOG_ErasePage(uint32_t Page);
+static void              FLOG_Encode(uint8_t Buf);
+static HAL_StatusTypeDef FLOG_Program(void);
+static void              FLOG_FreeBuffers(void);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Scan the LOG pages and locate the end of the log.
+  * @param  None
+  * @retval HAL status
+  */
+HAL_StatusTypeDef FLOG_Init(void)
+{
+  const FLOG_BlockTypeDef *block;
+  uint32_t page, addr, end;
+  uint32_t lastSeq = 0;
+  uint32_t lastEnd = 0;
+  uint8_t found = 0;
+
+  LogBase = (uint32_t)_sflashlog;
+  LogPages = ((uint32_t)_eflashlog - LogBase) / FLASH_PAGE_SIZE;
+  if(LogPages < 2U)
+  {
+    return HAL_ERROR;
+  }
+
+  Session = 0;
+  for(page = 0; page < LogPages; page++)
+  {
+    addr = FLOG_PAGE_ADDR(page);
+    end = addr + FLASH_PAGE_SIZE;
+    while((addr + sizeof(FLOG_BlockTypeDef)) <= end)
+    {
+      block = (const FLOG_BlockTypeDef *)addr;
+      if((block->Magic != FLOG_MAGIC) || (block->Length > FLOG_MAX_PAYLOAD) ||
+         ((addr + FLOG_BLOCK_SIZE(block->Length)) > end))
+      {
+        /* Erased, or garbage: the rest of the page is unused */
+        break;
+      }
+      if(FLOG_BlockValid(block) && (!found || ((int32_t)(block->Seq - lastSeq) > 0)))
+      {
+        found = 1;
+        lastSeq = block->Seq;
+        lastEnd = addr + FLOG_BLOCK_SIZE(block->Length);
+        Session = block->Session;
+      }
+      addr += FLOG_BLOCK_SIZE(block->Length);
+    }
+  }
+
+  if(found)
+  {
+    /* Carry on after the newest block if the rest of its page is blank */
+    WritePage = (lastEnd - 1U - LogBase) / FLASH_PAGE_SIZE;
+    WriteAddr = lastEnd;
+    if(!FLOG_Blank(WriteAddr, FLOG_PAGE_ADDR(WritePage) + FLASH_PAGE_SIZE))
+    {
+      WriteAddr = FLOG_PAGE_ADDR(WritePage) + FLASH_PAGE_SIZE;
+    }
+    NextSeq = lastSeq + 1U;
+  }
+  else
+  {
+    /* Empty log, start on page 0 */
+    WritePage = LogPages - 1U;
+    WriteAddr = LogBase + (LogPages * FLASH_PAGE_SIZE);
+    NextSeq = 0;
+  }
+
+  BlankPages = 0;
+  LogState = FLOG_STATE_IDLE;
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Pages a recording needs, to size the erase of FLOG_Start().
+  *         Blocks never span a page, the unused end of each page counts.
+  * @param  Channels: int16_t samples per frame, 1 to FLOG_MAX_CHANNELS
+  * @param  Rate: frames per second
+  * @param  Seconds: length of the recording
+  * @param  Bits: packed bits per sample expected from imucodec.c, 16 for
+  *         the worst case, raw blocks
+  * @retval Pages, at least 1
+  */
+uint32_t FLOG_PagesFor(uint8_t Channels, uint16_t Rate, uint32_t Seconds, uint8_t Bits)
+{
+  uint32_t payload, perPage, blocks;
+
+  payload = Channels * (IMUC_CHANNEL_HEADER + ((((FLOG_BLOCK_FRAMES - 1U) * Bits) + 7U) / 8U));
+  if(payload > (FLOG_BLOCK_FRAMES * Channels * 2U))
+  {
+    payload = FLOG_BLOCK_FRAMES * Channels * 2U;
+  }
+  perPage = FLASH_PAGE_SIZE / FLOG_BLOCK_SIZE((payload + 3U) & ~3U);
+  blocks = ((Rate * Seconds) + FLOG_BLOCK_FRAMES - 1U) / FLOG_BLOCK_FRAMES;
+
+  return (blocks + perPage - 1U) / perPage;
+}
+
+/**
+  * @brief  Erase the space for a recording and start a new session.
+  * @param  Channels: int16_t samples per frame, 1 to FLOG_MAX_CHANNELS
+  * @param  Rate: frames per second, stored for the host tool
+  * @param  ErasePages: pages to prepare ahead of the write position, see
+  *         FLOG_PagesFor(). 0 for all of them, which erases every older
+  *         session. Blocks for ~40 ms per non blank page.
+  * @retval HAL status
+  */
+HAL_StatusTypeDef FLOG_Start(uint8_t Channels, uint16_t Rate, uint32_t ErasePages)
+{
+  HAL_StatusTypeDef status = HAL_OK;
+  uint32_t i;
+
+  if((LogPages == 0U) || (LogState != FLOG_STATE_IDLE) ||
+     (Channels == 0U) || (Channels > FLOG_MAX_CHANNELS))
+  {
+    return HAL_ERROR;
+  }
+
+  FrameBuf[0] = MEMPOOL_Alloc(&MEMPOOL_Sample);
+  FrameBuf[1] = MEMPOOL_Alloc(&MEMPOOL_Sample);
+  if((FrameBuf[0] == NULL) || (FrameBuf[1] == NULL))
+  {
+    FLOG_FreeBuffers();
+    return HAL_ERROR;
+  }
+
+  if((ErasePages == 0U) || (ErasePages > (LogPages - 1U)))
+  {
+    ErasePages = LogPages - 1U;
+  }
+  for(i = 0; (status == HAL_OK) && (i < ErasePages); i++)
+  {
+    /* Up to 2 s for the whole region, each page is progress */
+    WDOG_CheckIn(WDOG_TASK_MAIN);
+    status = FLOG_ErasePage((WritePage + 1U + i) % LogPages);
+  }
+  BlankPages = (status == HAL_OK) ? i : (i - 1U);
+
+  LogChannels = Channels;
+  LogRate = Rate;
+  Session++;
+  memset(&LogStats, 0, sizeof(LogStats));
+  FrameCount[0] = 0;
+  FrameCount[1] = 0;
+  FillBuf = 0;
+  PendingBuf = -1;
+  ImageLen = 0;
+  ImagePos = 0;
+  LogState = FLOG_STATE_RECORDING;
+  WDOG_TaskStart(WDOG_TASK_FLOG);
+
+  return status;
+}
+
+/**
+  * @brief  Append one frame. Cheap, no flash access.
+  * @param  pFrame: LogChannels samples
+  * @retval HAL_BUSY if the frame was lost because both buffers are in use
+  */
+HAL_StatusTypeDef FLOG_Write(const int16_t *pFrame)
+{
+  uint8_t buf = FillBuf;
+  uint16_t count = FrameCount[buf];
+
+  if(LogState != FLOG_STATE_RECORDING)
+  {
+    return HAL_ERROR;
+  }
+
+  if(count == FLOG_BLOCK_FRAMES)
+  {
+    /* Previous block still waiting for FLOG_Task() */
+    LogStats.Overruns++;
+    return HAL_BUSY;
+  }
+
+  if(count == 0U)
+  {
+    FrameTick[buf] = HAL_GetTick();
+  }
+  memcpy(&FrameBuf[buf][count * LogChannels], pFrame, LogChannels * sizeof(int16_t));
+  FrameCount[buf] = ++count;
+
+  if((count == FLOG_BLOCK_FRAMES) && (PendingBuf < 0))
+  {
+    PendingBuf = (int8_t)buf;
+    FillBuf = buf ^ 1U;
+    FrameCount[FillBuf] = 0;
+  }
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Encode a completed buffer and program a burst of it.
+  *         Call from the main loop at least once per FLOG_PROGRAM_BURST frames.
+  * @param  None
+  * @retval HAL_ERROR on a programming error or when the log is full
+  */
+HAL_StatusTypeDef FLOG_Task(void)
+{
+  uint32_t size;
+  uint8_t buf;
+
+  WDOG_CheckIn(WDOG_TASK_FLOG);
+
+  if((ImagePos == ImageLen) && (PendingBuf >= 0))
+  {
+    buf = (uint8_t)PendingBuf;
+    FLOG_Encode(buf);
+    FrameCount[buf] = 0;
+    PendingBuf = -1;
+
+    /* A block that ended while this one waited is now pending */
+    if(FrameCount[FillBuf] == FLOG_BLOCK_FRAMES)
+    {
+      PendingBuf = (int8_t)FillBuf;
+      FillBuf = buf;
+    }
+
+    size = ImageLen * 2U;
+    if((WriteAddr + size) > (FLOG_PAGE_ADDR(WritePage) + FLASH_PAGE_SIZE))
+    {
+      if(BlankPages == 0U)
+      {
+        LogState = FLOG_STATE_FULL;
+        WDOG_TaskStop(WDOG_TASK_FLOG);
+        ImageLen = 0;
+        return HAL_ERROR;
+      }
+      WritePage = (WritePage + 1U) % LogPages;
+      WriteAddr = FLOG_PAGE_ADDR(WritePage);
+      BlankPages--;
+    }
+    ImageAddr = WriteAddr;
+    ImagePos = 0;
+    WriteAddr += size;
+  }
+
+  return FLOG_Program();
+}
+
+/**
+  * @brief  Flush the partial block and end the session.
+  * @param  None
+  * @retval HAL status
+  */
+HAL_StatusTypeDef FLOG_Stop(void)
+{
+  HAL_StatusTypeDef status = HAL_OK;
+
+  if(LogState == FLOG_STATE_IDLE)
+  {
+    return HAL_OK;
+  }
+
+  /* Drain what is queued, then queue the partial buffer and drain again */
+  while((status == HAL_OK) && ((PendingBuf >= 0) || (ImagePos < ImageLen)))
+  {
+    status = FLOG_Task();
+  }
+  if((status == HAL_OK) && (FrameCount[FillBuf] != 0U))
+  {
+    PendingBuf = (int8_t)FillBuf;
+    FillBuf ^= 1U;
+    while((status == HAL_OK) && ((PendingBuf >= 0) || (ImagePos < ImageLen)))
+    {
+      status = FLOG_Task();
+    }
+  }
+
+  PendingBuf = -1;
+  ImageLen = 0;
+  ImagePos = 0;
+  LogState = FLOG_STATE_IDLE;
+  WDOG_TaskStop(WDOG_TASK_FLOG);
+  FLOG_FreeBuffers();
+
+  return status;
+}
+
+/**
+  * @brief  Erase the whole log.
+  * @param  None
+  * @retval HAL status
+  */
+HAL_StatusTypeDef FLOG_Erase(void)
+{
+  HAL_StatusTypeDef status = HAL_OK;
+  uint32_t page;
+
+  if(LogState != FLOG_STATE_IDLE)
+  {
+    return HAL_ERROR;
+  }
+
+  for(page = 0; (status == HAL_OK) && (page < LogPages); page++)
+  {
+    WDOG_CheckIn(WDOG_TASK_MAIN);
+    status = FLOG_ErasePage(page);
+  }
+
+  return (status == HAL_OK) ? FLOG_Init() : status;
+}
+
+/**
+  * @brief  Recording state.
+  * @param  None
+  * @retval FLOG_STATE_xxx
+  */
+FLOG_StateTypeDef FLOG_GetState(void)
+{
+  return LogState;
+}
+
+/**
+  * @brief  Counters of the current or last session.
+  * @param  None
+  * @retval Pointer to the counters
+  */
+const FLOG_StatsTypeDef *FLOG_GetStats(void)
+{
+  return &LogStats;
+}
+
+/**
+  * @brief  Check the CRC of a block in flash.
+  * @param  pBlock: block header, Length already checked
+  * @retval 1 if the block is complete
+  */
+static uint8_t FLOG_BlockValid(const FLOG_BlockTypeDef *pBlock)
+{
+  const uint8_t *start = (const uint8_t *)pBlock + FLOG_CRC_OFFSET;
+
+  return (CRC32_Calc(start, FLOG_BLOCK_SIZE(pBlock->Length) - FLOG_CRC_OFFSET) == pBlock->Crc) ? 1U : 0U;
+}
+
+/**
+  * @brief  Check that a word aligned range is erased.
+  * @param  Address: start
+  * @param  End: end, excluded
+  * @retval 1 if blank
+  */
+static uint8_t FLOG_Blank(uint32_t Address, uint32_t End)
+{
+  for(Address &= ~3U; Address < End; Address += 4U)
+  {
+    if(*(const uint32_t *)Address != FLOG_ERASED)
+    {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+/**
+  * @brief  Erase a page unless it is already blank.
+  * @param  Page: page index in the LOG region
+  * @retval HAL status
+  */
+static HAL_StatusTypeDef FLOG_ErasePage(uint32_t Page)
+{
+  FLASH_EraseInitTypeDef erase;
+  uint32_t pageError;
+  HAL_StatusTypeDef status;
+
+  if(FLOG_Blank(FLOG_PAGE_ADDR(Page), FLOG_PAGE_ADDR(Page) + FLASH_PAGE_SIZE))
+  {
+    return HAL_OK;
+  }
+
+  erase.TypeErase = FLASH_TYPEERASE_PAGES;
+  erase.PageAddress = FLOG_PAGE_ADDR(Page);
+  erase.NbPages = 1;
+
+  HAL_FLASH_Unlock();
+  status = HAL_FLASHEx_Erase(&erase, &pageError);
+  HAL_FLASH_Lock();
+
+  return status;
+}
+
+/**
+  * @brief  Build the block image of a frame buffer: packed, or raw when
+  *         packing does not save anything (e.g. full scale noise).
+  * @param  Buf: frame buffer index
+  * @retval None
+  */
+static void FLOG_Encode(uint8_t Buf)
+{
+  FLOG_BlockTypeDef *block = (FLOG_BlockTypeDef *)Image;
+  uint8_t *out = (uint8_t *)(block + 1);
+  const int16_t *src = FrameBuf[Buf];
+  uint32_t frames = FrameCount[Buf];
+  uint32_t samples = frames * LogChannels;
+  uint32_t length;
+
+  block->Encoding = FLOG_ENC_PACKED;
+  length = IMUC_Encode(src, frames, LogChannels, out);
+  if(length >= (samples * sizeof(int16_t)))
+  {
+    block->Encoding = FLOG_ENC_RAW;
+    length = samples * sizeof(int16_t);
+    memcpy(out, src, length);
+  }
+  /* Keep the next header word aligned */
+  while(length & 3U)
+  {
+    out[length++] = 0xFF;
+  }
+
+  block->Magic = FLOG_MAGIC;
+  block->Length = (uint16_t)length;
+  block->Seq = NextSeq++;
+  block->Tick = FrameTick[Buf];
+  block->Session = Session;
+  block->Rate = LogRate;
+  block->Frames = (uint16_t)frames;
+  block->Channels = LogChannels;
+  block->Crc = CRC32_Calc((const uint8_t *)block + FLOG_CRC_OFFSET,
+                          FLOG_BLOCK_SIZE(length) - FLOG_CRC_OFFSET);
+
+  ImageLen = FLOG_BLOCK_SIZE(length) / 2U;
+  LogStats.RawBytes += samples * sizeof(int16_t);
+  LogStats.StoredBytes += FLOG_BLOCK_SIZE(length);
+}
+
+/**
+  * @brief  Program the next FLOG_PROGRAM_BURST half-words of the image.
+  * @param  None
+  * @retval HAL status, the block is abandoned on error
+  */
+static HAL_StatusTypeDef FLOG_Program(void)
+{
+  const uint16_t *src = (const uint16_t *)Image;
+  uint32_t n;
+  HAL_StatusTypeDef status = HAL_OK;
+
+  if(ImagePos == ImageLen)
+  {
+    return HAL_OK;
+  }
+
+  HAL_FLASH_Unlock();
+  for(n = 0; (status == HAL_OK) && (n < FLOG_PROGRAM_BURST) && (ImagePos < ImageLen); n++)
+  {
+    status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, ImageAddr + (2U * ImagePos), src[ImagePos]);
+    ImagePos++;
+  }
+  HAL_FLASH_Lock();
+
+  if(status != HAL_OK)
+  {
+    /* Left torn, its CRC will not match */
+    ImagePos = ImageLen;
+  }
+  else if(ImagePos == ImageLen)
+  {
+    LogStats.Blocks++;
+  }
+
+  return status;
+}
+
+/**
+  * @brief  Give the frame buffers back to the sample pool.
+  * @param  None
+  * @retval None
+  */
+static void FLOG_FreeBuffers(void)
+{
+  if(FrameBuf[0] != NULL)
+  {
+    MEMPOOL_Free(&MEMPOOL_Sample, FrameBuf[0]);
+    FrameBuf[0] = NULL;
+  }
+  if(FrameBuf[1] != NULL)
+  {
+    MEMPOOL_Free(&MEMPOOL_Sample, FrameBuf[1]);
+    FrameBuf[1] = NULL;
+  }
+}
+
+/**
+  * @}
+  */
@@ -0,0 +1,166 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Src/imucodec.c
+  * @brief   Lossless block codec for interleaved int16_t sensor frames.
+  *
+  *          Each channel of a block is coded on its own, channel after
+  *          channel:
+  *            - first sample, int16_t little endian
+  *            - bit width W of the largest zigzag delta, 0 to 16
+  *            - Frames - 1 zigzag deltas of W bits each, LSB first,
+  *              padded to a byte
+  *          Deltas wrap modulo 2^16, so W never exceeds 16 and the coding
+  *          is lossless for any input.
+  *
+  *          Sensor noise of a few LSB gives W of 4 to 7 bits against the
+  *          16 of a raw sample, 2-3x on data at rest or in slow motion. A
+  *          constant channel costs its 3 header bytes only.
+  *
+  *          The encoder makes two linear passes per channel (width, then
+  *          packing) with no data dependent branching beyond at most two
+  *          byte stores per sample. convbench.c times it on a 64 frame x 9
+  *          channel block: CPU cycles in the CONV demo, ns on the host.
+  *
+  *          tools/imucodec.py is the host side, numpy vectorised, decoder.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "imucodec.h"
+#include "sections.h"
+
+/** @addtogroup BSP_Examples
+  * @{
+  */
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/* Private macro -------------------------------------------------------------*/
+/* Map signed to unsigned, small magnitudes to small codes: 0, -1, 1, -2, ... */
+#define IMUC_ZIGZAG(__D__)      ((uint16_t)(((uint32_t)(__D__) << 1) ^ (uint32_t)((int32_t)(__D__) >> 15)))
+#define IMUC_UNZIGZAG(__Z__)    ((uint16_t)(((__Z__) >> 1) ^ (0U - ((__Z__) & 1U))))
+
+/* Private variables ---------------------------------------------------------*/
+/* Private function prototypes -----------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Encode a block of frames.
+  * @param  pIn: Frames x Channels samples, frame after frame
+  * @param  Frames: frames in the block, at least 1
+  * @param  Channels: samples per frame
+  * @param  pOut: destination, IMUC_MAX_SIZE(Frames, Channels) bytes
+  * @retval Encoded size in bytes
+  */
+__RAMFUNC uint32_t IMUC_Encode(const int16_t *pIn, uint32_t Frames, uint32_t Channels, uint8_t *pOut)
+{
+  const int16_t *src;
+  uint8_t *out = pOut;
+  uint32_t acc, bits, width, any;
+  uint32_t c, i;
+  int16_t prev, delta;
+
+  for(c = 0; c < Channels; c++)
+  {
+    src = pIn + c;
+
+    /* Width of the largest zigzag delta */
+    any = 0;
+    prev = src[0];
+    for(i = 1; i < Frames; i++)
+    {
+      delta = (int16_t)(src[i * Channels] - prev);
+      prev = src[i * Channels];
+      any |= IMUC_ZIGZAG(delta);
+    }
+    width = 32U - __CLZ(any);
+
+    *out++ = (uint8_t)src[0];
+    *out++ = (uint8_t)((uint16_t)src[0] >> 8);
+    *out++ = (uint8_t)width;
+    if(width == 0U)
+    {
+      continue;
+    }
+
+    /* At most 7 + 16 bits pending, the accumulator never overflows */
+    acc = 0;
+    bits = 0;
+    prev = src[0];
+    for(i = 1; i < Frames; i++)
+    {
+      delta = (int16_t)(src[i * Channels] - prev);
+      prev = src[i * Channels];
+      acc |= (uint32_t)IMUC_ZIGZAG(delta) << bits;
+      bits += width;
+      while(bits >= 8U)
+      {
+        *out++ = (uint8_t)acc;
+        acc >>= 8;
+        bits -= 8U;
+      }
+    }
+    if(bits != 0U)
+    {
+      *out++ = (uint8_t)acc;
+    }
+  }
+
+  return (uint32_t)(out - pOut);
+}
+
+/**
+  * @brief  Decode a block of frames.
+  * @param  pIn: encoded block
+  * @param  Length: bytes available at pIn
+  * @param  Frames: frames in the block
+  * @param  Channels: samples per frame
+  * @param  pOut: Frames x Channels samples, frame after frame
+  * @retval Bytes consumed, 0 if the block is truncated or corrupt
+  */
+uint32_t IMUC_Decode(const uint8_t *pIn, uint32_t Length, uint32_t Frames, uint32_t Channels, int16_t *pOut)
+{
+  const uint8_t *in = pIn;
+  const uint8_t *end = pIn + Length;
+  uint32_t acc, bits, width, mask;
+  uint32_t c, i;
+  uint16_t value;
+
+  for(c = 0; c < Channels; c++)
+  {
+    if((end - in) < (int32_t)IMUC_CHANNEL_HEADER)
+    {
+      return 0;
+    }
+    value = (uint16_t)(in[0] | ((uint16_t)in[1] << 8));
+    width = in[2];
+    in += IMUC_CHANNEL_HEADER;
+    if((width > 16U) || ((uint32_t)(end - in) < ((((Frames - 1U) * width) + 7U) / 8U)))
+    {
+      return 0;
+    }
+
+    pOut[c] = (int16_t)value;
+    mask = (1U << width) - 1U;
+    acc = 0;
+    bits = 0;
+    for(i = 1; i < Frames; i++)
+    {
+      while(bits < width)
+      {
+        acc |= (uint32_t)*in++ << bits;
+        bits += 8U;
+      }
+      value += IMUC_UNZIGZAG(acc & mask);
+      acc >>= width;
+      bits -= width;
+      pOut[(i * Channels) + c] = (int16_t)value;
+    }
+  }
+
+  return (uint32_t)(in - pIn);
+}
+
+/**
+  * @}
+  */
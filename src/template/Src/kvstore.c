@@ -0,0 +1,537 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Src/kvstore.c
+  * @brief   Log structured key-value store in the KVSTORE flash pages.
+  *
+  *          The pages form a ring. Each page starts with a header carrying a
+  *          sequence number, followed by records appended one after the
+  *          other. Updating a key appends a new record, deleting appends an
+  *          empty one, nothing is rewritten in place.
+  *
+  *          When the head page is full the next page of the ring is opened,
+  *          and the page after it - the oldest one - is reclaimed: its
+  *          records that are still current are copied to the new head, then
+  *          it is erased. One page is thus always blank ahead of the head,
+  *          and every page gets erased in turn (wear levelling).
+  *
+  *          KV_Init() scans the pages once, oldest first, and builds a RAM
+  *          table with the location of the latest record of each key: reads
+  *          are O(1) and need no flash scan. Records carry a CRC-32, a record
+  *          torn by a reset is skipped at the next scan.
+  *
+  *          The region is outside the application image, reprogramming the
+  *          application (st-flash write, openocd write_image erase) leaves
+  *          it untouched.
+  *
+  *          Flash is stalled during a page erase (~40 ms): call KV_Set() and
+  *          KV_Delete() from the main loop only, never from an ISR. Keep the
+  *          live data below (pages - 2) pages.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "kvstore.h"
+#include "crc32.h"
+
+/** @addtogroup BSP_Examples
+  * @{
+  */
+
+/* Private typedef -----------------------------------------------------------*/
+/**
+  * @brief Page header, first 8 bytes of every page in use
+  */
+typedef struct
+{
+  uint32_t Magic;
+  uint32_t Seq;
+} KV_PageTypeDef;
+
+/**
+  * @brief Record header, followed by Length bytes padded to a word
+  */
+typedef struct
+{
+  uint16_t Key;       /*!< 0xFFFF: erased, end of the page log */
+  uint16_t Length;    /*!< 0: key deleted */
+  uint32_t Crc;       /*!< CRC-32 of Key, Length and data */
+} KV_RecordTypeDef;
+
+/* Private define ------------------------------------------------------------*/
+#define KV_PAGE_MAGIC     0x4B56504BU   /* "KPVK" */
+#define KV_ERASED         0xFFFFFFFFU
+#define KV_NONE           0xFFFFU       /* index entry of an absent key */
+#define KV_MIN_PAGES      3U
+
+/* Private macro -------------------------------------------------------------*/
+#define KV_ALIGN(__LEN__)         (((__LEN__) + 3U) & ~3U)
+#define KV_RECORD_SIZE(__LEN__)   (sizeof(KV_RecordTypeDef) + KV_ALIGN(__LEN__))
+#define KV_PAGE_ADDR(__PAGE__)    (KvBase + ((__PAGE__) * FLASH_PAGE_SIZE))
+
+/* Private variables ---------------------------------------------------------*/
+/* KVSTORE region, see default/STM32F303VCTx_FLASH.ld */
+extern uint32_t _skvstore[];
+extern uint32_t _ekvstore[];
+
+static uint32_t KvBase;
+static uint32_t KvPages;
+static uint32_t HeadPage;
+static uint32_t HeadSeq;
+static uint32_t WriteAddr;
+
+/* Word offset from KvBase of the latest record of each key */
+static uint16_t KvIndex[KV_MAX_KEYS];
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t          KV_RecordCrc(uint16_t Key, uint16_t Length, const void *pData);
+static uint32_t          KV_ScanPage(uint32_t Page, uint8_t UpdateIndex);
+static uint8_t           KV_PageValid(uint32_t Page);
+static HAL_StatusTypeDef KV_ErasePage(uint32_t Page);
+static HAL_StatusTypeDef KV_OpenNext(void);
+static HAL_StatusTypeDef KV_Reclaim(uint32_t Page);
+static HAL_StatusTypeDef KV_Append(uint16_t Key, const void *pData, uint16_t Length);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Scan the store and build the RAM index, format it if empty.
+  * @param  None
+  * @retval HAL status
+  */
+HAL_StatusTypeDef KV_Init(void)
+{
+  uint32_t page, i;
+  uint8_t found = 0;
+
+  KvBase = (uint32_t)_skvstore;
+  KvPages = ((uint32_t)_ekvstore - KvBase) / FLASH_PAGE_SIZE;
+  if(KvPages < KV_MIN_PAGES)
+  {
+    return HAL_ERROR;
+  }
+
+  memset(KvIndex, 0xFF, sizeof(KvIndex));
+
+  /* Head is the page with the highest sequence number */
+  for(page = 0; page < KvPages; page++)
+  {
+    if(KV_PageValid(page))
+    {
+      const KV_PageTypeDef *hdr = (const KV_PageTypeDef *)KV_PAGE_ADDR(page);
+
+      if(!found || ((int32_t)(hdr->Seq - HeadSeq) > 0))
+      {
+        HeadPage = page;
+        HeadSeq = hdr->Seq;
+        found = 1;
+      }
+    }
+  }
+  if(!found)
+  {
+    return KV_Format();
+  }
+
+  /* Replay oldest to newest, the ring order after the head */
+  for(i = 1; i <= KvPages; i++)
+  {
+    page = (HeadPage + i) % KvPages;
+    if(KV_PageValid(page))
+    {
+      WriteAddr = KV_ScanPage(page, 1);
+    }
+  }
+
+  /* A reset between opening the head and erasing the oldest page leaves
+     no blank page ahead, finish the reclaim now */
+  page = (HeadPage + 1U) % KvPages;
+  if(KV_PageValid(page))
+  {
+    HAL_StatusTypeDef status;
+
+    HAL_FLASH_Unlock();
+    status = KV_Reclaim(page);
+    HAL_FLASH_Lock();
+    return status;
+  }
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Erase every page and start an empty store.
+  * @param  None
+  * @retval HAL status
+  */
+HAL_StatusTypeDef KV_Format(void)
+{
+  HAL_StatusTypeDef status = HAL_OK;
+  uint32_t page;
+
+  memset(KvIndex, 0xFF, sizeof(KvIndex));
+
+  HAL_FLASH_Unlock();
+  for(page = 0; (status == HAL_OK) && (page < KvPages); page++)
+  {
+    status = KV_ErasePage(page);
+  }
+
+  /* Open page 0 with sequence number 1 */
+  HeadPage = KvPages - 1U;
+  HeadSeq = 0;
+  if(status == HAL_OK)
+  {
+    status = KV_OpenNext();
+  }
+  HAL_FLASH_Lock();
+
+  return status;
+}
+
+/**
+  * @brief  Copy the value of a key.
+  * @param  Key: key
+  * @param  pData: destination
+  * @param  Size: size of the destination
+  * @param  pLength: set to the stored length, may be NULL
+  * @retval HAL_ERROR if the key is absent or the value does not fit
+  */
+HAL_StatusTypeDef KV_Get(uint16_t Key, void *pData, uint16_t Size, uint16_t *pLength)
+{
+  uint16_t length;
+  const void *value = KV_GetPtr(Key, &length);
+
+  if((value == 0) || (length > Size))
+  {
+    return HAL_ERROR;
+  }
+
+  memcpy(pData, value, length);
+  if(pLength != 0)
+  {
+    *pLength = length;
+  }
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Locate the value of a key in flash, no copy.
+  * @param  Key: key
+  * @param  pLength: set to the stored length
+  * @retval Pointer to the value, NULL if the key is absent. Valid until the
+  *         next KV_Set() / KV_Delete().
+  */
+const void *KV_GetPtr(uint16_t Key, uint16_t *pLength)
+{
+  const KV_RecordTypeDef *rec;
+
+  if((Key >= KV_MAX_KEYS) || (KvIndex[Key] == KV_NONE))
+  {
+    return 0;
+  }
+
+  rec = (const KV_RecordTypeDef *)(KvBase + (4U * KvIndex[Key]));
+  *pLength = rec->Length;
+
+  return rec + 1;
+}
+
+/**
+  * @brief  Store a value. Nothing is written if the stored value is identical.
+  * @param  Key: key, below KV_MAX_KEYS
+  * @param  pData: value
+  * @param  Length: 1 to KV_MAX_VALUE_SIZE bytes
+  * @retval HAL_ERROR on invalid arguments or when the store is full
+  */
+HAL_StatusTypeDef KV_Set(uint16_t Key, const void *pData, uint16_t Length)
+{
+  HAL_StatusTypeDef status;
+  uint16_t length;
+  const void *current = KV_GetPtr(Key, &length);
+  uint32_t tries;
+
+  if((Key >= KV_MAX_KEYS) || (Length == 0U) || (Length > KV_MAX_VALUE_SIZE))
+  {
+    return HAL_ERROR;
+  }
+  if((current != 0) && (length == Length) && (memcmp(current, pData, Length) == 0))
+  {
+    return HAL_OK;
+  }
+
+  HAL_FLASH_Unlock();
+  status = KV_Append(Key, pData, Length);
+
+  /* Head full: each new page reclaims the oldest one */
+  for(tries = 0; (status == HAL_BUSY) && (tries < (KvPages - 1U)); tries++)
+  {
+    status = KV_OpenNext();
+    if(status == HAL_OK)
+    {
+      status = KV_Append(Key, pData, Length);
+    }
+  }
+  HAL_FLASH_Lock();
+
+  return (status == HAL_OK) ? HAL_OK : HAL_ERROR;
+}
+
+/**
+  * @brief  Remove a key.
+  * @param  Key: key
+  * @retval HAL status
+  */
+HAL_StatusTypeDef KV_Delete(uint16_t Key)
+{
+  HAL_StatusTypeDef status;
+
+  if(Key >= KV_MAX_KEYS)
+  {
+    return HAL_ERROR;
+  }
+  if(KvIndex[Key] == KV_NONE)
+  {
+    return HAL_OK;
+  }
+
+  HAL_FLASH_Unlock();
+  status = KV_Append(Key, 0, 0);
+  if(status == HAL_BUSY)
+  {
+    status = KV_OpenNext();
+    if(status == HAL_OK)
+    {
+      status = KV_Append(Key, 0, 0);
+    }
+  }
+  HAL_FLASH_Lock();
+
+  return status;
+}
+
+/**
+  * @brief  CRC-32 of a record.
+  * @param  Key: record key
+  * @param  Length: record length
+  * @param  pData: record data
+  * @retval CRC-32
+  */
+static uint32_t KV_RecordCrc(uint16_t Key, uint16_t Length, const void *pData)
+{
+  uint16_t hdr[2];
+  uint32_t crc;
+
+  hdr[0] = Key;
+  hdr[1] = Length;
+  crc = CRC32_Calc(hdr, sizeof(hdr));
+  if(Length != 0U)
+  {
+    crc = CRC32_Accumulate(pData, Length);
+  }
+
+  return crc;
+}
+
+/**
+  * @brief  Walk the records of a page.
+  * @param  Page: page number
+  * @param  UpdateIndex: point the index at every intact record found
+  * @retval Address following the last record, where the next one goes
+  */
+static uint32_t KV_ScanPage(uint32_t Page, uint8_t UpdateIndex)
+{
+  uint32_t addr = KV_PAGE_ADDR(Page) + sizeof(KV_PageTypeDef);
+  uint32_t end = KV_PAGE_ADDR(Page) + FLASH_PAGE_SIZE;
+  const KV_RecordTypeDef *rec;
+
+  while((addr + sizeof(KV_RecordTypeDef)) <= end)
+  {
+    rec = (const KV_RecordTypeDef *)addr;
+    if(rec->Key == 0xFFFFU)
+    {
+      break;
+    }
+    if((rec->Length > KV_MAX_VALUE_SIZE) || ((addr + KV_RECORD_SIZE(rec->Length)) > end))
+    {
+      /* Header torn: nothing more can be appended here */
+      return end;
+    }
+
+    if(UpdateIndex && (rec->Key < KV_MAX_KEYS) && (rec->Crc == KV_RecordCrc(rec->Key, rec->Length, rec + 1)))
+    {
+      KvIndex[rec->Key] = (rec->Length != 0U) ? (uint16_t)((addr - KvBase) / 4U) : KV_NONE;
+    }
+    addr += KV_RECORD_SIZE(rec->Length);
+  }
+
+  return addr;
+}
+
+/**
+  * @brief  Check a page header.
+  * @param  Page: page number
+  * @retval 1 if the page belongs to the store
+  */
+static uint8_t KV_PageValid(uint32_t Page)
+{
+  return ((const KV_PageTypeDef *)KV_PAGE_ADDR(Page))->Magic == KV_PAGE_MAGIC;
+}
+
+/**
+  * @brief  Erase a page unless it is blank already. Flash must be unlocked.
+  * @param  Page: page number
+  * @retval HAL status
+  */
+static HAL_StatusTypeDef KV_ErasePage(uint32_t Page)
+{
+  FLASH_EraseInitTypeDef erase;
+  const uint32_t *word = (const uint32_t *)KV_PAGE_ADDR(Page);
+  uint32_t pageError;
+  uint32_t i;
+
+  for(i = 0; i < (FLASH_PAGE_SIZE / 4U); i++)
+  {
+    if(word[i] != KV_ERASED)
+    {
+      erase.TypeErase = FLASH_TYPEERASE_PAGES;
+      erase.PageAddress = KV_PAGE_ADDR(Page);
+      erase.NbPages = 1;
+      return HAL_FLASHEx_Erase(&erase, &pageError);
+    }
+  }
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Make the next page of the ring the head, then reclaim the oldest
+  *         page so that a blank one stays ahead. Flash must be unlocked.
+  * @param  None
+  * @retval HAL status
+  */
+static HAL_StatusTypeDef KV_OpenNext(void)
+{
+  uint32_t next = (HeadPage + 1U) % KvPages;
+  uint32_t addr = KV_PAGE_ADDR(next);
+  HAL_StatusTypeDef status;
+
+  /* Oldest page could not be reclaimed: live data exceeds the store */
+  if(KV_PageValid(next))
+  {
+    return HAL_ERROR;
+  }
+
+  status = KV_ErasePage(next);
+  if(status == HAL_OK)
+  {
+    status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr + 4U, HeadSeq + 1U);
+  }
+  if(status == HAL_OK)
+  {
+    /* Magic last: the page only counts once its sequence number is there */
+    status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr, KV_PAGE_MAGIC);
+  }
+  if(status != HAL_OK)
+  {
+    return status;
+  }
+
+  HeadPage = next;
+  HeadSeq++;
+  WriteAddr = addr + sizeof(KV_PageTypeDef);
+
+  next = (HeadPage + 1U) % KvPages;
+  if(KV_PageValid(next))
+  {
+    status = KV_Reclaim(next);
+  }
+
+  return status;
+}
+
+/**
+  * @brief  Move the current records of a page to the head, then erase it.
+  *         Flash must be unlocked.
+  * @param  Page: page number, the oldest page of the ring
+  * @retval HAL status
+  */
+static HAL_StatusTypeDef KV_Reclaim(uint32_t Page)
+{
+  uint32_t addr = KV_PAGE_ADDR(Page) + sizeof(KV_PageTypeDef);
+  uint32_t end = KV_PAGE_ADDR(Page) + FLASH_PAGE_SIZE;
+  const KV_RecordTypeDef *rec;
+  HAL_StatusTypeDef status = HAL_OK;
+
+  while((status == HAL_OK) && ((addr + sizeof(KV_RecordTypeDef)) <= end))
+  {
+    rec = (const KV_RecordTypeDef *)addr;
+    if((rec->Key == 0xFFFFU) || (rec->Length > KV_MAX_VALUE_SIZE) ||
+       ((addr + KV_RECORD_SIZE(rec->Length)) > end))
+    {
+      break;
+    }
+
+    /* Superseded values and deletions are dropped */
+    if((rec->Key < KV_MAX_KEYS) && (KvIndex[rec->Key] == (uint16_t)((addr - KvBase) / 4U)))
+    {
+      status = KV_Append(rec->Key, rec + 1, rec->Length);
+    }
+    addr += KV_RECORD_SIZE(rec->Length);
+  }
+
+  if(status == HAL_OK)
+  {
+    status = KV_ErasePage(Page);
+  }
+
+  return (status == HAL_BUSY) ? HAL_ERROR : status;
+}
+
+/**
+  * @brief  Write a record at the head. Flash must be unlocked.
+  * @param  Key: key
+  * @param  pData: value, may be NULL when Length is 0
+  * @param  Length: value length, 0 for a deletion
+  * @retval HAL_BUSY if the head page has no room left
+  */
+static HAL_StatusTypeDef KV_Append(uint16_t Key, const void *pData, uint16_t Length)
+{
+  uint32_t end = KV_PAGE_ADDR(HeadPage) + FLASH_PAGE_SIZE;
+  uint32_t addr = WriteAddr;
+  uint32_t word;
+  uint32_t i;
+  HAL_StatusTypeDef status;
+
+  if((addr + KV_RECORD_SIZE(Length)) > end)
+  {
+    return HAL_BUSY;
+  }
+
+  /* Header first, the CRC only matches once the data is complete */
+  status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr, (uint32_t)Key | ((uint32_t)Length << 16));
+  if(status == HAL_OK)
+  {
+    status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr + 4U, KV_RecordCrc(Key, Length, pData));
+  }
+  for(i = 0; (status == HAL_OK) && (i < Length); i += 4U)
+  {
+    word = KV_ERASED;
+    memcpy(&word, (const uint8_t *)pData + i, ((Length - i) < 4U) ? (Length - i) : 4U);
+    status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr + sizeof(KV_RecordTypeDef) + i, word);
+  }
+
+  /* The space is consumed even if programming failed part way */
+  WriteAddr = addr + KV_RECORD_SIZE(Length);
+  if(status == HAL_OK)
+  {
+    KvIndex[Key] = (Length != 0U) ? (uint16_t)((addr - KvBase) / 4U) : KV_NONE;
+  }
+
+  return status;
+}
+
+/**
+  * @}
+  */
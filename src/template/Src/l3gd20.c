@@ -36,6 +36,8 @@
   ******************************************************************************
   */
 /* Includes ------------------------------------------------------------------*/
+#include "mems_drv.h"
+#include "mems_conv.h"
 #include <../Components/l3gd20/l3gd20.h>
 
 /** @addtogroup BSP
@@ -61,6 +63,10 @@
 /** @defgroup L3GD20_Private_Defines
   * @{
   */
+/* Fraction bits of the sensitivity in MEMSCONV_ScaleQ(), per full scale */
+#define L3GD20_GAIN_SHIFT_250           11U
+#define L3GD20_GAIN_SHIFT_500           10U
+#define L3GD20_GAIN_SHIFT_2000          8U
 
 /**
   * @}
@@ -94,6 +100,11 @@ GYRO_DrvTypeDef L3gd20Drv =
   L3GD20_ReadXYZAngRate
 };
 
+/* Sensitivity of the full scale written by L3GD20_Init(), mdps per LSB in
+   Q(shift), and the float weight of one unit of the scaled result */
+static int16_t L3gd20Gain = MEMSCONV_GAIN(8.75, L3GD20_GAIN_SHIFT_250);
+static float   L3gd20Unit = 1.0f / (float)(1UL << L3GD20_GAIN_SHIFT_250);
+
 /**
   * @}
   */
@@ -130,6 +141,25 @@ void L3GD20_Init(uint16_t InitStruct)
   /* Write value to MEMS CTRL_REG4 register */  
   ctrl = (uint8_t) (InitStruct >> 8);
   GYRO_IO_Write(&ctrl, L3GD20_CTRL_REG4_ADDR, 1);
+  
+  /* Sensitivity of this full scale, for L3GD20_ReadXYZAngRate() */
+  switch(ctrl & L3GD20_FULLSCALE_SELECTION)
+  {
+  case L3GD20_FULLSCALE_250:
+    L3gd20Gain = MEMSCONV_GAIN(L3GD20_SENSITIVITY_250DPS, L3GD20_GAIN_SHIFT_250);
+    L3gd20Unit = 1.0f / (float)(1UL << L3GD20_GAIN_SHIFT_250);
+    break;
+    
+  case L3GD20_FULLSCALE_500:
+    L3gd20Gain = MEMSCONV_GAIN(L3GD20_SENSITIVITY_500DPS, L3GD20_GAIN_SHIFT_500);
+    L3gd20Unit = 1.0f / (float)(1UL << L3GD20_GAIN_SHIFT_500);
+    break;
+    
+  default:
+    L3gd20Gain = MEMSCONV_GAIN(L3GD20_SENSITIVITY_2000DPS, L3GD20_GAIN_SHIFT_2000);
+    L3gd20Unit = 1.0f / (float)(1UL << L3GD20_GAIN_SHIFT_2000);
+    break;
+  }
 }
 
 
@@ -344,57 +374,140 @@ uint8_t L3GD20_GetDataStatus(void)
 
 /**
 * @brief  Calculate the L3GD20 angular data.
-* @param  pfData: Data out pointer
+* @param  pfData: Data out pointer, X, Y, Z in mdps
 * @retval None
 */
 void L3GD20_ReadXYZAngRate(float *pfData)
 {
-  uint8_t tmpbuffer[6] ={0};
-  int16_t RawData[3] = {0};
+  int16_t RawData[3];
+  int32_t scaled[3];
+  int i;
+  
+  L3GD20_ReadXYZRaw(RawData);
+  
+  /* Exact: every sensitivity is 17920 in some Q format */
+  MEMSCONV_ScaleQ(RawData, L3gd20Gain, 0, scaled);
+  for(i=0; i<3; i++)
+  {
+    pfData[i] = (float)scaled[i] * L3gd20Unit;
+  }
+}
+
+/**
+* @brief  Read the L3GD20 angular rate registers without scaling.
+* @param  pData: Data out pointer, X, Y, Z in LSB
+* @retval None
+*/
+void L3GD20_ReadXYZRaw(int16_t *pData)
+{
   uint8_t tmpreg = 0;
-  float sensitivity = 0;
-  int i =0;
   
   GYRO_IO_Read(&tmpreg,L3GD20_CTRL_REG4_ADDR,1);
   
-  GYRO_IO_Read(tmpbuffer,L3GD20_OUT_X_L_ADDR,6);
+  /* The output registers are the three samples, see mems_conv.h */
+  GYRO_IO_Read((uint8_t *)pData,L3GD20_OUT_X_L_ADDR,6);
   
   /* check in the control register 4 the data alignment (Big Endian or Little Endian)*/
-  if(!(tmpreg & L3GD20_BLE_MSB))
-  {
-    for(i=0; i<3; i++)
-    {
-      RawData[i]=(int16_t)(((uint16_t)tmpbuffer[2*i+1] << 8) + tmpbuffer[2*i]);
-    }
-  }
-  else
+  if(tmpreg & L3GD20_BLE_MSB)
   {
-    for(i=0; i<3; i++)
-    {
-      RawData[i]=(int16_t)(((uint16_t)tmpbuffer[2*i] << 8) + tmpbuffer[2*i+1]);
-    }
+    MEMSCONV_Be((const uint8_t *)pData, pData);
   }
+}
+
+/**
+* @brief  Sensitivity of the configured full scale.
+* @param  None
+* @retval mdps per LSB
+*/
+float L3GD20_GetSensitivity(void)
+{
+  uint8_t tmpreg = 0;
+  
+  GYRO_IO_Read(&tmpreg,L3GD20_CTRL_REG4_ADDR,1);
   
-  /* Switch the sensitivity value set in the CRTL4 */
   switch(tmpreg & L3GD20_FULLSCALE_SELECTION)
   {
-  case L3GD20_FULLSCALE_250:
-    sensitivity=L3GD20_SENSITIVITY_250DPS;
-    break;
-    
   case L3GD20_FULLSCALE_500:
-    sensitivity=L3GD20_SENSITIVITY_500DPS;
-    break;
+    return L3GD20_SENSITIVITY_500DPS;
     
   case L3GD20_FULLSCALE_2000:
-    sensitivity=L3GD20_SENSITIVITY_2000DPS;
-    break;
+    return L3GD20_SENSITIVITY_2000DPS;
+    
+  case L3GD20_FULLSCALE_250:
+  default:
+    return L3GD20_SENSITIVITY_250DPS;
   }
-  /* Divide by sensitivity */
-  for(i=0; i<3; i++)
+}
+
+/**
+* @brief  Stream the angular rate through the FIFO, watermark on INT2.
+* @param  Watermark: samples that raise INT2, 1 to 31, 0 to bypass the FIFO
+*         and return to one sample per read
+* @retval None
+*/
+void L3GD20_FifoConfig(uint8_t Watermark)
+{
+  uint8_t ctrl3 = 0, ctrl5 = 0, fifo;
+  
+  GYRO_IO_Read(&ctrl3,L3GD20_CTRL_REG3_ADDR,1);
+  GYRO_IO_Read(&ctrl5,L3GD20_CTRL_REG5_ADDR,1);
+  
+  /* Going through bypass mode empties the FIFO */
+  fifo = L3GD20_FIFO_MODE_BYPASS;
+  GYRO_IO_Write(&fifo,L3GD20_FIFO_CTRL_REG_ADDR,1);
+  
+  if(Watermark != 0)
+  {
+    ctrl3 |= L3GD20_I2_WTM;
+    ctrl5 |= L3GD20_FIFO_EN;
+    fifo = L3GD20_FIFO_MODE_STREAM | (Watermark & L3GD20_FIFO_WTM_MASK);
+  }
+  else
   {
-    pfData[i]=(float)(RawData[i] * sensitivity);
+    ctrl3 &= ~L3GD20_I2_WTM;
+    ctrl5 &= ~L3GD20_FIFO_EN;
   }
+  
+  GYRO_IO_Write(&ctrl5,L3GD20_CTRL_REG5_ADDR,1);
+  GYRO_IO_Write(&fifo,L3GD20_FIFO_CTRL_REG_ADDR,1);
+  GYRO_IO_Write(&ctrl3,L3GD20_CTRL_REG3_ADDR,1);
+}
+
+/**
+* @brief  Drain the FIFO without scaling.
+* @param  pData: Data out pointer, X, Y, Z in LSB per sample, oldest first
+* @param  MaxSamples: room at pData, in samples
+* @retval Samples read
+*/
+uint8_t L3GD20_FifoRead(int16_t *pData, uint8_t MaxSamples)
+{
+  uint8_t tmpreg = 0;
+  uint8_t src = 0;
+  uint8_t count;
+  int n;
+  
+  GYRO_IO_Read(&tmpreg,L3GD20_CTRL_REG4_ADDR,1);
+  GYRO_IO_Read(&src,L3GD20_FIFO_SRC_REG_ADDR,1);
+  
+  /* FSS counts up to 31, a full FIFO is flagged as overrun in stream mode */
+  count = (src & L3GD20_FIFO_SRC_OVRN) ? L3GD20_FIFO_DEPTH : (src & L3GD20_FIFO_SRC_FSS);
+  if(count > MaxSamples)
+  {
+    count = MaxSamples;
+  }
+  
+  for(n=0; n<count; n++)
+  {
+    /* Each read of the output registers pops one sample */
+    GYRO_IO_Read((uint8_t *)&pData[3*n],L3GD20_OUT_X_L_ADDR,6);
+    
+    if(tmpreg & L3GD20_BLE_MSB)
+    {
+      MEMSCONV_Be((const uint8_t *)&pData[3*n], &pData[3*n]);
+    }
+  }
+  
+  return count;
 }
 
 /**
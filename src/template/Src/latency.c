@@ -0,0 +1,263 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Src/latency.c
+  * @brief   Interrupt latency and jitter measurement harness.
+  *
+  *          Entry latency is the time between the hardware trigger of an
+  *          interrupt and the first instruction of its handler, measured with
+  *          the DWT cycle counter:
+  *           - SysTick: the trigger is the counter reload, so the elapsed
+  *             cycles are read back directly from SysTick->VAL.
+  *           - Captured edges: the timer capture of tstamp.c holds the
+  *             time of the edge, LATENCY_EnterCapture() takes it from the
+  *             handler. The gyro data-ready line on EXTI1 is one, the
+  *             resolution is 1 us (72 cycles at 72 MHz).
+  *           - Software probes: LATENCY_Trigger() stamps CYCCNT and pends the
+  *             IRQ in the NVIC. The EXTI pending flag stays clear, so the HAL
+  *             handler runs without invoking the user callback.
+  *           - Delays measured elsewhere are fed in with LATENCY_Record().
+  *             The DRDY_POLL slot is one: gyro data-ready edge, captured by
+  *             a timer, to the read in the polling AHRS loop. No interrupt
+  *             is involved, it is the reaction time of that loop.
+  *
+  *          Each source keeps a linear histogram plus min/max/sum/sum of
+  *          squares. LATENCY_Task(), called from the main loop, pends EXTI0
+  *          every LATENCY_PROBE_MS and sends the mean, jitter and non-empty
+  *          histogram rows of every source to the deferred log (dlog.c)
+  *          every LATENCY_REPORT_MS.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include <math.h>
+#include "latency.h"
+#include "sections.h"
+#include "dlog.h"
+
+/** @addtogroup BSP_Examples
+  * @{
+  */
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static LATENCY_StatsTypeDef LatencyStats[LATENCY_IRQ_COUNT] __CCMRAM_BSS;
+static __IO uint32_t LatencyStamp[LATENCY_IRQ_COUNT] __CCMRAM_BSS;
+static __IO uint32_t LatencyArmed __CCMRAM_BSS;
+static uint32_t LatencyProbeTick;
+static uint32_t LatencyReportTick;
+
+/* Private function prototypes -----------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Enable the DWT cycle counter and clear all statistics.
+  * @param  None
+  * @retval None
+  */
+void LATENCY_Init(void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  LATENCY_Reset();
+}
+
+/**
+  * @brief  Clear the statistics of every interrupt source.
+  * @param  None
+  * @retval None
+  */
+void LATENCY_Reset(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  uint32_t i;
+
+  __disable_irq();
+  memset(LatencyStats, 0, sizeof(LatencyStats));
+  for(i = 0; i < LATENCY_IRQ_COUNT; i++)
+  {
+    LatencyStats[i].Min = 0xFFFFFFFFU;
+  }
+  LatencyArmed = 0;
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Software trigger: stamp the cycle counter and pend the interrupt.
+  * @param  Id: statistics slot the next LATENCY_Enter(Id) is accounted to
+  * @param  IRQn: NVIC line to pend
+  * @retval None
+  */
+void LATENCY_Trigger(LATENCY_IrqTypeDef Id, IRQn_Type IRQn)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  LatencyArmed |= (1U << Id);
+  LatencyStamp[Id] = DWT->CYCCNT;
+  NVIC_SetPendingIRQ(IRQn);
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Handler entry probe for software triggered sources.
+  *         Does nothing when the interrupt was not raised by LATENCY_Trigger().
+  * @param  Id: interrupt source
+  * @retval None
+  */
+__CCMRAM_FUNC void LATENCY_Enter(LATENCY_IrqTypeDef Id)
+{
+  uint32_t now = DWT->CYCCNT;
+
+  if(LatencyArmed & (1U << Id))
+  {
+    LatencyArmed &= ~(1U << Id);
+    LATENCY_Record(Id, now - LatencyStamp[Id]);
+  }
+}
+
+/**
+  * @brief  Handler entry probe for SysTick, the reload is the trigger instant.
+  * @param  None
+  * @retval None
+  */
+__CCMRAM_FUNC void LATENCY_EnterSysTick(void)
+{
+  LATENCY_Record(LATENCY_IRQ_SYSTICK, SysTick->LOAD - SysTick->VAL);
+}
+
+/**
+  * @brief  Handler entry probe for an edge captured by a timer input.
+  *         Does nothing when no edge was captured. Not in CCM-RAM: the
+  *         trigger time is latched in hardware, the capture and timer
+  *         reads are in flash anyway.
+  * @param  Id: interrupt source
+  * @param  Source: capture input of the interrupt line, see tstamp.h
+  * @retval None
+  */
+void LATENCY_EnterCapture(LATENCY_IrqTypeDef Id, TSTAMP_SourceTypeDef Source)
+{
+  uint32_t stamp;
+
+  if(TSTAMP_Latch(Source, &stamp) == HAL_OK)
+  {
+    LATENCY_Record(Id, TSTAMP_ELAPSED(stamp, TSTAMP_Now()) * (SystemCoreClock / TSTAMP_FREQ));
+  }
+}
+
+/**
+  * @brief  Account one latency sample.
+  * @param  Id: interrupt source
+  * @param  Cycles: trigger to handler entry delay in CPU cycles
+  * @retval None
+  */
+__CCMRAM_FUNC void LATENCY_Record(LATENCY_IrqTypeDef Id, uint32_t Cycles)
+{
+  LATENCY_StatsTypeDef *stats = &LatencyStats[Id];
+  uint32_t bin = Cycles >> LATENCY_BIN_SHIFT;
+
+  if(bin >= LATENCY_BINS)
+  {
+    bin = LATENCY_BINS - 1U;
+  }
+
+  stats->Count++;
+  stats->Sum += Cycles;
+  stats->SumSq += (uint64_t)Cycles * Cycles;
+  stats->Hist[bin]++;
+  if(Cycles < stats->Min)
+  {
+    stats->Min = Cycles;
+  }
+  if(Cycles > stats->Max)
+  {
+    stats->Max = Cycles;
+  }
+}
+
+/**
+  * @brief  Take a consistent snapshot of one statistics slot.
+  * @param  Id: interrupt source
+  * @param  pStats: snapshot destination
+  * @retval None
+  */
+void LATENCY_GetStats(LATENCY_IrqTypeDef Id, LATENCY_StatsTypeDef *pStats)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  *pStats = LatencyStats[Id];
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Periodic work, from thread mode with the EXTI0 line enabled:
+  *         software trigger of the EXTI0 probe, report of the statistics.
+  * @param  None
+  * @retval None
+  */
+void LATENCY_Task(void)
+{
+  uint32_t now = HAL_GetTick();
+
+  /* The previous trigger must have been taken, pended IRQs do not queue */
+  if(((now - LatencyProbeTick) >= LATENCY_PROBE_MS) &&
+     ((LatencyArmed & (1U << LATENCY_IRQ_EXTI0)) == 0U))
+  {
+    LatencyProbeTick = now;
+    LATENCY_Trigger(LATENCY_IRQ_EXTI0, EXTI0_IRQn);
+  }
+
+  if((now - LatencyReportTick) >= LATENCY_REPORT_MS)
+  {
+    LatencyReportTick = now;
+    LATENCY_Report();
+  }
+}
+
+/**
+  * @brief  Send the statistics of every source with samples to the deferred
+  *         log, in CPU cycles: count, min, mean, max and standard deviation,
+  *         then the non-empty histogram rows, four bins per row starting at
+  *         the given cycle count.
+  * @param  None
+  * @retval None
+  */
+void LATENCY_Report(void)
+{
+  static const char * const names[LATENCY_IRQ_COUNT] = { "exti0", "systick", "drdy-poll", "drdy-irq" };
+  LATENCY_StatsTypeDef stats;
+  uint32_t i, bin, mean;
+  float variance;
+
+  for(i = 0; i < LATENCY_IRQ_COUNT; i++)
+  {
+    LATENCY_GetStats((LATENCY_IrqTypeDef)i, &stats);
+    if(stats.Count == 0U)
+    {
+      continue;
+    }
+
+    mean = (uint32_t)(stats.Sum / stats.Count);
+    variance = ((float)stats.SumSq / (float)stats.Count) - ((float)mean * (float)mean);
+    DLOG("latency %s n %lu min %lu mean %lu max %lu sd %lu", names[i], stats.Count, stats.Min,
+         mean, stats.Max, (uint32_t)sqrtf((variance > 0.0f) ? variance : 0.0f));
+
+    for(bin = 0; bin < LATENCY_BINS; bin += 4U)
+    {
+      if((stats.Hist[bin] | stats.Hist[bin + 1U] | stats.Hist[bin + 2U] | stats.Hist[bin + 3U]) != 0U)
+      {
+        DLOG("  %s %3lu+: %lu %lu %lu %lu", names[i], bin << LATENCY_BIN_SHIFT, stats.Hist[bin],
+             stats.Hist[bin + 1U], stats.Hist[bin + 2U], stats.Hist[bin + 3U]);
+      }
+    }
+  }
+}
+
+/**
+  * @}
+  */
@@ -0,0 +1,100 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Src/leds.cpp
+  * @brief   The eight user LEDs on GPIOE through gpio_pin.hpp.
+  *
+  *          Every call is a single BSRR store, a toggle adds one ODR load,
+  *          where BSP_LED_On()/Off() index the port and pin tables and go
+  *          through HAL_GPIO_WritePin() for each LED. All eight LEDs are
+  *          set or cleared in the same store. BSP_LED_Init() still
+  *          configures the pins.
+  *
+  *          C++ modules use the pin types directly, the LEDS_xxx functions
+  *          serve the C modules. With link-time optimization (release and
+  *          size profiles) they are inlined into their callers.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "leds.h"
+#include "gpio_pin.hpp"
+
+/** @addtogroup BSP_Examples
+  * @{
+  */
+
+/* Private typedef -----------------------------------------------------------*/
+namespace
+{
+using Led3  = gpio::Pin<gpio::Port::E, 9>;
+using Led4  = gpio::Pin<gpio::Port::E, 8>;
+using Led5  = gpio::Pin<gpio::Port::E, 10>;
+using Led6  = gpio::Pin<gpio::Port::E, 15>;
+using Led7  = gpio::Pin<gpio::Port::E, 11>;
+using Led8  = gpio::Pin<gpio::Port::E, 14>;
+using Led9  = gpio::Pin<gpio::Port::E, 12>;
+using Led10 = gpio::Pin<gpio::Port::E, 13>;
+
+using Leds = gpio::PinGroup<Led3, Led4, Led5, Led6, Led7, Led8, Led9, Led10>;
+
+/* The masks of leds.h must name the same pins as the types */
+static_assert(Leds::Mask<Led3>() == LEDS_LED3, "LED3 is PE9");
+static_assert(Leds::Mask<Led4>() == LEDS_LED4, "LED4 is PE8");
+static_assert(Leds::Mask<Led5>() == LEDS_LED5, "LED5 is PE10");
+static_assert(Leds::Mask<Led6>() == LEDS_LED6, "LED6 is PE15");
+static_assert(Leds::Mask<Led7>() == LEDS_LED7, "LED7 is PE11");
+static_assert(Leds::Mask<Led8>() == LEDS_LED8, "LED8 is PE14");
+static_assert(Leds::Mask<Led9>() == LEDS_LED9, "LED9 is PE12");
+static_assert(Leds::Mask<Led10>() == LEDS_LED10, "LED10 is PE13");
+static_assert(Leds::mask == LEDS_ALL, "eight LEDs on GPIOE");
+}
+
+/* Private define ------------------------------------------------------------*/
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Private function prototypes -----------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Switch LEDs on, the others are left as they are.
+  * @param  Mask: LEDS_LEDx combination
+  * @retval None
+  */
+void LEDS_On(uint16_t Mask)
+{
+  Leds::Modify(Mask, 0U);
+}
+
+/**
+  * @brief  Switch LEDs off, the others are left as they are.
+  * @param  Mask: LEDS_LEDx combination
+  * @retval None
+  */
+void LEDS_Off(uint16_t Mask)
+{
+  Leds::Modify(0U, Mask);
+}
+
+/**
+  * @brief  Toggle LEDs, the others are left as they are.
+  * @param  Mask: LEDS_LEDx combination
+  * @retval None
+  */
+void LEDS_Toggle(uint16_t Mask)
+{
+  Leds::Toggle(Mask);
+}
+
+/**
+  * @brief  Set all eight LEDs at once.
+  * @param  OnMask: LEDS_LEDx combination lit, the other LEDs are switched off
+  * @retval None
+  */
+void LEDS_Write(uint16_t OnMask)
+{
+  Leds::Write(OnMask);
+}
+
+/**
+  * @}
+  */
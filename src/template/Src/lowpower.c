@@ -0,0 +1,318 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Src/lowpower.c
+  * @brief   Tickless idle in SLEEP or STOP mode.
+  *
+  *          While idle the SysTick interrupt is suspended, the core is no
+  *          longer woken every millisecond. The RTC runs on the LSI and
+  *          keeps time instead:
+  *            - its sub-second counter ticks at LSI / 40, about 1 kHz, and
+  *              measures the idle period, which is credited to the HAL
+  *              tick on wakeup, so HAL_GetTick() and the HAL timeouts stay
+  *              consistent
+  *            - its wakeup timer ends the idle period at the next
+  *              scheduled event
+  *          Any enabled interrupt ends it earlier: a FIFO watermark or
+  *          data-ready line on EXTI, the user button.
+  *
+  *          In STOP mode the regulator is in low-power mode and every
+  *          clock stops, timers and serial transfers included. Only EXTI
+  *          lines wake the core, on the HSI: CLOCK_Restore() restarts the
+  *          clocks of the current profile before returning, about 2 ms for
+  *          the HSE and the PLL. STOP therefore pays off between sensor
+  *          batches and in long delays, LPWR_SLEEP suits short ones and
+  *          keeps the peripherals running. CLOCK_PROFILE_HSI_8MHZ resumes
+  *          at once. A STOP request while the telemetry UART transmits
+  *          sleeps instead.
+  *
+  *          The LSI is only accurate to +/-25 %, LPWR_Calibrate() measures
+  *          it against the HSE derived SysTick. HAL_Delay() is overridden
+  *          to sleep instead of spinning once LPWR_Init() has run.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "lowpower.h"
+#include "clock.h"
+#include "wdog.h"
+#include "serial.h"
+#include "dlog.h"
+
+/** @addtogroup BSP_Examples
+  * @{
+  */
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+#define LPWR_RTC_ASYNCH       39U       /* ck_apre = LSI / 40, about 1 kHz */
+#define LPWR_RTC_SYNCH        999U      /* ck_spre = ck_apre / 1000, about 1 Hz */
+#define LPWR_RTC_TICK_DIV     ((LPWR_RTC_ASYNCH + 1U) * 1000U)
+#define LPWR_RTC_TICKS_DAY    (86400U * (LPWR_RTC_SYNCH + 1U))
+#define LPWR_WAKEUP_DIV       16U       /* RTC_WAKEUPCLOCK_RTCCLK_DIV16 */
+#define LPWR_LSI_NOMINAL      40000U
+#define LPWR_CALIB_MS         200U
+
+/* Private macro -------------------------------------------------------------*/
+#define LPWR_BCD(__V__)       ((((__V__) >> 4) * 10U) + ((__V__) & 0x0FU))
+
+/* Private variables ---------------------------------------------------------*/
+static RTC_HandleTypeDef RtcHandle;
+static uint32_t LsiHz = LPWR_LSI_NOMINAL;
+static uint32_t TickRemainder;  /* idle time not yet credited, in ms / LsiHz */
+static uint8_t  LpwrReady;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t LPWR_RtcTicks(void);
+static uint32_t LPWR_RtcElapsed(uint32_t Start);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Start the LSI and the RTC, calibrate the LSI.
+  * @note   Call once the system clock is configured, takes LPWR_CALIB_MS.
+  * @param  None
+  * @retval HAL_ERROR if the RTC cannot be started, idle calls then return
+  *         at once and delays spin
+  */
+HAL_StatusTypeDef LPWR_Init(void)
+{
+  RCC_OscInitTypeDef osc = {0};
+  RCC_PeriphCLKInitTypeDef clk = {0};
+
+  __HAL_RCC_PWR_CLK_ENABLE();
+  HAL_PWR_EnableBkUpAccess();
+
+  osc.OscillatorType = RCC_OSCILLATORTYPE_LSI;
+  osc.LSIState = RCC_LSI_ON;
+  osc.PLL.PLLState = RCC_PLL_NONE;
+  if(HAL_RCC_OscConfig(&osc) != HAL_OK)
+  {
+    return HAL_ERROR;
+  }
+
+  clk.PeriphClockSelection = RCC_PERIPHCLK_RTC;
+  clk.RTCClockSelection = RCC_RTCCLKSOURCE_LSI;
+  if(HAL_RCCEx_PeriphCLKConfig(&clk) != HAL_OK)
+  {
+    return HAL_ERROR;
+  }
+  __HAL_RCC_RTC_ENABLE();
+
+  RtcHandle.Instance = RTC;
+  RtcHandle.Init.HourFormat = RTC_HOURFORMAT_24;
+  RtcHandle.Init.AsynchPrediv = LPWR_RTC_ASYNCH;
+  RtcHandle.Init.SynchPrediv = LPWR_RTC_SYNCH;
+  RtcHandle.Init.OutPut = RTC_OUTPUT_DISABLE;
+  RtcHandle.Init.OutPutPolarity = RTC_OUTPUT_POLARITY_HIGH;
+  RtcHandle.Init.OutPutType = RTC_OUTPUT_TYPE_OPENDRAIN;
+  if(HAL_RTC_Init(&RtcHandle) != HAL_OK)
+  {
+    return HAL_ERROR;
+  }
+
+  /* Read the counters directly: the shadow registers only resynchronise
+     two RTC clocks, about 2 ms, after a wakeup from STOP */
+  HAL_RTCEx_EnableBypassShadow(&RtcHandle);
+
+  HAL_NVIC_SetPriority(RTC_WKUP_IRQn, TICK_INT_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(RTC_WKUP_IRQn);
+
+#ifndef NDEBUG
+  /* Keep the debug port alive in STOP, at the cost of the regulator
+     staying in run mode */
+  HAL_DBGMCU_EnableDBGStopMode();
+#endif /* NDEBUG */
+
+  LPWR_Calibrate();
+  LpwrReady = 1;
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Measure the LSI frequency against SysTick.
+  * @note   The LSI drifts with temperature and supply, call again from
+  *         time to time on long deployments. Busy for LPWR_CALIB_MS.
+  * @param  None
+  * @retval None
+  */
+void LPWR_Calibrate(void)
+{
+  uint32_t start, ticks;
+
+  /* Start on a SysTick edge, the RTC reading is then the only rounding */
+  start = HAL_GetTick();
+  while(HAL_GetTick() == start)
+  {
+  }
+  start = HAL_GetTick();
+  ticks = LPWR_RtcTicks();
+  while((HAL_GetTick() - start) < LPWR_CALIB_MS)
+  {
+  }
+  ticks = LPWR_RtcElapsed(ticks);
+
+  if(ticks != 0U)
+  {
+    LsiHz = (ticks * LPWR_RTC_TICK_DIV) / LPWR_CALIB_MS;
+  }
+}
+
+/**
+  * @brief  Idle until an interrupt or the timeout, without SysTick wakeups.
+  * @param  Mode: LPWR_SLEEP or LPWR_STOP
+  * @param  Timeout: in ms, at most LPWR_MAX_IDLE_MS, or LPWR_WAIT_FOREVER.
+  *         WDOG_MAX_IDLE_MS at most once the watchdog runs.
+  * @retval Idle time in ms, already credited to HAL_GetTick()
+  */
+uint32_t LPWR_Idle(LPWR_ModeTypeDef Mode, uint32_t Timeout)
+{
+  uint32_t start, counter, ms, i;
+  uint64_t elapsed;
+
+  if((LpwrReady == 0U) || (Timeout == 0U))
+  {
+    return 0;
+  }
+
+  /* The IWDG counts on without SysTick: feed it, and wake up in time */
+  if(WDOG_IsRunning() != 0U)
+  {
+    WDOG_Service();
+    if(Timeout > WDOG_MAX_IDLE_MS)
+    {
+      Timeout = WDOG_MAX_IDLE_MS;
+    }
+  }
+
+  if(Timeout != LPWR_WAIT_FOREVER)
+  {
+    if(Timeout > LPWR_MAX_IDLE_MS)
+    {
+      Timeout = LPWR_MAX_IDLE_MS;
+    }
+    counter = (Timeout * LsiHz) / (LPWR_WAKEUP_DIV * 1000U);
+    HAL_RTCEx_SetWakeUpTimer_IT(&RtcHandle, (counter > 0U) ? (counter - 1U) : 0U,
+                                RTC_WAKEUPCLOCK_RTCCLK_DIV16);
+  }
+
+  /* STOP would freeze the telemetry UART in the middle of a character */
+  if((Mode == LPWR_STOP) && (SERIAL_IsBusy() != 0U))
+  {
+    Mode = LPWR_SLEEP;
+  }
+
+  HAL_SuspendTick();
+  start = LPWR_RtcTicks();
+
+  if(Mode == LPWR_STOP)
+  {
+    HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+    /* Running on the HSI, back to the clocks of the profile */
+    CLOCK_Restore();
+  }
+  else
+  {
+    HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+  }
+
+  /* Credit the idle time to the HAL tick, carrying the fraction of a ms */
+  elapsed = ((uint64_t)LPWR_RtcElapsed(start) * LPWR_RTC_TICK_DIV) + TickRemainder;
+  ms = (uint32_t)(elapsed / LsiHz);
+  TickRemainder = (uint32_t)(elapsed % LsiHz);
+  for(i = 0; i < ms; i++)
+  {
+    HAL_IncTick();
+  }
+  HAL_ResumeTick();
+
+  if(Timeout != LPWR_WAIT_FOREVER)
+  {
+    HAL_RTCEx_DeactivateWakeUpTimer(&RtcHandle);
+  }
+
+  return ms;
+}
+
+/**
+  * @brief  Wait for a number of ms in a low-power mode.
+  * @note   The last LPWR_STOP_MIN_MS of a STOP delay are spent in SLEEP.
+  *         Each idle period starts with DLOG_Flush(), so every HAL_Delay()
+  *         of the demos drains the deferred log.
+  *         Spins like the HAL delay from interrupt handlers and before
+  *         LPWR_Init().
+  * @param  Delay: in ms
+  * @param  Mode: LPWR_SLEEP or LPWR_STOP
+  * @retval None
+  */
+void LPWR_Delay(uint32_t Delay, LPWR_ModeTypeDef Mode)
+{
+  uint32_t start = HAL_GetTick();
+  uint32_t left;
+
+  while((HAL_GetTick() - start) < Delay)
+  {
+    if((LpwrReady != 0U) && (__get_IPSR() == 0U))
+    {
+      DLOG_Flush();
+      left = Delay - (HAL_GetTick() - start);
+      LPWR_Idle((left >= LPWR_STOP_MIN_MS) ? Mode : LPWR_SLEEP, left);
+    }
+  }
+}
+
+/**
+  * @brief  HAL delay, sleeps instead of spinning.
+  * @param  Delay: in ms
+  * @retval None
+  */
+void HAL_Delay(uint32_t Delay)
+{
+  LPWR_Delay(Delay, LPWR_SLEEP);
+}
+
+/**
+  * @brief  RTC wakeup timer interrupt, called from RTC_WKUP_IRQHandler().
+  * @param  None
+  * @retval None
+  */
+void LPWR_IRQHandler(void)
+{
+  HAL_RTCEx_WakeUpTimerIRQHandler(&RtcHandle);
+}
+
+/**
+  * @brief  RTC time of day in sub-second ticks.
+  * @param  None
+  * @retval Ticks of LPWR_RTC_TICK_DIV / LsiHz ms since midnight
+  */
+static uint32_t LPWR_RtcTicks(void)
+{
+  uint32_t ssr, tr, seconds;
+
+  /* Shadow registers bypassed: read until no second boundary in between */
+  do
+  {
+    ssr = RTC->SSR;
+    tr = RTC->TR;
+  } while(ssr != RTC->SSR);
+
+  seconds = (LPWR_BCD((tr >> 16) & 0x3FU) * 3600U) + (LPWR_BCD((tr >> 8) & 0x7FU) * 60U) +
+            LPWR_BCD(tr & 0x7FU);
+
+  return (seconds * (LPWR_RTC_SYNCH + 1U)) + (LPWR_RTC_SYNCH - (ssr & RTC_SSR_SS));
+}
+
+/**
+  * @brief  RTC ticks since a reading of LPWR_RtcTicks(), across midnight.
+  * @param  Start: earlier reading
+  * @retval Ticks
+  */
+static uint32_t LPWR_RtcElapsed(uint32_t Start)
+{
+  return (LPWR_RtcTicks() + LPWR_RTC_TICKS_DAY - Start) % LPWR_RTC_TICKS_DAY;
+}
+
+/**
+  * @}
+  */
@@ -38,6 +38,8 @@
 /* Includes ------------------------------------------------------------------*/
 #include <../Components/lsm303dlhc/lsm303dlhc.h>
 #include <../Components/l3gd20/l3gd20.h>
+#include "mems_drv.h"
+#include "mems_conv.h"
 
 /** @addtogroup BSP
   * @{
@@ -62,6 +64,29 @@
 /** @defgroup LSM303DLHC_Private_Defines
   * @{
   */
+/* Magnetometer registers, not all component header releases carry them */
+#ifndef MAG_I2C_ADDRESS
+ #define MAG_I2C_ADDRESS                   0x3C
+#endif
+#ifndef LSM303DLHC_CRA_REG_M
+ #define LSM303DLHC_CRA_REG_M              0x00  /* Control register A magnetic field */
+#endif
+#ifndef LSM303DLHC_CRB_REG_M
+ #define LSM303DLHC_CRB_REG_M              0x01  /* Control register B magnetic field */
+#endif
+#ifndef LSM303DLHC_MR_REG_M
+ #define LSM303DLHC_MR_REG_M               0x02  /* Control register MR magnetic field */
+#endif
+#ifndef LSM303DLHC_OUT_X_H_M
+ #define LSM303DLHC_OUT_X_H_M              0x03  /* Output Register X magnetic field, then Z then Y */
+#endif
+#ifndef LSM303DLHC_SR_REG_M
+ #define LSM303DLHC_SR_REG_M               0x09  /* Status Register magnetic field */
+#endif
+
+/* Sub-address MSB: the register address increments after each byte, so
+   the six output registers come in one I2C transfer */
+#define LSM303DLHC_SUB_INCREMENT           0x80
 
 /**
   * @}
@@ -95,6 +120,9 @@ ACCELERO_DrvTypeDef Lsm303dlhcDrv =
   LSM303DLHC_AccReadXYZ
 };
 
+/* Sensitivity of the full scale written by LSM303DLHC_AccInit() */
+static int16_t Lsm303dlhcAccGain = LSM303DLHC_ACC_SENSITIVITY_2G;
+
 /**
   * @}
   */
@@ -122,6 +150,23 @@ void LSM303DLHC_AccInit(uint16_t InitStruct)
   /* Write value to ACC MEMS CTRL_REG4 register */
   ctrl = (uint8_t) (InitStruct << 8);
   COMPASSACCELERO_IO_Write(ACC_I2C_ADDRESS, LSM303DLHC_CTRL_REG4_A, ctrl);
+  
+  /* Sensitivity of this full scale, for LSM303DLHC_AccReadXYZ() */
+  switch(ctrl & LSM303DLHC_FULLSCALE_16G)
+  {
+  case LSM303DLHC_FULLSCALE_4G:
+    Lsm303dlhcAccGain = LSM303DLHC_ACC_SENSITIVITY_4G;
+    break;
+  case LSM303DLHC_FULLSCALE_8G:
+    Lsm303dlhcAccGain = LSM303DLHC_ACC_SENSITIVITY_8G;
+    break;
+  case LSM303DLHC_FULLSCALE_16G:
+    Lsm303dlhcAccGain = LSM303DLHC_ACC_SENSITIVITY_16G;
+    break;
+  default:
+    Lsm303dlhcAccGain = LSM303DLHC_ACC_SENSITIVITY_2G;
+    break;
+  }
 }
 
 /**
@@ -214,70 +259,107 @@ void LSM303DLHC_AccFilterCmd(uint8_t HighPassFilterState)
 
 /**
   * @brief  Read X, Y & Z Acceleration values 
-  * @param  pData: Data out pointer
+  * @param  pData: Data out pointer, left aligned samples times the
+  *         sensitivity of the full scale
   * @retval None
   */
 void LSM303DLHC_AccReadXYZ(int16_t* pData)
 {
   int16_t pnRawData[3];
-  uint8_t ctrlx[2]={0,0};
-  int8_t buffer[6];
-  uint8_t i = 0;
-  uint8_t sensitivity = LSM303DLHC_ACC_SENSITIVITY_2G;
-  
-  /* Read the acceleration control register content */
-  ctrlx[0] = COMPASSACCELERO_IO_Read(ACC_I2C_ADDRESS, LSM303DLHC_CTRL_REG4_A);
-  ctrlx[1] = COMPASSACCELERO_IO_Read(ACC_I2C_ADDRESS, LSM303DLHC_CTRL_REG5_A);
-  
-  /* Read output register X, Y & Z acceleration */
-  buffer[0] = COMPASSACCELERO_IO_Read(ACC_I2C_ADDRESS, LSM303DLHC_OUT_X_L_A); 
-  buffer[1] = COMPASSACCELERO_IO_Read(ACC_I2C_ADDRESS, LSM303DLHC_OUT_X_H_A);
-  buffer[2] = COMPASSACCELERO_IO_Read(ACC_I2C_ADDRESS, LSM303DLHC_OUT_Y_L_A);
-  buffer[3] = COMPASSACCELERO_IO_Read(ACC_I2C_ADDRESS, LSM303DLHC_OUT_Y_H_A);
-  buffer[4] = COMPASSACCELERO_IO_Read(ACC_I2C_ADDRESS, LSM303DLHC_OUT_Z_L_A);
-  buffer[5] = COMPASSACCELERO_IO_Read(ACC_I2C_ADDRESS, LSM303DLHC_OUT_Z_H_A);
-  
-  /* Check in the control register4 the data alignment*/
-  if(!(ctrlx[0] & LSM303DLHC_BLE_MSB)) 
+  int32_t scaled[3];
+  uint8_t i;
+  
+  LSM303DLHC_AccReadXYZRaw(pnRawData);
+  
+  MEMSCONV_ScaleQ(pnRawData, Lsm303dlhcAccGain, 0, scaled);
+  for(i=0; i<3; i++)
   {
-    for(i=0; i<3; i++)
-    {
-      pnRawData[i]=((int16_t)((uint16_t)buffer[2*i+1] << 8) + buffer[2*i]);
-    }
+    pData[i] = (int16_t)scaled[i];
   }
-  else /* Big Endian Mode */
+}
+
+/**
+  * @brief  Read X, Y & Z acceleration registers without scaling
+  * @param  pData: Data out pointer, left aligned 12-bit samples in LSB
+  * @retval None
+  */
+void LSM303DLHC_AccReadXYZRaw(int16_t* pData)
+{
+  uint8_t ctrl4;
+  uint8_t buffer[6];
+  
+  ctrl4 = COMPASSACCELERO_IO_Read(ACC_I2C_ADDRESS, LSM303DLHC_CTRL_REG4_A);
+  
+  COMPASSACCELERO_IO_ReadBuffer(ACC_I2C_ADDRESS, LSM303DLHC_OUT_X_L_A | LSM303DLHC_SUB_INCREMENT, buffer, 6);
+  
+  /* Packed halfwords, see mems_conv.h */
+  if(!(ctrl4 & LSM303DLHC_BLE_MSB))
+  {
+    MEMSCONV_Le(buffer, pData);
+  }
+  else
   {
-    for(i=0; i<3; i++)
-    {
-      pnRawData[i]=((int16_t)((uint16_t)buffer[2*i] << 8) + buffer[2*i+1]);
-    }
+    MEMSCONV_Be(buffer, pData);
   }
+}
+
+/**
+  * @brief  Sensitivity of the configured full scale, normal mode.
+  * @param  None
+  * @retval mg per LSB of the left aligned 16-bit value
+  */
+float LSM303DLHC_AccGetSensitivity(void)
+{
+  uint8_t ctrl4 = COMPASSACCELERO_IO_Read(ACC_I2C_ADDRESS, LSM303DLHC_CTRL_REG4_A);
   
-  /* Normal mode */
-  /* Switch the sensitivity value set in the CRTL4 */
-  switch(ctrlx[0] & LSM303DLHC_FULLSCALE_16G)
+  /* Datasheet values are per 12-bit LSB, the output is shifted left by 4 */
+  switch(ctrl4 & LSM303DLHC_FULLSCALE_16G)
   {
-  case LSM303DLHC_FULLSCALE_2G:
-    sensitivity = LSM303DLHC_ACC_SENSITIVITY_2G;
-    break;
   case LSM303DLHC_FULLSCALE_4G:
-    sensitivity = LSM303DLHC_ACC_SENSITIVITY_4G;
-    break;
+    return 2.0f / 16.0f;
   case LSM303DLHC_FULLSCALE_8G:
-    sensitivity = LSM303DLHC_ACC_SENSITIVITY_8G;
-    break;
+    return 4.0f / 16.0f;
   case LSM303DLHC_FULLSCALE_16G:
-    sensitivity = LSM303DLHC_ACC_SENSITIVITY_16G;
-    break;
-  }
-  
-  /* Obtain the mg value for the three axis */
-  for(i=0; i<3; i++)
-  {
-    pData[i]=(pnRawData[i] * sensitivity);
+    return 12.0f / 16.0f;
+  case LSM303DLHC_FULLSCALE_2G:
+  default:
+    return 1.0f / 16.0f;
   }
 }
 
+/**
+  * @brief  Configure the LSM303DLHC magnetometer.
+  * @param  DataRate: CRA_REG_M value, e.g. LSM303DLHC_MAG_ODR_220_HZ
+  * @param  FullScale: CRB_REG_M value, e.g. LSM303DLHC_MAG_FS_1_3_GA
+  * @param  Mode: MR_REG_M value, LSM303DLHC_MAG_CONTINUOUS or LSM303DLHC_MAG_SLEEP
+  * @retval None
+  */
+void LSM303DLHC_MagInit(uint8_t DataRate, uint8_t FullScale, uint8_t Mode)
+{
+  COMPASSACCELERO_IO_Write(MAG_I2C_ADDRESS, LSM303DLHC_CRA_REG_M, DataRate);
+  COMPASSACCELERO_IO_Write(MAG_I2C_ADDRESS, LSM303DLHC_CRB_REG_M, FullScale);
+  COMPASSACCELERO_IO_Write(MAG_I2C_ADDRESS, LSM303DLHC_MR_REG_M, Mode);
+}
+
+/**
+  * @brief  Read X, Y & Z magnetic field raw values
+  * @param  pData: Data out pointer, X, Y, Z in LSB, see LSM303DLHC_MAG_LSB_PER_GAUSS_*
+  * @retval None
+  */
+void LSM303DLHC_MagReadXYZ(int16_t* pData)
+{
+  uint8_t buffer[6];
+  int16_t xzy[3];
+
+  /* Output registers are big endian and ordered X, Z, Y */
+  COMPASSACCELERO_IO_ReadBuffer(MAG_I2C_ADDRESS, LSM303DLHC_OUT_X_H_M | LSM303DLHC_SUB_INCREMENT, buffer, 6);
+
+  MEMSCONV_Be(buffer, xzy);
+  pData[0] = xzy[0];
+  pData[1] = xzy[2];
+  pData[2] = xzy[1];
+}
+
 /**
   * @brief  Enable or Disable High Pass Filter on CLick
   * @param  HighPassFilterState: new state of the High Pass Filter feature.
@@ -46,12 +46,20 @@
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
+/* Edges of a bouncing user button within this time count as one press */
+#define BUTTON_DEBOUNCE_MS    200U
+
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 uint8_t DemoIndex = 0;
 BSP_DemoTypedef  BSP_examples[]={
   {ACCELERO_MEMS_Test, "LSM303DLHC", 1}, 
   {GYRO_MEMS_Test, "L3GD20", 0},
+  {AHRS_MEMS_Test, "AHRS", 2},
+  {CALIB_MEMS_Test, "CALIB", 3},
+  {FLOG_MEMS_Test, "FLOG", 4},
+  {BATCH_MEMS_Test, "BATCH", 5},
+  {CONV_MEMS_Test, "CONV", 6},
 };
 
 __IO uint8_t UserPressButton = 0;
@@ -59,8 +67,18 @@ __IO uint8_t UserPressButton = 0;
 /* Counter for User button presses*/
 __IO uint32_t PressCount = 0;
 
+#ifdef USE_REPLAY
+/* LOG region of default/STM32F303VCTx_FLASH.ld */
+extern uint32_t _sflashlog[];
+extern uint32_t _eflashlog[];
+#endif
+
 /* Private function prototypes -----------------------------------------------*/
 static void SystemClock_Config(void);
+static void Boot_Report(void);
+#ifdef USE_REPLAY
+static uint32_t Replay_Micros(void);
+#endif
 
 /* Private functions ---------------------------------------------------------*/
 
@@ -85,6 +103,45 @@ int main(void)
   
   /* Configure the system clock to 72 Mhz */
   SystemClock_Config();
+
+  /* Deferred log: DLOG() records from here on, sent by DLOG_Flush() once
+     the telemetry UART is up */
+  DLOG_Init();
+
+  /* Start the DWT cycle counter used by the interrupt latency probes */
+  LATENCY_Init();
+
+  /* Prepare the sample block pool of the recorder and the batch demo */
+  MEMPOOL_InitPools();
+
+  /* Index the persistent settings, formats the store on first boot */
+  KV_Init();
+
+  /* Keep the crash dump of a fault that caused the last reset */
+  FAULT_Init();
+
+  /* Locate the end of the sensor log */
+  FLOG_Init();
+
+#ifdef USE_REPLAY
+  /* Replay build: the sensors read back the last recorded session. Without
+     a recording they stay live. */
+  REPLAY_Init((const uint8_t *)_sflashlog, (uint32_t)_eflashlog - (uint32_t)_sflashlog);
+  REPLAY_Start(REPLAY_LAST_SESSION, REPLAY_SPEED, Replay_Micros);
+#endif
+
+  /* RTC wakeup timer for the tickless idle, HAL_Delay() sleeps from now on */
+  LPWR_Init();
+
+  /* Log the reset cause, then the main loop must check in every 3 s */
+  WDOG_Init();
+
+  /* Telemetry UART, DLOG_Flush() and printf go there from now on */
+  if(SERIAL_Init() == HAL_OK)
+  {
+    Boot_Report();
+    DLOG_Flush();
+  }
   
   /* Initialize LEDs and User_Button on STM32F3-Discovery ------------------*/
   BSP_LED_Init(LED4);
@@ -100,10 +157,7 @@ int main(void)
   
   /* Toggle LEDs between each Test */
   while (!UserPressButton) Toggle_Leds();
-  BSP_LED_Off(LED3);
-  BSP_LED_Off(LED4);
-  BSP_LED_Off(LED5);
-  BSP_LED_Off(LED6);
+  LEDS_Off(LEDS_LED3 | LEDS_LED4 | LEDS_LED5 | LEDS_LED6);
 
   /* 1. Start Test: Wait For User inputs -------------------------------------*/
   while (1)
@@ -119,10 +173,7 @@ int main(void)
     /* Toggle LEDs between each Test */
     UserPressButton = 0;
     while (!UserPressButton) Toggle_Leds();
-    BSP_LED_Off(LED3);
-    BSP_LED_Off(LED4);
-    BSP_LED_Off(LED5);
-    BSP_LED_Off(LED6);
+    LEDS_Off(LEDS_LED3 | LEDS_LED4 | LEDS_LED5 | LEDS_LED6);
   }
 }
 
@@ -139,66 +190,100 @@ int main(void)
   *            HSE PREDIV                     = 1
   *            PLLMUL                         = 9
   *            Flash Latency(WS)              = 2
+  *         Slower profiles are selected at run time with CLOCK_SetProfile().
   * @param  None
   * @retval None
   */
 static void SystemClock_Config(void)
 {
-RCC_ClkInitTypeDef RCC_ClkInitStruct;
-RCC_OscInitTypeDef RCC_OscInitStruct;
-
-  #ifdef USE_FULL_ASSERT
-  uint32_t ret = HAL_OK;
-  #endif /* USE_FULL_ASSERT */
-  
-  /* Enable HSE Oscillator and activate PLL with HSE as source */
-  RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSE;
-  RCC_OscInitStruct.HSEState = RCC_HSE_ON;
-  RCC_OscInitStruct.HSEPredivValue = RCC_HSE_PREDIV_DIV1;
-  RCC_OscInitStruct.PLL.PLLState = RCC_PLL_ON;
-  RCC_OscInitStruct.PLL.PLLSource = RCC_PLLSOURCE_HSE;
-  RCC_OscInitStruct.PLL.PLLMUL = RCC_PLL_MUL9;
-
 #ifdef USE_FULL_ASSERT
-  ret = HAL_RCC_OscConfig(&RCC_OscInitStruct);
-  if(ret != HAL_OK)
+  if(CLOCK_SetProfile(CLOCK_PROFILE_72MHZ) != HAL_OK)
   {
     assert_failed((char *)__FILE__, __LINE__);
   }
 #else
-  HAL_RCC_OscConfig(&RCC_OscInitStruct);
+  CLOCK_SetProfile(CLOCK_PROFILE_72MHZ);
 #endif /* USE_FULL_ASSERT */
-    	
-  /* Select PLL as system clock source and configure the HCLK, PCLK1 and PCLK2 
-     clocks dividers */
-  RCC_ClkInitStruct.ClockType = (RCC_CLOCKTYPE_SYSCLK | RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2);
-  RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
-  RCC_ClkInitStruct.AHBCLKDivider = RCC_SYSCLK_DIV1;
-  RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV2;  
-  RCC_ClkInitStruct.APB2CLKDivider = RCC_HCLK_DIV1;
+}
 
-#ifdef USE_FULL_ASSERT
-  ret = HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_2);
-  if(ret != HAL_OK)
+/**
+  * @brief  Reset cause, and the crash dump when a fault caused the reset, in
+  *         the deferred log. The full record, stack snapshot included, then
+  *         goes to the UART as is, for tools/crashdump.py. Called before the
+  *         first DLOG_Flush(): the transmit ring is empty and holds it.
+  * @param  None
+  * @retval None
+  */
+static void Boot_Report(void)
+{
+  static const char * const causes[WDOG_RESET_COUNT] =
   {
-    assert_failed((char *)__FILE__, __LINE__);
+    "power", "pin", "software", "iwdg", "wwdg", "lowpower", "option"
+  };
+  const WDOG_ResetLogTypeDef *log = WDOG_GetResetLog();
+  const FAULT_RecordTypeDef *fault = FAULT_GetLast();
+  WDOG_ResetTypeDef cause = WDOG_GetResetCause();
+
+  if((cause == WDOG_RESET_IWDG) && (log->LastTask != WDOG_NO_TASK))
+  {
+    DLOG("reset %s, task %lu", causes[cause], log->LastTask);
+  }
+  else
+  {
+    DLOG("reset %s", causes[cause]);
+  }
+
+  if(FAULT_IsNew() && (fault != NULL))
+  {
+    DLOG("fault ipsr %lu pc %08lx lr %08lx sp %08lx", fault->Ipsr, fault->Pc, fault->Lr, fault->Sp);
+    DLOG("      cfsr %08lx hfsr %08lx mmfar %08lx bfar %08lx", fault->Cfsr, fault->Hfsr,
+         fault->Mmfar, fault->Bfar);
+    SERIAL_Write(fault, sizeof(FAULT_RecordTypeDef));
   }
-#else
-  HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_2);
-#endif /* USE_FULL_ASSERT */
 }
 
+#ifdef USE_REPLAY
 /**
-  * @brief  EXTI line detection callbacks.
+  * @brief  Microseconds since boot, paces the replay.
+  *         TIM2 of tstamp.c is restarted by every demo, the SysTick is not.
+  * @param  None
+  * @retval Time in us, modulo 2^32
+  */
+static uint32_t Replay_Micros(void)
+{
+  uint32_t tick, val;
+
+  /* Read again if the millisecond rolled over in between */
+  do
+  {
+    tick = HAL_GetTick();
+    val = SysTick->VAL;
+  } while(tick != HAL_GetTick());
+
+  return (tick * 1000U) + (((SysTick->LOAD - val) * 1000U) / (SysTick->LOAD + 1U));
+}
+#endif
+
+/**
+  * @brief  EXTI line detection callbacks, in CCM-RAM with EXTI0_IRQHandler().
   * @param  GPIO_Pin: Specifies the pins connected EXTI line
   * @retval None
   */
-void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+__CCMRAM_FUNC void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
 {
+  static uint32_t lastPress;
+  uint32_t now;
+
   if (USER_BUTTON_PIN == GPIO_Pin)
   {
-    while (BSP_PB_GetState(BUTTON_USER) != RESET);
-    UserPressButton = 1;
+    /* Act on the press, no waiting for the release inside the interrupt */
+    now = HAL_GetTick();
+    if ((now - lastPress) >= BUTTON_DEBOUNCE_MS)
+    {
+      lastPress = now;
+      PressCount++;
+      UserPressButton = 1;
+    }
   } 
 }
 
@@ -209,22 +294,24 @@ void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
   */
 void Toggle_Leds(void)
 {
-    BSP_LED_Toggle(LED3);
-    HAL_Delay(100);
-    BSP_LED_Toggle(LED4);
-    HAL_Delay(100);
-    BSP_LED_Toggle(LED6);
-    HAL_Delay(100);
-    BSP_LED_Toggle(LED8);
-    HAL_Delay(100);
-    BSP_LED_Toggle(LED10);
-    HAL_Delay(100);
-    BSP_LED_Toggle(LED9);
-    HAL_Delay(100);
-    BSP_LED_Toggle(LED7);
-    HAL_Delay(100);
-    BSP_LED_Toggle(LED5);
-    HAL_Delay(100);
+    WDOG_CheckIn(WDOG_TASK_MAIN);
+    LATENCY_Task();
+    LEDS_Toggle(LEDS_LED3);
+    LPWR_Delay(100, LPWR_STOP);
+    LEDS_Toggle(LEDS_LED4);
+    LPWR_Delay(100, LPWR_STOP);
+    LEDS_Toggle(LEDS_LED6);
+    LPWR_Delay(100, LPWR_STOP);
+    LEDS_Toggle(LEDS_LED8);
+    LPWR_Delay(100, LPWR_STOP);
+    LEDS_Toggle(LEDS_LED10);
+    LPWR_Delay(100, LPWR_STOP);
+    LEDS_Toggle(LEDS_LED9);
+    LPWR_Delay(100, LPWR_STOP);
+    LEDS_Toggle(LEDS_LED7);
+    LPWR_Delay(100, LPWR_STOP);
+    LEDS_Toggle(LEDS_LED5);
+    LPWR_Delay(100, LPWR_STOP);
 }
 
 /**
@@ -253,8 +340,9 @@ void Error_Handler(void)
   */
 void assert_failed(char* file, uint32_t line)
 { 
-  /* User can add his own implementation to report the file name and line number,
-     ex: printf("Wrong parameters value: file %s on line %d\r\n", file, line) */
+  /* __FILE__ is a literal in flash, the decoder reads it from the ELF */
+  DLOG("assert %s:%lu", file, line);
+  DLOG_Flush();
 
   /* Infinite loop */
   while (1)
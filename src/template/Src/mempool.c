@@ -0,0 +1,169 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Src/mempool.c
+  * @brief   Fixed-block memory pools.
+  *
+  *          Each pool is a compile-time sized array carved into equal blocks
+  *          chained in a free list. Alloc and free pop/push the list head
+  *          inside a short PRIMASK section, so both are O(1) and may be
+  *          called from thread and interrupt context alike. A block filled
+  *          by an ISR can be handed to the main loop by pointer, no copy.
+  *
+  *          A bit per block records whether it is allocated: freeing a
+  *          block twice, or one never allocated, is refused instead of
+  *          corrupting the free list.
+  *
+  *          Pools live in main SRAM and can therefore be used as DMA buffers.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "mempool.h"
+
+/** @addtogroup BSP_Examples
+  * @{
+  */
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+MEMPOOL_DEFINE(MEMPOOL_Sample, MEMPOOL_SAMPLE_BLOCK_SIZE, MEMPOOL_SAMPLE_BLOCK_COUNT);
+
+/* Private function prototypes -----------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Initialize the application pools.
+  * @param  None
+  * @retval None
+  */
+void MEMPOOL_InitPools(void)
+{
+  MEMPOOL_Init(&MEMPOOL_Sample);
+}
+
+/**
+  * @brief  Chain all blocks of a pool into its free list and clear the statistics.
+  * @param  hpool: pool handle
+  * @retval None
+  */
+void MEMPOOL_Init(MEMPOOL_HandleTypeDef *hpool)
+{
+  uint32_t primask = __get_PRIMASK();
+  uint8_t *block;
+  uint32_t i;
+
+  __disable_irq();
+  hpool->FreeList = 0;
+  for(i = hpool->BlockCount; i > 0; i--)
+  {
+    block = hpool->Storage + ((i - 1U) * hpool->BlockSize);
+    *(void **)block = hpool->FreeList;
+    hpool->FreeList = block;
+  }
+  for(i = 0; i < ((hpool->BlockCount + 31U) / 32U); i++)
+  {
+    hpool->InUse[i] = 0;
+  }
+  hpool->Used = 0;
+  hpool->HighWater = 0;
+  hpool->Failed = 0;
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Take one block from a pool.
+  * @param  hpool: pool handle
+  * @retval Pointer to the block, NULL when the pool is exhausted
+  */
+void *MEMPOOL_Alloc(MEMPOOL_HandleTypeDef *hpool)
+{
+  uint32_t primask = __get_PRIMASK();
+  void *block;
+  uint32_t index;
+
+  __disable_irq();
+  block = hpool->FreeList;
+  if(block != 0)
+  {
+    hpool->FreeList = *(void **)block;
+    index = (uint32_t)((uint8_t *)block - hpool->Storage) / hpool->BlockSize;
+    hpool->InUse[index / 32U] |= 1UL << (index % 32U);
+    if(++hpool->Used > hpool->HighWater)
+    {
+      hpool->HighWater = hpool->Used;
+    }
+  }
+  else
+  {
+    hpool->Failed++;
+  }
+  __set_PRIMASK(primask);
+
+  return block;
+}
+
+/**
+  * @brief  Return a block to the pool it was taken from.
+  * @param  hpool: pool handle
+  * @param  pBlock: block returned by MEMPOOL_Alloc()
+  * @retval HAL_ERROR if pBlock does not belong to the pool or is not
+  *         allocated (freed twice), the pool is left unchanged
+  */
+HAL_StatusTypeDef MEMPOOL_Free(MEMPOOL_HandleTypeDef *hpool, void *pBlock)
+{
+  uint32_t primask;
+  uint32_t offset = (uint32_t)((uint8_t *)pBlock - hpool->Storage);
+  uint32_t index, mask;
+  HAL_StatusTypeDef status = HAL_OK;
+
+  if((pBlock == 0) || ((uint8_t *)pBlock < hpool->Storage) ||
+     (offset >= ((uint32_t)hpool->BlockSize * hpool->BlockCount)) ||
+     ((offset % hpool->BlockSize) != 0U))
+  {
+    return HAL_ERROR;
+  }
+  index = offset / hpool->BlockSize;
+  mask = 1UL << (index % 32U);
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+  if((hpool->InUse[index / 32U] & mask) == 0U)
+  {
+    status = HAL_ERROR;
+  }
+  else
+  {
+    hpool->InUse[index / 32U] &= ~mask;
+    *(void **)pBlock = hpool->FreeList;
+    hpool->FreeList = pBlock;
+    hpool->Used--;
+  }
+  __set_PRIMASK(primask);
+
+  return status;
+}
+
+/**
+  * @brief  Read the usage statistics of a pool.
+  * @param  hpool: pool handle
+  * @param  pStats: snapshot destination
+  * @retval None
+  */
+void MEMPOOL_GetStats(MEMPOOL_HandleTypeDef *hpool, MEMPOOL_StatsTypeDef *pStats)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  pStats->BlockSize = hpool->BlockSize;
+  pStats->BlockCount = hpool->BlockCount;
+  pStats->Used = hpool->Used;
+  pStats->HighWater = hpool->HighWater;
+  pStats->Failed = hpool->Failed;
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @}
+  */
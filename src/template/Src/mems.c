@@ -35,22 +35,99 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "mems.h"
+#include "mems_drv.h"
+#include "ahrs.h"
+#include "calib.h"
+#include "kvstore.h"
+#include "flashlog.h"
+#include "tstamp.h"
+#include "lowpower.h"
+#include "replay.h"
+#include "leds.h"
+#include "sensors.h"
+#include "convbench.h"
+#include "filter.h"
+#include "filterbench.h"
+#include "sections.h"
+#include <math.h>
+#include <stdlib.h>
 
 /** @addtogroup BSP_Examples
   * @{
   */ 
 
 /* Private typedef -----------------------------------------------------------*/
+/**
+  * @brief Gyroscope batch, one mempool.c sample block
+  */
+typedef struct
+{
+  int16_t Fifo[L3GD20_FIFO_DEPTH * 3];      /*!< X, Y, Z as read from the FIFO */
+  q15_t   Axis[3][L3GD20_FIFO_DEPTH];       /*!< One channel per axis */
+  q15_t   Rate[2][L3GD20_FIFO_DEPTH];       /*!< X and Y after the lowpass */
+} BATCH_BufferTypeDef;
+
 /* Private define ------------------------------------------------------------*/
+/* Fusion runs at the L3GD20 output data rate */
+#define AHRS_SAMPLE_FREQ      760.0f
+/* Acceleration and field are read every n-th gyro sample, one I2C register
+   read costs more bus time than a gyro sample period */
+#define AHRS_ACC_DECIMATION   8U
+#define AHRS_SECTOR           (3.14159265f / 4.0f)
+/* Updates between two reports of their cost to the deferred log, 10 s */
+#define AHRS_REPORT_UPDATES   7600U
+
+/* Length of a FLOG demo session, at the packed size of samples at rest or
+   in slow motion (imucodec.c). A session erases only its own pages, the
+   LOG region keeps about three of them */
+#define FLOG_DEMO_SECONDS     5U
+#define FLOG_DEMO_BITS        6U
+/* Batched gyroscope: 95 Hz, INT2 every 24 samples, about 4 wakeups/s */
+#define BATCH_WATERMARK       24U
+/* Upper bound of a STOP period, recovers from a missed watermark edge */
+#define BATCH_TIMEOUT_MS      500U
+/* Rotation lighting an LED, mdps */
+#define BATCH_THRESHOLD       5000.0f
+/* Lowpass of the batched rates before the peak detection, the batch data
+   rate is 95 Hz (sensors.cpp) */
+#define BATCH_RATE_HZ         95.0f
+#define BATCH_LOWPASS_HZ      10.0f
+
+#if ((L3GD20_FIFO_DEPTH * (3 + 3 + 2) * 2) > MEMPOOL_SAMPLE_BLOCK_SIZE)
+ #error "a mempool.c sample block must hold a gyroscope batch"
+#endif
+
 /* Private macro -------------------------------------------------------------*/
+/* Sensors read back a recording (make REPLAY=1), see replay.c */
+#ifdef USE_REPLAY
+ #define MEMS_REPLAYING()     REPLAY_IsActive()
+#else
+ #define MEMS_REPLAYING()     0U
+#endif
+
 /* Private variables ---------------------------------------------------------*/
 extern __IO uint8_t UserPressButton;
 /* Init af threahold to detect acceleration on MEMS */
 int16_t ThresholdHigh = 1000;
 int16_t ThresholdLow = -1000;
+/* LEDs clockwise around the compass rose, starting at -X */
+static const uint16_t AHRS_Leds[8] = { LEDS_LED3, LEDS_LED5, LEDS_LED7, LEDS_LED9,
+                                       LEDS_LED10, LEDS_LED8, LEDS_LED6, LEDS_LED4 };
+/* Filter and fusion state, read on every sample: in CCM-RAM, off the SRAM
+   bus the DMA and the __RAMFUNC code use */
+static AHRS_MadgwickTypeDef   AhrsMadgwick __CCMRAM_BSS;
+
+/* Lowpass of the X and Y rates of the batch demo, one block per batch */
+static FILTER_StageTypeDef    BatchStages[2] __CCMRAM_BSS;
+static FILTER_PipelineTypeDef BatchPipes[2] __CCMRAM_BSS;
+static q15_t                  BatchCoeffs[FILTER_BIQUAD_COEFF_SIZE(1)] __CCMRAM_BSS;
+static q15_t                  BatchState[2][FILTER_BIQUAD_STATE_SIZE(1)] __CCMRAM_BSS;
 /* Private function prototypes -----------------------------------------------*/
 static void ACCELERO_ReadAcc(void);
 static void GYRO_ReadAng(void);
+static void MEMS_InitFast(void);
+static void AHRS_DrdyIT(FunctionalState State);
+static uint32_t CONV_Cycles(void);
 /* Private functions ---------------------------------------------------------*/
 
 /**
@@ -67,10 +144,15 @@ void ACCELERO_MEMS_Test(void)
     /* Initialization Error */
     Error_Handler(); 
   }
+
+  /* Stored thresholds override the defaults above */
+  KV_Get(KV_KEY_ACC_THRESHOLD_HIGH, &ThresholdHigh, sizeof(ThresholdHigh), NULL);
+  KV_Get(KV_KEY_ACC_THRESHOLD_LOW, &ThresholdLow, sizeof(ThresholdLow), NULL);
   
   UserPressButton = 0;
   while(!UserPressButton)
   {
+    WDOG_CheckIn(WDOG_TASK_MAIN);
     ACCELERO_ReadAcc();
   }
 }  
@@ -92,13 +174,13 @@ static void ACCELERO_ReadAcc(void)
     if(xval > ThresholdHigh)
     { 
       /* LED10 On */
-      BSP_LED_On(LED10);
+      LEDS_On(LEDS_LED10);
       HAL_Delay(10);
     }
     else if(xval < ThresholdLow)
     { 
       /* LED3 On */
-      BSP_LED_On(LED3);
+      LEDS_On(LEDS_LED3);
       HAL_Delay(10);
     }
     else
@@ -111,13 +193,13 @@ static void ACCELERO_ReadAcc(void)
     if(yval < ThresholdLow)
     {
       /* LED6 On */
-      BSP_LED_On(LED6);
+      LEDS_On(LEDS_LED6);
       HAL_Delay(10);
     }
     else if(yval > ThresholdHigh)
     {
       /* LED7 On */
-      BSP_LED_On(LED7);
+      LEDS_On(LEDS_LED7);
       HAL_Delay(10);
     } 
     else
@@ -126,14 +208,8 @@ static void ACCELERO_ReadAcc(void)
     }
   } 
   
-     BSP_LED_Off(LED3);
-     BSP_LED_Off(LED6);
-     BSP_LED_Off(LED7);
-     BSP_LED_Off(LED4);
-     BSP_LED_Off(LED10);
-     BSP_LED_Off(LED8);
-     BSP_LED_Off(LED9);
-     BSP_LED_Off(LED5);
+  /* All eight in one store */
+  LEDS_Off(LEDS_ALL);
 }
 
 /**
@@ -155,6 +231,7 @@ void GYRO_MEMS_Test(void)
   UserPressButton = 0;
   while(!UserPressButton)
   {
+    WDOG_CheckIn(WDOG_TASK_MAIN);
     GYRO_ReadAng();
   }
 }  
@@ -184,13 +261,13 @@ static void GYRO_ReadAng(void)
     if(Buffer[0] > 5000.0f)
      { 
         /* LD10 On */
-        BSP_LED_On(LED10);
+        LEDS_On(LEDS_LED10);
         HAL_Delay(10);
      }
      else if(Buffer[0] < -5000.0f)
      { 
         /* LED3 On */
-        BSP_LED_On(LED3);
+        LEDS_On(LEDS_LED3);
         HAL_Delay(10);
      }      
     else
@@ -203,13 +280,13 @@ static void GYRO_ReadAng(void)
     if(Buffer[1] < -5000.0f)
      {
         /* LD6 on */
-        BSP_LED_On(LED6);           
+        LEDS_On(LEDS_LED6);           
         HAL_Delay(10);
      }
     else if(Buffer[1] > 5000.0f)
      {
         /* LD7 On */
-        BSP_LED_On(LED7);        
+        LEDS_On(LEDS_LED7);        
 	HAL_Delay(10);
      }     
         else
@@ -217,15 +294,488 @@ static void GYRO_ReadAng(void)
             HAL_Delay(10);
         }  	
       } 
-    BSP_LED_Off(LED3);
-    BSP_LED_Off(LED6);
-    BSP_LED_Off(LED7);
-    BSP_LED_Off(LED4);
-    BSP_LED_Off(LED10);
-    BSP_LED_Off(LED8);
-    BSP_LED_Off(LED9);
-    BSP_LED_Off(LED5);
+  /* All eight in one store */
+  LEDS_Off(LEDS_ALL);
+}
+
+/**
+  * @brief Test attitude estimation on GYROSCOPE, ACCELEROMETER and MAGNETOMETER.
+  *   The gyroscope data ready flag paces the Madgwick filter at 760 Hz, the
+  *   LED pointing to magnetic north is lit. The mean and worst CPU cycles of
+  *   an update go to the deferred log every 10 s.
+  * @param None
+  * @retval None
+  */
+void AHRS_MEMS_Test(void)
+{
+  AHRS_MadgwickTypeDef *ahrs = &AhrsMadgwick;
+  float gyro[3];
+  float acc[3] = {0};
+  float mag[3] = {0};
+  int16_t raw[3];
+  uint32_t sample = 0;
+  uint32_t stamp, lastStamp = 0;
+  uint8_t stamped = 0;
+  int32_t sector;
+  int32_t led = -1;
+  uint32_t cycles, cyclesSum = 0, cyclesMax = 0, updates = 0;
+
+  MEMS_InitFast();
+
+  /* Stored bias and scale, or nominal sensitivity if never calibrated */
+  CALIB_Init();
+  AHRS_MadgwickInit(ahrs, AHRS_SAMPLE_FREQ, AHRS_MADGWICK_BETA);
+  if(MEMS_REPLAYING())
+  {
+    /* Fixed period at the recorded rate, for results that repeat */
+    ahrs->SamplePeriod = 1.0f / (float)REPLAY_GetRate();
+  }
+  else
+  {
+    AHRS_DrdyIT(ENABLE);
+  }
+
+  UserPressButton = 0;
+  while(!UserPressButton)
+  {
+    WDOG_CheckIn(WDOG_TASK_MAIN);
+    while((L3GD20_GetDataStatus() & L3GD20_STATUS_ZYXDA) == 0)
+    {
+    }
+
+    /* Integrate over the measured interval between data-ready edges, the
+       gyro ODR is only nominally 760 Hz. The delay from the edge to this
+       read goes to the latency statistics, as a polling slot. */
+    if(!MEMS_REPLAYING() && (TSTAMP_Get(TSTAMP_GYRO, &stamp) == HAL_OK))
+    {
+      if(stamped)
+      {
+        ahrs->SamplePeriod = (float)TSTAMP_ELAPSED(lastStamp, stamp) * (1.0f / TSTAMP_FREQ);
+      }
+      LATENCY_Record(LATENCY_IRQ_DRDY_POLL, TSTAMP_ELAPSED(stamp, TSTAMP_Now()) * (SystemCoreClock / TSTAMP_FREQ));
+      lastStamp = stamp;
+      stamped = 1;
+    }
+
+    /* rad/s, bias removed */
+    SENSORS_GyroReadRaw(raw);
+    CALIB_GyroApply(raw, gyro);
+
+    if((sample++ % AHRS_ACC_DECIMATION) == 0U)
+    {
+      SENSORS_AccReadRaw(raw);
+      CALIB_AccApply(raw, acc);
+
+      /* Z gain differs from X/Y, scale to gauss before normalisation */
+      SENSORS_MagRead(mag);
+    }
+
+    cycles = CONV_Cycles();
+    AHRS_MadgwickUpdate(ahrs, gyro, acc, mag);
+    cycles = CONV_Cycles() - cycles;
+    cyclesSum += cycles;
+    cyclesMax = (cycles > cyclesMax) ? cycles : cyclesMax;
+    if(++updates == AHRS_REPORT_UPDATES)
+    {
+      DLOG("ahrs madgwick %lu updates: mean %lu max %lu cycles", updates,
+           cyclesSum / updates, cyclesMax);
+      DLOG_Flush();
+      cyclesSum = 0;
+      cyclesMax = 0;
+      updates = 0;
+    }
+    if(MEMS_REPLAYING())
+    {
+      REPLAY_Check(ahrs->Q, sizeof(ahrs->Q));
+    }
+
+    /* North is at -yaw in the board frame, LED10 lies on +X */
+    sector = (int32_t)lroundf(AHRS_MadgwickGetYaw(ahrs) / AHRS_SECTOR);
+    sector = (sector + 4) & 7;
+    if(sector != led)
+    {
+      LEDS_Write(AHRS_Leds[sector]);
+      led = sector;
+    }
+  }
+
+  AHRS_DrdyIT(DISABLE);
+  LEDS_Off(LEDS_ALL);
+}
+
+/**
+  * @brief Calibrate GYROSCOPE bias and ACCELEROMETER offset and scale.
+  *   Leave the board at rest until LED3 goes off (gyro bias), then hold it
+  *   with each axis pointing up and down in turn and press the user button:
+  *   one LED per captured face. When all six are in the result is stored to
+  *   flash and all LEDs light up. A rejected step blinks LED10.
+  * @param None
+  * @retval None
+  */
+void CALIB_MEMS_Test(void)
+{
+  static const uint16_t faceLeds[6] = { LEDS_LED3, LEDS_LED4, LEDS_LED5,
+                                        LEDS_LED6, LEDS_LED7, LEDS_LED8 };
+  uint16_t leds;
+  uint32_t face;
+
+  if((BSP_ACCELERO_Init() != HAL_OK) || (BSP_GYRO_Init() != HAL_OK))
+  {
+    /* Initialization Error */
+    Error_Handler(); 
+  }
+  CALIB_Init();
+
+  LEDS_On(LEDS_LED3);
+  while(CALIB_GyroBias(CALIB_GYRO_SAMPLES) != HAL_OK)
+  {
+    LEDS_Toggle(LEDS_LED10);
+  }
+  LEDS_Off(LEDS_LED3 | LEDS_LED10);
+
+  while(CALIB_AccFaces() != CALIB_FACE_ALL)
+  {
+    UserPressButton = 0;
+    while(!UserPressButton)
+    {
+      WDOG_CheckIn(WDOG_TASK_MAIN);
+    }
+
+    if(CALIB_AccCapture(CALIB_ACC_SAMPLES) != HAL_OK)
+    {
+      LEDS_Toggle(LEDS_LED10);
+      HAL_Delay(200);
+      LEDS_Toggle(LEDS_LED10);
+      continue;
+    }
+
+    leds = 0;
+    for(face = 0; face < 6U; face++)
+    {
+      leds |= (CALIB_AccFaces() & (1U << face)) ? faceLeds[face] : 0U;
+    }
+    LEDS_Write(leds);
+  }
+
+  if((CALIB_AccSolve() == HAL_OK) && (CALIB_Save() == HAL_OK))
+  {
+    LEDS_On(LEDS_LED9 | LEDS_LED10);
+  }
+  else
+  {
+    LEDS_On(LEDS_LED10);
+  }
+  HAL_Delay(1000);
+
+  LEDS_Off(LEDS_ALL);
 }
+
+/**
+  * @brief Record GYROSCOPE, ACCELEROMETER and MAGNETOMETER raw samples to flash.
+  *   LED3 is lit while the pages of the session are erased, then LED4 blinks
+  *   while recording at 760 Hz until the user button is pressed or the
+  *   pages are full, after about FLOG_DEMO_SECONDS, sooner with noisy data.
+  *   The older sessions stay in the rest of the log.
+  *   LED10 reports lost frames. Read the log back with "make logdump".
+  *   While replaying the log, LED10 flashes and nothing is recorded.
+  * @param None
+  * @retval None
+  */
+void FLOG_MEMS_Test(void)
+{
+  /* Gyro X, Y, Z, accelerometer X, Y, Z, magnetometer X, Y, Z */
+  int16_t frame[9] = {0};
+  uint32_t sample = 0;
+
+  /* Recording would erase the log being replayed */
+  if(MEMS_REPLAYING())
+  {
+    LEDS_On(LEDS_LED10);
+    HAL_Delay(1000);
+    LEDS_Off(LEDS_LED10);
+    return;
+  }
+
+  MEMS_InitFast();
+
+  LEDS_On(LEDS_LED3);
+  if(FLOG_Start(9, (uint16_t)AHRS_SAMPLE_FREQ,
+                FLOG_PagesFor(9, (uint16_t)AHRS_SAMPLE_FREQ, FLOG_DEMO_SECONDS, FLOG_DEMO_BITS)) != HAL_OK)
+  {
+    LEDS_On(LEDS_LED10);
+  }
+  LEDS_Off(LEDS_LED3);
+
+  UserPressButton = 0;
+  while(!UserPressButton && (FLOG_GetState() == FLOG_STATE_RECORDING))
+  {
+    WDOG_CheckIn(WDOG_TASK_MAIN);
+    while((L3GD20_GetDataStatus() & L3GD20_STATUS_ZYXDA) == 0)
+    {
+    }
+    SENSORS_GyroReadRaw(&frame[0]);
+
+    /* Accelerometer and magnetometer repeat between their updates */
+    if((sample++ % AHRS_ACC_DECIMATION) == 0U)
+    {
+      SENSORS_AccReadRaw(&frame[3]);
+      SENSORS_MagReadRaw(&frame[6]);
+    }
+
+    FLOG_Write(frame);
+    FLOG_Task();
+
+    if((sample % 256U) == 0U)
+    {
+      LEDS_Toggle(LEDS_LED4);
+      DLOG_Flush();
+    }
+  }
+
+  FLOG_Stop();
+  LEDS_Off(LEDS_LED4);
+  if(FLOG_GetStats()->Overruns != 0U)
+  {
+    LEDS_On(LEDS_LED10);
+  }
+  HAL_Delay(1000);
+  LEDS_Off(LEDS_LED10);
+}
+
+/**
+  * @brief Read the GYROSCOPE in batches, in STOP mode in between.
+  *   The L3GD20 fills its FIFO at 95 Hz and raises INT2 at the watermark,
+  *   which wakes the core from STOP. The batch is drained, its X and Y
+  *   rates go through a 10 Hz lowpass (filter.c) as one block, and the LED
+  *   of the fastest filtered rotation is lit until the next batch, as in
+  *   the L3GD20 test. The core runs on the HSI meanwhile: no HSE and PLL
+  *   restart on each wakeup, the drain is bound by SPI anyway.
+  * @param None
+  * @retval None
+  */
+void BATCH_MEMS_Test(void)
+{
+  GPIO_InitTypeDef gpio;
+  BATCH_BufferTypeDef *batch;
+  int32_t peak[2];
+  int8_t shift;
+  uint8_t count, i, axis;
+  uint16_t led;
+  CLOCK_ProfileTypeDef profile = CLOCK_GetProfile();
+
+  batch = MEMPOOL_Alloc(&MEMPOOL_Sample);
+  if((batch == NULL) || (BSP_GYRO_Init() != HAL_OK) ||
+     (FILTER_DesignLowpass(BatchCoeffs, BATCH_LOWPASS_HZ, BATCH_RATE_HZ, 0.7071f, &shift) != HAL_OK))
+  {
+    /* Initialization Error */
+    Error_Handler(); 
+  }
+  for(axis = 0; axis < 2U; axis++)
+  {
+    FILTER_InitBiquad(&BatchStages[axis], 1U, BatchCoeffs, BatchState[axis], shift);
+    FILTER_PipelineInit(&BatchPipes[axis], &BatchStages[axis], 1U, L3GD20_FIFO_DEPTH, NULL);
+  }
+  SENSORS_InitBatch();
+
+  /* INT2 as an EXTI line: the only kind of source that ends a STOP */
+  GYRO_INT_GPIO_CLK_ENABLE();
+  gpio.Pin = GYRO_INT2_PIN;
+  gpio.Mode = GPIO_MODE_IT_RISING;
+  gpio.Pull = GPIO_NOPULL;
+  gpio.Speed = GPIO_SPEED_FREQ_LOW;
+  HAL_GPIO_Init(GYRO_INT_GPIO_PORT, &gpio);
+  HAL_NVIC_SetPriority(GYRO_INT2_EXTI_IRQn, 0x0F, 0);
+  HAL_NVIC_EnableIRQ(GYRO_INT2_EXTI_IRQn);
+
+  L3GD20_FifoConfig(BATCH_WATERMARK);
+  CLOCK_SetProfile(CLOCK_PROFILE_HSI_8MHZ);
+
+  UserPressButton = 0;
+  while(!UserPressButton)
+  {
+    WDOG_CheckIn(WDOG_TASK_MAIN);
+
+    /* A watermark already reached gives no new edge */
+    if(HAL_GPIO_ReadPin(GYRO_INT_GPIO_PORT, GYRO_INT2_PIN) == GPIO_PIN_RESET)
+    {
+      /* The deferred log first: while the UART sends, this idle is a SLEEP */
+      DLOG_Flush();
+      LPWR_Idle(LPWR_STOP, BATCH_TIMEOUT_MS);
+    }
+
+    count = SENSORS_GyroFifoRead(batch->Fifo, L3GD20_FIFO_DEPTH);
+    if(count == 0U)
+    {
+      continue;
+    }
+
+    FILTER_Deinterleave(batch->Fifo, batch->Axis[0], batch->Axis[1], batch->Axis[2], count);
+    for(axis = 0; axis < 2U; axis++)
+    {
+      FILTER_Process(&BatchPipes[axis], batch->Axis[axis], batch->Rate[axis], count);
+      peak[axis] = 0;
+      for(i = 0; i < count; i++)
+      {
+        if(abs(batch->Rate[axis][i]) > abs(peak[axis]))
+        {
+          peak[axis] = batch->Rate[axis][i];
+        }
+      }
+    }
+
+    /* LED of the fastest rotation, the others off, in one store */
+    led = 0;
+    axis = (abs(peak[0]) > abs(peak[1])) ? 0U : 1U;
+    if(((float)abs(peak[axis]) * SENSORS_GYRO_MDPS_PER_LSB) > BATCH_THRESHOLD)
+    {
+      if(axis == 0U)
+      {
+        led = (peak[0] > 0) ? LEDS_LED10 : LEDS_LED3;
+      }
+      else
+      {
+        led = (peak[1] > 0) ? LEDS_LED7 : LEDS_LED6;
+      }
+    }
+    LEDS_Write(led);
+  }
+
+  CLOCK_SetProfile(profile);
+  L3GD20_FifoConfig(0);
+  HAL_NVIC_DisableIRQ(GYRO_INT2_EXTI_IRQn);
+  HAL_GPIO_DeInit(GYRO_INT_GPIO_PORT, GYRO_INT2_PIN);
+  LEDS_Off(LEDS_LED3 | LEDS_LED6 | LEDS_LED7 | LEDS_LED10);
+  MEMPOOL_Free(&MEMPOOL_Sample, batch);
+}
+
+/**
+  * @brief Benchmark of the sample conversion kernels, see convbench.c, and
+  *   of the filter pipeline, see filterbench.c.
+  *   The byte loops and the kernels of mems_conv.h convert the same
+  *   registers, timed in CPU cycles. LED10 reports a kernel differing from
+  *   its loop, a codec block that does not decode back, or a filter output
+  *   that fails its checks. Otherwise LED3,
+  *   LED5 and LED7 light when the little-endian, big-endian and scaling
+  *   kernels beat their loop, LED9 when the filter is cheaper by blocks
+  *   than sample by sample. The filter cycle counts go to the deferred
+  *   log with the encode time of imucodec.c, the conversion ones stay in
+  *   ConvBenchResult for the debugger.
+  * @param None
+  * @retval None
+  */
+void CONV_MEMS_Test(void)
+{
+  const CONVBENCH_ResultTypeDef *result = CONVBENCH_Run(CONV_Cycles);
+  const FILTERBENCH_ResultTypeDef *filter = FILTERBENCH_Run(CONV_Cycles);
+  uint16_t leds = 0;
+
+  DLOG("codec %lu samples: %lu cycles, %lu of %lu bytes per block", CONVBENCH_CODEC_SAMPLES,
+       result->Encode, result->EncodedSize, CONVBENCH_CODEC_FRAMES * CONVBENCH_CODEC_CHANNELS * 2U);
+  if(filter != NULL)
+  {
+    DLOG("filter %lu samples: %lu cycles per sample, %lu by blocks of %lu",
+         FILTERBENCH_SAMPLES, filter->PerSample, filter->Block, FILTER_BLOCK_SIZE);
+    DLOG("filter mismatch %lu, dc %ld for %ld", filter->Mismatches, filter->DcOutput,
+         FILTERBENCH_DC_INPUT);
+  }
+
+  if((result->Mismatches != 0U) || (filter == NULL) || (filter->Mismatches != 0U) ||
+     ((float)abs(filter->DcOutput - FILTERBENCH_DC_INPUT) > (FILTER_DC_GAIN_TOLERANCE * 32768.0f)))
+  {
+    leds = LEDS_LED10;
+  }
+  else
+  {
+    leds |= (result->KernelLe < result->LoopLe) ? LEDS_LED3 : 0U;
+    leds |= (result->KernelBe < result->LoopBe) ? LEDS_LED5 : 0U;
+    leds |= (result->KernelScale < result->LoopScale) ? LEDS_LED7 : 0U;
+    leds |= (filter->Block < filter->PerSample) ? LEDS_LED9 : 0U;
+  }
+  LEDS_On(leds);
+
+  UserPressButton = 0;
+  while(!UserPressButton)
+  {
+    WDOG_CheckIn(WDOG_TASK_MAIN);
+  }
+
+  LEDS_Off(LEDS_LED3 | LEDS_LED5 | LEDS_LED7 | LEDS_LED9 | LEDS_LED10);
+}
+
+/**
+  * @brief  CPU cycles, DWT counter started in main().
+  * @param  None
+  * @retval Cycle count, modulo 2^32
+  */
+static uint32_t CONV_Cycles(void)
+{
+  return DWT->CYCCNT;
+}
+
+/**
+  * @brief  Gyroscope at 760 Hz, 500 dps and magnetometer at 220 Hz, see
+  *         sensors.cpp. Data rates stored in the key-value store replace
+  *         these. Data-ready edges are timestamped.
+  * @param  None
+  * @retval None
+  */
+static void MEMS_InitFast(void)
+{
+  uint16_t ctrl;
+
+  /* Bus setup and sensor identification */
+  if((BSP_ACCELERO_Init() != HAL_OK) || (BSP_GYRO_Init() != HAL_OK))
+  {
+    /* Initialization Error */
+    Error_Handler(); 
+  }
+  SENSORS_Init();
+
+  /* A stored setting only changes CTRL_REG1 (rate, bandwidth, power): the
+     read path is compiled for the full scale and byte order of CTRL_REG4 */
+  if(KV_Get(KV_KEY_GYRO_INIT, &ctrl, sizeof(ctrl), NULL) == HAL_OK)
+  {
+    L3GD20_LowPower(ctrl);
+  }
+  if(KV_Get(KV_KEY_ACC_INIT, &ctrl, sizeof(ctrl), NULL) == HAL_OK)
+  {
+    COMPASSACCELERO_IO_Write(ACC_I2C_ADDRESS, LSM303DLHC_CTRL_REG1_A, (uint8_t)ctrl);
+  }
+
+  /* Data-ready outputs, timestamped by the timer captures of tstamp.c */
+  L3GD20_EnableIT(L3GD20_INT2);
+  LSM303DLHC_AccIT1Enable(LSM303DLHC_IT1_DRY1);
+  TSTAMP_Init();
+}
+
+/**
+  * @brief  Route the gyro INT2/DRDY edge on PE1 to EXTI1 as well, for the
+  *         interrupt latency probe. The pin stays on TIM17_CH1, the EXTI
+  *         line sees its input stage. Disabled again before STOP modes.
+  * @param  State: ENABLE or DISABLE
+  * @retval None
+  */
+static void AHRS_DrdyIT(FunctionalState State)
+{
+  if(State == ENABLE)
+  {
+    __HAL_RCC_SYSCFG_CLK_ENABLE();
+    SYSCFG->EXTICR[0] = (SYSCFG->EXTICR[0] & ~SYSCFG_EXTICR1_EXTI1) | SYSCFG_EXTICR1_EXTI1_PE;
+    EXTI->RTSR |= GYRO_INT2_PIN;
+    __HAL_GPIO_EXTI_CLEAR_IT(GYRO_INT2_PIN);
+    EXTI->IMR |= GYRO_INT2_PIN;
+    HAL_NVIC_SetPriority(GYRO_INT2_EXTI_IRQn, 0x0F, 0);
+    HAL_NVIC_EnableIRQ(GYRO_INT2_EXTI_IRQn);
+  }
+  else
+  {
+    HAL_NVIC_DisableIRQ(GYRO_INT2_EXTI_IRQn);
+    EXTI->IMR &= ~GYRO_INT2_PIN;
+    EXTI->RTSR &= ~GYRO_INT2_PIN;
+    __HAL_GPIO_EXTI_CLEAR_IT(GYRO_INT2_PIN);
+  }
+}
+
 /**
   * @}
   */ 
@@ -0,0 +1,655 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Src/replay.c
+  * @brief   Replay of a recorded sensor log through the sensor bus layer.
+  *
+  *          The recording is a FLOG image, as written by flashlog.c: the LOG
+  *          flash region on the target, or the file of "make logdump" in
+  *          the host build (host/). The blocks of one session are decoded
+  *          in sequence order and served to the L3GD20 and LSM303DLHC
+  *          drivers through an emulation of their registers: the bus
+  *          functions GYRO_IO_Read(), COMPASSACCELERO_IO_Read() and their
+  *          writes forward to REPLAY_xxx() while a replay is active. The
+  *          drivers, BSP_GYRO_GetXYZ() and BSP_ACCELERO_GetXYZ() included,
+  *          run unchanged on the recorded frames.
+  *
+  *          Frames carry gyro X, Y, Z, accelerometer X, Y, Z and
+  *          magnetometer X, Y, Z, as recorded by FLOG_MEMS_Test(). Pacing:
+  *            - REPLAY_SPEED_FAST: every read of the gyro output registers
+  *              returns the next frame, the status register always shows
+  *              new data. The firmware sees every frame exactly once, the
+  *              run is deterministic and as fast as the firmware reads
+  *            - REPLAY_SPEED_REALTIME or a multiple of it: frames become
+  *              available at the recorded rate times the speed, measured
+  *              with the clock given to REPLAY_Start(). A firmware slower
+  *              than the replay misses frames, counted in Skipped
+  *          With the FIFO enabled (L3GD20_FifoConfig()), reads pop the oldest
+  *          unread frame and FIFO_SRC counts the unread ones, up to 32.
+  *          The accelerometer and magnetometer return the values of the
+  *          last gyro frame read. A firmware reading only the accelerometer
+  *          advances the frames with its own reads in the fast mode.
+  *
+  *          REPLAY_Check() hashes results (FNV-1a) to compare runs bit for
+  *          bit. Integer results match between the target and the host,
+  *          float results may differ in the last bit between compilers.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "replay.h"
+#include "flashlog.h"
+#include "imucodec.h"
+#include "crc32.h"
+
+/** @addtogroup BSP_Examples
+  * @{
+  */
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+#define REPLAY_CRC_OFFSET     offsetof(FLOG_BlockTypeDef, Seq)
+#define REPLAY_NO_BLOCK       0xFFFFFFFFU
+
+/* Register map of the emulated sensors */
+#define REPLAY_WHO_AM_I       0x0FU
+#define REPLAY_CTRL1          0x20U
+#define REPLAY_CTRL4          0x23U
+#define REPLAY_CTRL4_BLE      0x40U
+#define REPLAY_CTRL5          0x24U
+#define REPLAY_CTRL5_FIFO_EN  0x40U
+#define REPLAY_STATUS         0x27U
+#define REPLAY_OUT_X_L        0x28U
+#define REPLAY_FIFO_CTRL      0x2EU
+#define REPLAY_FIFO_SRC       0x2FU
+#define REPLAY_FIFO_DEPTH     32U
+#define REPLAY_MAG_MR         0x02U
+#define REPLAY_MAG_OUT_X_H    0x03U
+#define REPLAY_MAG_SR         0x09U
+#define REPLAY_MAG_IRA        0x0AU
+
+#define REPLAY_FNV_PRIME      0x01000193U
+
+/* Private macro -------------------------------------------------------------*/
+#define REPLAY_BLOCK_SIZE(__LEN__)  (sizeof(FLOG_BlockTypeDef) + (__LEN__))
+
+/* Private variables ---------------------------------------------------------*/
+static const uint8_t *ReplayImage;
+static uint32_t       ReplaySize;
+
+static uint8_t   ReplayActive;
+static uint16_t  ReplaySession;
+static uint16_t  ReplayRate;
+static uint32_t  ReplaySpeed;
+static uint32_t  (*ReplayMicros)(void);
+static uint32_t  ReplayLastMicros;
+static uint64_t  ReplayElapsed;     /* us since REPLAY_Start() */
+
+static uint32_t  ReplayTotal;       /* frames of the session */
+static uint32_t  ReplayNext;        /* next unread frame */
+static uint8_t   ReplayGyroUsed;
+
+/* Decoded block holding the current frame */
+static int16_t   ReplayFrames[FLOG_BLOCK_FRAMES * FLOG_MAX_CHANNELS];
+static uint32_t  ReplayBlockSeq;
+static uint32_t  ReplayBlockFirst;
+static uint32_t  ReplayBlockCount;
+static uint8_t   ReplayBlockValid;
+static const int16_t *ReplayFrame;
+
+static uint8_t   GyroRegs[0x40];
+static uint8_t   AccRegs[0x40];
+static uint8_t   MagRegs[0x10];
+
+static REPLAY_StatsTypeDef ReplayStats;
+
+/* Private function prototypes -----------------------------------------------*/
+static const FLOG_BlockTypeDef *REPLAY_FindBlock(uint16_t Session, uint32_t AfterSeq);
+static uint8_t  REPLAY_LoadBlock(const FLOG_BlockTypeDef *pBlock);
+static uint32_t REPLAY_Available(void);
+static void     REPLAY_Advance(uint8_t Fifo);
+static uint8_t  REPLAY_FifoSource(void);
+static uint8_t  REPLAY_Output(uint8_t Offset, uint8_t Channel, uint8_t BigEndian);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Select the log image to replay from.
+  * @param  pImage: FLOG image, page aligned
+  * @param  Size: size in bytes, a multiple of FLASH_PAGE_SIZE
+  * @retval None
+  */
+void REPLAY_Init(const uint8_t *pImage, uint32_t Size)
+{
+  ReplayImage = pImage;
+  ReplaySize = Size;
+  ReplayActive = 0;
+}
+
+/**
+  * @brief  Start serving a recorded session to the sensor drivers.
+  * @param  Session: session number, REPLAY_LAST_SESSION for the last one
+  * @param  Speed: REPLAY_SPEED_FAST, REPLAY_SPEED_REALTIME or a multiple
+  * @param  pMicros: free running microsecond clock, modulo 2^32, needed
+  *         unless Speed is REPLAY_SPEED_FAST
+  * @retval HAL_ERROR if the session holds no frame
+  */
+HAL_StatusTypeDef REPLAY_Start(uint16_t Session, uint32_t Speed, uint32_t (*pMicros)(void))
+{
+  const FLOG_BlockTypeDef *block;
+  uint32_t seq;
+
+  ReplayActive = 0;
+  if((ReplayImage == NULL) || ((Speed != REPLAY_SPEED_FAST) && (pMicros == NULL)))
+  {
+    return HAL_ERROR;
+  }
+
+  /* The last session is the one of the newest block */
+  if(Session == REPLAY_LAST_SESSION)
+  {
+    block = REPLAY_FindBlock(REPLAY_LAST_SESSION, REPLAY_NO_BLOCK);
+    if(block == NULL)
+    {
+      return HAL_ERROR;
+    }
+    Session = block->Session;
+  }
+
+  /* Frames of the session, from its oldest block */
+  ReplayTotal = 0;
+  ReplayRate = 0;
+  seq = REPLAY_NO_BLOCK;
+  while((block = REPLAY_FindBlock(Session, seq)) != NULL)
+  {
+    ReplayTotal += block->Frames;
+    ReplayRate = block->Rate;
+    seq = block->Seq;
+  }
+  if((ReplayTotal == 0U) || ((ReplayRate == 0U) && (Speed != REPLAY_SPEED_FAST)))
+  {
+    return HAL_ERROR;
+  }
+
+  memset(&ReplayStats, 0, sizeof(ReplayStats));
+  ReplayStats.Digest = REPLAY_HASH_INIT;
+
+  memset(GyroRegs, 0, sizeof(GyroRegs));
+  memset(AccRegs, 0, sizeof(AccRegs));
+  memset(MagRegs, 0, sizeof(MagRegs));
+  GyroRegs[REPLAY_WHO_AM_I] = 0xD4;
+  GyroRegs[REPLAY_CTRL1] = 0x07;
+  AccRegs[REPLAY_WHO_AM_I] = 0x33;
+  AccRegs[REPLAY_CTRL1] = 0x07;
+  MagRegs[REPLAY_MAG_MR] = 0x03;
+  MagRegs[REPLAY_MAG_IRA] = 0x48;
+  MagRegs[REPLAY_MAG_IRA + 1U] = 0x34;
+  MagRegs[REPLAY_MAG_IRA + 2U] = 0x33;
+
+  ReplaySession = Session;
+  ReplaySpeed = Speed;
+  ReplayMicros = pMicros;
+  ReplayLastMicros = (pMicros != NULL) ? pMicros() : 0U;
+  ReplayElapsed = 0;
+  ReplayNext = 0;
+  ReplayGyroUsed = 0;
+  ReplayBlockSeq = REPLAY_NO_BLOCK;
+  ReplayBlockFirst = 0;
+  ReplayBlockCount = 0;
+  ReplayBlockValid = 0;
+  ReplayFrame = NULL;
+
+  /* Output registers hold the first frame until the first read */
+  REPLAY_Advance(0);
+  ReplayNext = 0;
+  ReplayStats.Frames = 0;
+  ReplayActive = 1;
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Stop the replay, the bus functions go back to the sensors.
+  * @param  None
+  * @retval None
+  */
+void REPLAY_Stop(void)
+{
+  ReplayActive = 0;
+}
+
+/**
+  * @brief  Whether the bus functions are served by the replay.
+  * @param  None
+  * @retval 1 between REPLAY_Start() and REPLAY_Stop()
+  */
+uint8_t REPLAY_IsActive(void)
+{
+  return ReplayActive;
+}
+
+/**
+  * @brief  Whether every frame of the session has been read.
+  * @param  None
+  * @retval 1 once the last frame is read, the registers keep it
+  */
+uint8_t REPLAY_IsDone(void)
+{
+  return (ReplayNext >= ReplayTotal) ? 1U : 0U;
+}
+
+/**
+  * @brief  Recorded frame rate of the session.
+  * @param  None
+  * @retval Frames per second
+  */
+uint16_t REPLAY_GetRate(void)
+{
+  return ReplayRate;
+}
+
+/**
+  * @brief  L3GD20 register read, in place of GYRO_IO_Read().
+  * @param  pBuffer: data read
+  * @param  ReadAddr: first register, incremented for multi-byte reads
+  * @param  NumByteToRead: number of registers
+  * @retval None
+  */
+void REPLAY_GyroRead(uint8_t *pBuffer, uint8_t ReadAddr, uint16_t NumByteToRead)
+{
+  uint8_t reg = ReadAddr & 0x3FU;
+  uint8_t be = GyroRegs[REPLAY_CTRL4] & REPLAY_CTRL4_BLE;
+
+  while(NumByteToRead-- > 0U)
+  {
+    if(reg == REPLAY_STATUS)
+    {
+      /* ZYXDA and the per axis flags */
+      *pBuffer = (REPLAY_Available() > ReplayNext) ? 0x0FU : 0x00U;
+    }
+    else if(reg == REPLAY_FIFO_SRC)
+    {
+      *pBuffer = REPLAY_FifoSource();
+    }
+    else if((reg >= REPLAY_OUT_X_L) && (reg < (REPLAY_OUT_X_L + 6U)))
+    {
+      if(reg == REPLAY_OUT_X_L)
+      {
+        ReplayGyroUsed = 1;
+        REPLAY_Advance(GyroRegs[REPLAY_CTRL5] & REPLAY_CTRL5_FIFO_EN);
+      }
+      *pBuffer = REPLAY_Output(reg - REPLAY_OUT_X_L, 0, be);
+    }
+    else
+    {
+      *pBuffer = GyroRegs[reg];
+    }
+    pBuffer++;
+    reg = (reg + 1U) & 0x3FU;
+  }
+}
+
+/**
+  * @brief  L3GD20 register write, in place of GYRO_IO_Write().
+  * @param  pBuffer: data to write
+  * @param  WriteAddr: first register, incremented for multi-byte writes
+  * @param  NumByteToWrite: number of registers
+  * @retval None
+  */
+void REPLAY_GyroWrite(const uint8_t *pBuffer, uint8_t WriteAddr, uint16_t NumByteToWrite)
+{
+  uint8_t reg = WriteAddr & 0x3FU;
+
+  while(NumByteToWrite-- > 0U)
+  {
+    GyroRegs[reg] = *pBuffer++;
+    reg = (reg + 1U) & 0x3FU;
+  }
+}
+
+/**
+  * @brief  LSM303DLHC register read, in place of COMPASSACCELERO_IO_Read().
+  * @param  DeviceAddr: REPLAY_ACC_ADDRESS or REPLAY_MAG_ADDRESS
+  * @param  RegisterAddr: register
+  * @retval Register value
+  */
+uint8_t REPLAY_AccMagRead(uint16_t DeviceAddr, uint8_t RegisterAddr)
+{
+  uint8_t reg;
+
+  if(DeviceAddr == REPLAY_MAG_ADDRESS)
+  {
+    reg = RegisterAddr & 0x0FU;
+    if(reg == REPLAY_MAG_SR)
+    {
+      return 0x01;
+    }
+    /* Big-endian, in the order X, Z, Y */
+    if((reg >= REPLAY_MAG_OUT_X_H) && (reg < (REPLAY_MAG_OUT_X_H + 6U)))
+    {
+      static const uint8_t order[3] = { 0, 2, 1 };
+      uint8_t offset = reg - REPLAY_MAG_OUT_X_H;
+      return REPLAY_Output((uint8_t)((order[offset / 2U] * 2U) + (offset & 1U)), 6, 1);
+    }
+    return MagRegs[reg];
+  }
+
+  reg = RegisterAddr & 0x3FU;
+  if(reg == REPLAY_STATUS)
+  {
+    return 0x0F;
+  }
+  if((reg >= REPLAY_OUT_X_L) && (reg < (REPLAY_OUT_X_L + 6U)))
+  {
+    if((reg == REPLAY_OUT_X_L) && (ReplayGyroUsed == 0U))
+    {
+      REPLAY_Advance(0);
+    }
+    return REPLAY_Output(reg - REPLAY_OUT_X_L, 3, AccRegs[REPLAY_CTRL4] & REPLAY_CTRL4_BLE);
+  }
+  return AccRegs[reg];
+}
+
+/**
+  * @brief  LSM303DLHC register write, in place of COMPASSACCELERO_IO_Write().
+  * @param  DeviceAddr: REPLAY_ACC_ADDRESS or REPLAY_MAG_ADDRESS
+  * @param  RegisterAddr: register
+  * @param  Value: value to write
+  * @retval None
+  */
+void REPLAY_AccMagWrite(uint16_t DeviceAddr, uint8_t RegisterAddr, uint8_t Value)
+{
+  if(DeviceAddr == REPLAY_MAG_ADDRESS)
+  {
+    MagRegs[RegisterAddr & 0x0FU] = Value;
+  }
+  else
+  {
+    AccRegs[RegisterAddr & 0x3FU] = Value;
+  }
+}
+
+/**
+  * @brief  Add results to the digest of the run.
+  * @param  pData: results, in a layout fixed across builds
+  * @param  Length: size in bytes
+  * @retval None
+  */
+void REPLAY_Check(const void *pData, uint32_t Length)
+{
+  ReplayStats.Digest = REPLAY_Hash(ReplayStats.Digest, pData, Length);
+}
+
+/**
+  * @brief  FNV-1a hash, for digests kept apart from the one of the run.
+  * @param  Hash: REPLAY_HASH_INIT, or the hash of the previous data
+  * @param  pData: data to hash
+  * @param  Length: size in bytes
+  * @retval Updated hash
+  */
+uint32_t REPLAY_Hash(uint32_t Hash, const void *pData, uint32_t Length)
+{
+  const uint8_t *p = (const uint8_t *)pData;
+
+  while(Length-- > 0U)
+  {
+    Hash = (Hash ^ *p++) * REPLAY_FNV_PRIME;
+  }
+  return Hash;
+}
+
+/**
+  * @brief  Counters and digest of the current or last replay.
+  * @param  None
+  * @retval Pointer to the counters
+  */
+const REPLAY_StatsTypeDef *REPLAY_GetStats(void)
+{
+  return &ReplayStats;
+}
+
+/**
+  * @brief  Find the block of a session following a sequence number.
+  * @param  Session: session, REPLAY_LAST_SESSION for any
+  * @param  AfterSeq: sequence number of the previous block, REPLAY_NO_BLOCK
+  *         for the first block, or for the newest one of any session
+  * @retval Block header, NULL if there is none
+  */
+static const FLOG_BlockTypeDef *REPLAY_FindBlock(uint16_t Session, uint32_t AfterSeq)
+{
+  const FLOG_BlockTypeDef *best = NULL;
+  const FLOG_BlockTypeDef *block;
+  uint32_t page, addr, end;
+
+  for(page = 0; (page + FLASH_PAGE_SIZE) <= ReplaySize; page += FLASH_PAGE_SIZE)
+  {
+    addr = page;
+    end = page + FLASH_PAGE_SIZE;
+    while((addr + sizeof(FLOG_BlockTypeDef)) <= end)
+    {
+      block = (const FLOG_BlockTypeDef *)(ReplayImage + addr);
+      if((block->Magic != FLOG_MAGIC) || (block->Length > FLOG_MAX_PAYLOAD) ||
+         ((addr + REPLAY_BLOCK_SIZE(block->Length)) > end))
+      {
+        break;
+      }
+      if(Session == REPLAY_LAST_SESSION)
+      {
+        if((best == NULL) || (block->Seq > best->Seq))
+        {
+          best = block;
+        }
+      }
+      else if((block->Session == Session) &&
+              ((AfterSeq == REPLAY_NO_BLOCK) || (block->Seq > AfterSeq)) &&
+              ((best == NULL) || (block->Seq < best->Seq)))
+      {
+        best = block;
+      }
+      addr += REPLAY_BLOCK_SIZE(block->Length);
+    }
+  }
+
+  return best;
+}
+
+/**
+  * @brief  Check and decode a block into ReplayFrames, 9 channels per frame.
+  * @param  pBlock: block header
+  * @retval 1 if decoded, 0 if the block is corrupt
+  */
+static uint8_t REPLAY_LoadBlock(const FLOG_BlockTypeDef *pBlock)
+{
+  static int16_t decoded[FLOG_BLOCK_FRAMES * FLOG_MAX_CHANNELS];
+  const uint8_t *payload = (const uint8_t *)pBlock + sizeof(FLOG_BlockTypeDef);
+  uint32_t channels = pBlock->Channels;
+  uint32_t frames = pBlock->Frames;
+  uint32_t i, c;
+
+  if((CRC32_Calc((const uint8_t *)pBlock + REPLAY_CRC_OFFSET,
+                 REPLAY_BLOCK_SIZE(pBlock->Length) - REPLAY_CRC_OFFSET) != pBlock->Crc) ||
+     (channels == 0U) || (channels > FLOG_MAX_CHANNELS) || (frames == 0U) || (frames > FLOG_BLOCK_FRAMES))
+  {
+    return 0;
+  }
+
+  switch(pBlock->Encoding)
+  {
+  case FLOG_ENC_RAW:
+    if(pBlock->Length < (frames * channels * 2U))
+    {
+      return 0;
+    }
+    memcpy(decoded, payload, frames * channels * 2U);
+    break;
+
+  case FLOG_ENC_DELTA8:
+    if(pBlock->Length < ((channels * 2U) + ((frames - 1U) * channels)))
+    {
+      return 0;
+    }
+    memcpy(decoded, payload, channels * 2U);
+    for(i = channels; i < (frames * channels); i++)
+    {
+      decoded[i] = (int16_t)(decoded[i - channels] + (int8_t)payload[channels + i]);
+    }
+    break;
+
+  case FLOG_ENC_PACKED:
+    if(IMUC_Decode(payload, pBlock->Length, frames, channels, decoded) == 0U)
+    {
+      return 0;
+    }
+    break;
+
+  default:
+    return 0;
+  }
+
+  /* Widen to gyro, accelerometer and magnetometer, missing channels read 0 */
+  memset(ReplayFrames, 0, sizeof(ReplayFrames));
+  for(i = 0; i < frames; i++)
+  {
+    for(c = 0; c < channels; c++)
+    {
+      ReplayFrames[(i * FLOG_MAX_CHANNELS) + c] = decoded[(i * channels) + c];
+    }
+  }
+  ReplayBlockCount = frames;
+  ReplayStats.Blocks++;
+
+  return 1;
+}
+
+/**
+  * @brief  Frames available to the firmware at this time.
+  * @param  None
+  * @retval Index of the newest available frame plus one
+  */
+static uint32_t REPLAY_Available(void)
+{
+  uint64_t due;
+  uint32_t now;
+
+  if(ReplaySpeed == REPLAY_SPEED_FAST)
+  {
+    return (ReplayNext < ReplayTotal) ? (ReplayNext + 1U) : ReplayTotal;
+  }
+
+  now = ReplayMicros();
+  ReplayElapsed += (uint32_t)(now - ReplayLastMicros);
+  ReplayLastMicros = now;
+
+  due = ((ReplayElapsed * ReplayRate * ReplaySpeed) / 1000000U) + 1U;
+  return (due < ReplayTotal) ? (uint32_t)due : ReplayTotal;
+}
+
+/**
+  * @brief  Latch the next frame into the output registers.
+  * @param  Fifo: non-zero to pop the oldest frame of a 32 frame FIFO, zero
+  *         to jump to the newest frame
+  * @retval None
+  */
+static void REPLAY_Advance(uint8_t Fifo)
+{
+  const FLOG_BlockTypeDef *block;
+  uint32_t avail = REPLAY_Available();
+  uint32_t frame;
+
+  if(avail <= ReplayNext)
+  {
+    /* No new frame: the registers keep the last one */
+    return;
+  }
+  if(Fifo != 0U)
+  {
+    /* Stream mode: frames older than the FIFO depth are overwritten */
+    if((avail - ReplayNext) > REPLAY_FIFO_DEPTH)
+    {
+      ReplayStats.Skipped += avail - REPLAY_FIFO_DEPTH - ReplayNext;
+      ReplayNext = avail - REPLAY_FIFO_DEPTH;
+    }
+    frame = ReplayNext;
+  }
+  else
+  {
+    frame = avail - 1U;
+    ReplayStats.Skipped += frame - ReplayNext;
+  }
+  ReplayNext = frame + 1U;
+  ReplayStats.Frames++;
+
+  /* Blocks move forward only. The frames of a corrupt block keep the last
+     good frame in the registers, as a sensor that stopped updating. */
+  while(frame >= (ReplayBlockFirst + ReplayBlockCount))
+  {
+    ReplayBlockFirst += ReplayBlockCount;
+    ReplayBlockCount = 0;
+    block = REPLAY_FindBlock(ReplaySession, ReplayBlockSeq);
+    if(block == NULL)
+    {
+      return;
+    }
+    ReplayBlockSeq = block->Seq;
+    ReplayBlockValid = REPLAY_LoadBlock(block);
+    if(ReplayBlockValid == 0U)
+    {
+      ReplayStats.BadBlocks++;
+      ReplayBlockCount = block->Frames;
+    }
+  }
+  if(ReplayBlockValid != 0U)
+  {
+    ReplayFrame = &ReplayFrames[(frame - ReplayBlockFirst) * FLOG_MAX_CHANNELS];
+  }
+}
+
+/**
+  * @brief  FIFO_SRC register: unread frames, overrun and watermark flags.
+  * @param  None
+  * @retval Register value
+  */
+static uint8_t REPLAY_FifoSource(void)
+{
+  uint32_t pending = REPLAY_Available() - ReplayNext;
+  uint8_t src;
+
+  /* FSS counts up to 31, a full FIFO is flagged as overrun */
+  src = (pending >= REPLAY_FIFO_DEPTH) ? 0x5FU : (uint8_t)pending;
+  if(pending >= (GyroRegs[REPLAY_FIFO_CTRL] & 0x1FU))
+  {
+    src |= 0x80U;
+  }
+  if(pending == 0U)
+  {
+    src |= 0x20U;
+  }
+  return src;
+}
+
+/**
+  * @brief  Byte of an output register pair.
+  * @param  Offset: byte offset from the X low byte, little-endian order
+  * @param  Channel: first channel of the sensor in the frame
+  * @param  BigEndian: non-zero to swap the bytes of each pair
+  * @retval Register value
+  */
+static uint8_t REPLAY_Output(uint8_t Offset, uint8_t Channel, uint8_t BigEndian)
+{
+  uint16_t value;
+
+  if(ReplayFrame == NULL)
+  {
+    return 0;
+  }
+  value = (uint16_t)ReplayFrame[Channel + (Offset / 2U)];
+  if(BigEndian != 0U)
+  {
+    Offset ^= 1U;
+  }
+  return (uint8_t)(((Offset & 1U) != 0U) ? (value >> 8) : value);
+}
+
+/**
+  * @}
+  */
@@ -0,0 +1,217 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Src/ringbuf.c
+  * @brief   Lock-free single producer / single consumer ring buffer.
+  *
+  *          Handoff path from acquisition ISRs (DRDY, DMA complete) to the
+  *          processing and transmit code. No critical section is taken: each
+  *          index has exactly one writer, and the data accesses are ordered
+  *          against the index update with DMB so the other side (CPU or DMA
+  *          master) never sees an index ahead of its data.
+  *
+  *          Bulk transfers copy at most two contiguous spans. RING_WritePtr()
+  *          / RING_Commit() and RING_ReadPtr() / RING_Consume() expose the
+  *          contiguous span directly for DMA or in-place processing.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "ringbuf.h"
+
+/** @addtogroup BSP_Examples
+  * @{
+  */
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Private function prototypes -----------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Attach a storage area to a ring and empty it.
+  * @param  hring: ring handle
+  * @param  pBuffer: storage of ElemSize * Capacity bytes
+  * @param  ElemSize: element size in bytes
+  * @param  Capacity: number of elements, must be a power of two
+  * @retval HAL_ERROR if Capacity is not a power of two
+  */
+HAL_StatusTypeDef RING_Init(RING_HandleTypeDef *hring, void *pBuffer, uint32_t ElemSize, uint32_t Capacity)
+{
+  if((Capacity == 0U) || ((Capacity & (Capacity - 1U)) != 0U) || (ElemSize == 0U))
+  {
+    return HAL_ERROR;
+  }
+
+  hring->Buffer = (uint8_t *)pBuffer;
+  hring->ElemSize = ElemSize;
+  hring->Capacity = Capacity;
+  hring->Mask = Capacity - 1U;
+  hring->Head = 0;
+  hring->Tail = 0;
+  hring->Overflow = 0;
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Number of elements ready for the consumer.
+  * @param  hring: ring handle
+  * @retval Element count
+  */
+uint32_t RING_Count(const RING_HandleTypeDef *hring)
+{
+  return hring->Head - hring->Tail;
+}
+
+/**
+  * @brief  Number of free element slots for the producer.
+  * @param  hring: ring handle
+  * @retval Free slot count
+  */
+uint32_t RING_Space(const RING_HandleTypeDef *hring)
+{
+  return hring->Capacity - (hring->Head - hring->Tail);
+}
+
+/**
+  * @brief  Copy elements into the ring. Elements that do not fit are dropped
+  *         and accounted in Overflow.
+  * @param  hring: ring handle
+  * @param  pData: source elements
+  * @param  Count: number of elements
+  * @retval Number of elements queued
+  */
+uint32_t RING_Push(RING_HandleTypeDef *hring, const void *pData, uint32_t Count)
+{
+  uint32_t head = hring->Head;
+  uint32_t space = hring->Capacity - (head - hring->Tail);
+  uint32_t index = head & hring->Mask;
+  uint32_t first;
+
+  if(Count > space)
+  {
+    hring->Overflow += Count - space;
+    Count = space;
+  }
+
+  first = hring->Capacity - index;
+  if(first > Count)
+  {
+    first = Count;
+  }
+
+  memcpy(hring->Buffer + (index * hring->ElemSize), pData, first * hring->ElemSize);
+  memcpy(hring->Buffer, (const uint8_t *)pData + (first * hring->ElemSize), (Count - first) * hring->ElemSize);
+
+  /* Data must be visible before the consumer sees the new head */
+  __DMB();
+  hring->Head = head + Count;
+
+  return Count;
+}
+
+/**
+  * @brief  Contiguous free span at the producer position, for DMA or in-place fill.
+  * @param  hring: ring handle
+  * @param  ppData: set to the first free slot
+  * @retval Number of contiguous free slots
+  */
+uint32_t RING_WritePtr(RING_HandleTypeDef *hring, void **ppData)
+{
+  uint32_t head = hring->Head;
+  uint32_t space = hring->Capacity - (head - hring->Tail);
+  uint32_t index = head & hring->Mask;
+  uint32_t span = hring->Capacity - index;
+
+  *ppData = hring->Buffer + (index * hring->ElemSize);
+
+  return (span < space) ? span : space;
+}
+
+/**
+  * @brief  Publish elements written through RING_WritePtr().
+  * @param  hring: ring handle
+  * @param  Count: number of elements written
+  * @retval None
+  */
+void RING_Commit(RING_HandleTypeDef *hring, uint32_t Count)
+{
+  __DMB();
+  hring->Head += Count;
+}
+
+/**
+  * @brief  Copy elements out of the ring.
+  * @param  hring: ring handle
+  * @param  pData: destination
+  * @param  Count: maximum number of elements
+  * @retval Number of elements copied
+  */
+uint32_t RING_Pop(RING_HandleTypeDef *hring, void *pData, uint32_t Count)
+{
+  uint32_t tail = hring->Tail;
+  uint32_t avail = hring->Head - tail;
+  uint32_t index = tail & hring->Mask;
+  uint32_t first;
+
+  if(Count > avail)
+  {
+    Count = avail;
+  }
+
+  /* Do not read data ahead of the head that published it */
+  __DMB();
+
+  first = hring->Capacity - index;
+  if(first > Count)
+  {
+    first = Count;
+  }
+
+  memcpy(pData, hring->Buffer + (index * hring->ElemSize), first * hring->ElemSize);
+  memcpy((uint8_t *)pData + (first * hring->ElemSize), hring->Buffer, (Count - first) * hring->ElemSize);
+
+  /* Slots are handed back only after the data has been read */
+  __DMB();
+  hring->Tail = tail + Count;
+
+  return Count;
+}
+
+/**
+  * @brief  Contiguous readable span at the consumer position, for DMA or in-place use.
+  * @param  hring: ring handle
+  * @param  ppData: set to the oldest element
+  * @retval Number of contiguous readable elements
+  */
+uint32_t RING_ReadPtr(RING_HandleTypeDef *hring, void **ppData)
+{
+  uint32_t tail = hring->Tail;
+  uint32_t avail = hring->Head - tail;
+  uint32_t index = tail & hring->Mask;
+  uint32_t span = hring->Capacity - index;
+
+  __DMB();
+  *ppData = hring->Buffer + (index * hring->ElemSize);
+
+  return (span < avail) ? span : avail;
+}
+
+/**
+  * @brief  Release elements read through RING_ReadPtr().
+  * @param  hring: ring handle
+  * @param  Count: number of elements consumed
+  * @retval None
+  */
+void RING_Consume(RING_HandleTypeDef *hring, uint32_t Count)
+{
+  __DMB();
+  hring->Tail += Count;
+}
+
+/**
+  * @}
+  */
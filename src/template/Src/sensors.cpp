@@ -0,0 +1,124 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Src/sensors.cpp
+  * @brief   Sensor settings of the MEMS demos, fixed at compile time with
+  *          the drivers of mems_sensor.hpp.
+  *
+  *          - streaming (AHRS, FLOG): gyroscope 760 Hz 500 dps, accelerometer
+  *            50 Hz 2 g high resolution, magnetometer 220 Hz 1.3 gauss
+  *          - batch: gyroscope 95 Hz 500 dps through its FIFO
+  *          All little-endian, no high-pass filter. Both gyroscope settings
+  *          share the data format, so one read path serves both.
+  *
+  *          C modules call the SENSORS_xxx functions, with link-time
+  *          optimization (release and size profiles) the read paths are
+  *          inlined into their callers.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "sensors.h"
+#include "mems_sensor.hpp"
+
+/** @addtogroup BSP_Examples
+  * @{
+  */
+
+/* Private typedef -----------------------------------------------------------*/
+namespace
+{
+using Gyro      = mems::L3gd20<mems::GyroOdr::Hz760, mems::GyroScale::Dps500>;
+using BatchGyro = mems::L3gd20<mems::GyroOdr::Hz95, mems::GyroScale::Dps500>;
+using Acc       = mems::Lsm303dlhcAcc<mems::AccOdr::Hz50, mems::AccScale::G2>;
+using Mag       = mems::Lsm303dlhcMag<mems::MagOdr::Hz220, mems::MagScale::Ga1_3>;
+
+/* The scales known to the C modules must be those of the types */
+static_assert(Gyro::sensitivity == SENSORS_GYRO_MDPS_PER_LSB, "gyroscope scale");
+static_assert(BatchGyro::ctrl4 == Gyro::ctrl4, "one data format for both gyroscope settings");
+static_assert(Mag::gainXY == LSM303DLHC_MAG_LSB_PER_GAUSS_XY_1_3, "magnetometer X/Y gain");
+static_assert(Mag::gainZ == LSM303DLHC_MAG_LSB_PER_GAUSS_Z_1_3, "magnetometer Z gain");
+}
+
+/* Private define ------------------------------------------------------------*/
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Private function prototypes -----------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Streaming settings of the three sensors.
+  * @param  None
+  * @retval None
+  */
+void SENSORS_Init(void)
+{
+  Gyro::Init();
+  Acc::Init();
+  Mag::Init();
+}
+
+/**
+  * @brief  Batch settings of the gyroscope, the FIFO is configured apart
+  *         with L3GD20_FifoConfig().
+  * @param  None
+  * @retval None
+  */
+void SENSORS_InitBatch(void)
+{
+  BatchGyro::Init();
+}
+
+/**
+  * @brief  Read the angular rate.
+  * @param  pData: X, Y, Z in LSB, see SENSORS_GYRO_MDPS_PER_LSB
+  * @retval None
+  */
+void SENSORS_GyroReadRaw(int16_t *pData)
+{
+  Gyro::ReadRaw(pData);
+}
+
+/**
+  * @brief  Drain the gyroscope FIFO.
+  * @param  pData: X, Y, Z in LSB per sample, oldest first
+  * @param  MaxSamples: room at pData, in samples
+  * @retval Samples read
+  */
+uint8_t SENSORS_GyroFifoRead(int16_t *pData, uint8_t MaxSamples)
+{
+  return Gyro::FifoRead(pData, MaxSamples);
+}
+
+/**
+  * @brief  Read the acceleration.
+  * @param  pData: X, Y, Z in LSB, left aligned
+  * @retval None
+  */
+void SENSORS_AccReadRaw(int16_t *pData)
+{
+  Acc::ReadRaw(pData);
+}
+
+/**
+  * @brief  Read the magnetic field.
+  * @param  pData: X, Y, Z in LSB, see LSM303DLHC_MAG_LSB_PER_GAUSS_*
+  * @retval None
+  */
+void SENSORS_MagReadRaw(int16_t *pData)
+{
+  Mag::ReadRaw(pData);
+}
+
+/**
+  * @brief  Read the magnetic field in gauss.
+  * @param  pData: X, Y, Z in gauss
+  * @retval None
+  */
+void SENSORS_MagRead(float *pData)
+{
+  Mag::Read(pData);
+}
+
+/**
+  * @}
+  */
@@ -0,0 +1,473 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Src/serial.c
+  * @brief   Telemetry UART: USART1 at SERIAL_BAUDRATE, both directions by DMA.
+  *
+  *          PC4 USART1_TX, PC5 USART1_RX (AF7), 8N1, free on the
+  *          STM32F3-Discovery headers.
+  *            - transmit: SERIAL_Write() copies into a ring and returns at
+  *              once. DMA1 channel 4 sends the ring one contiguous span at
+  *              a time, the end of a span starts the next one. A write that
+  *              does not fit is dropped whole, counted in TxDropped: the
+  *              caller never waits for the wire
+  *            - receive: DMA1 channel 5 fills SERIAL_RX_SIZE bytes in
+  *              circular mode. The half and full transfer interrupts and
+  *              the USART idle line publish what has arrived, so a short
+  *              burst is readable as soon as the line goes quiet
+  *            - printf: _write() retargets stdout and stderr, line
+  *              buffered in a static buffer (no heap)
+  *          Write and printf from thread mode only, the ring has a single
+  *          producer.
+  *
+  *          A change of clock profile waits for the span on the wire, then
+  *          reprograms the baud rate. Below 24 MHz (CLOCK_PROFILE_HSI_8MHZ)
+  *          SERIAL_BAUDRATE is out of reach: transmission holds, writes
+  *          queue until the ring is full.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include "serial.h"
+#include "ringbuf.h"
+#include "clock.h"
+
+/** @addtogroup BSP_Examples
+  * @{
+  */
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+#define SERIAL_GPIO_PORT      GPIOC
+#define SERIAL_TX_PIN         GPIO_PIN_4
+#define SERIAL_RX_PIN         GPIO_PIN_5
+
+/* Lowest, as the other peripheral interrupts. The three serial interrupts
+   share it and never preempt each other */
+#define SERIAL_IRQ_PRIORITY   0x0FU
+
+/* Smallest USARTDIV with oversampling by 8 */
+#define SERIAL_DIV_MIN        16U
+
+/* Longest span on the wire, SERIAL_TX_SIZE bytes of 10 bits, with margin */
+#define SERIAL_FLUSH_MS       (((SERIAL_TX_SIZE * 10U * 1000U) / SERIAL_BAUDRATE) + 2U)
+
+/* printf line buffer */
+#define SERIAL_STDIO_SIZE     128U
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static UART_HandleTypeDef SerialUart;
+static DMA_HandleTypeDef  SerialDmaTx;
+static DMA_HandleTypeDef  SerialDmaRx;
+
+static RING_HandleTypeDef SerialTx;
+static uint8_t            SerialTxBuffer[SERIAL_TX_SIZE];
+static __IO uint32_t      SerialTxSpan;     /* Bytes on the DMA, 0 when idle */
+static __IO uint8_t       SerialTxHold;     /* No new span, clock change */
+
+static uint8_t            SerialRxBuffer[SERIAL_RX_SIZE];
+static __IO uint32_t      SerialRxHead;     /* Bytes received, free running */
+static uint32_t           SerialRxTail;     /* Bytes read, free running */
+static uint32_t           SerialRxPos;      /* DMA position at the last event */
+
+static SERIAL_StatsTypeDef SerialStats;
+static char               SerialStdio[SERIAL_STDIO_SIZE];
+
+/* Private function prototypes -----------------------------------------------*/
+static void SERIAL_StartTx(void);
+static void SERIAL_StartRx(void);
+static void SERIAL_RxEvent(void);
+static void SERIAL_ClockChanged(CLOCK_EventTypeDef Event, CLOCK_ProfileTypeDef Profile);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Configure USART1 and its DMA channels, start receiving and
+  *         route printf to the UART.
+  * @note   Call after SystemClock_Config(): SERIAL_BAUDRATE needs PCLK2 of
+  *         24 MHz or more.
+  * @param  None
+  * @retval HAL_ERROR if the UART cannot be set up
+  */
+HAL_StatusTypeDef SERIAL_Init(void)
+{
+  GPIO_InitTypeDef gpio;
+
+  __HAL_RCC_GPIOC_CLK_ENABLE();
+  __HAL_RCC_USART1_CLK_ENABLE();
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  gpio.Pin = SERIAL_TX_PIN | SERIAL_RX_PIN;
+  gpio.Mode = GPIO_MODE_AF_PP;
+  gpio.Pull = GPIO_PULLUP;
+  gpio.Speed = GPIO_SPEED_FREQ_HIGH;
+  gpio.Alternate = GPIO_AF7_USART1;
+  HAL_GPIO_Init(SERIAL_GPIO_PORT, &gpio);
+
+  SerialDmaTx.Instance = DMA1_Channel4;
+  SerialDmaTx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+  SerialDmaTx.Init.PeriphInc = DMA_PINC_DISABLE;
+  SerialDmaTx.Init.MemInc = DMA_MINC_ENABLE;
+  SerialDmaTx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+  SerialDmaTx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+  SerialDmaTx.Init.Mode = DMA_NORMAL;
+  SerialDmaTx.Init.Priority = DMA_PRIORITY_LOW;
+  if(HAL_DMA_Init(&SerialDmaTx) != HAL_OK)
+  {
+    return HAL_ERROR;
+  }
+  __HAL_LINKDMA(&SerialUart, hdmatx, SerialDmaTx);
+
+  SerialDmaRx.Instance = DMA1_Channel5;
+  SerialDmaRx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+  SerialDmaRx.Init.PeriphInc = DMA_PINC_DISABLE;
+  SerialDmaRx.Init.MemInc = DMA_MINC_ENABLE;
+  SerialDmaRx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+  SerialDmaRx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+  SerialDmaRx.Init.Mode = DMA_CIRCULAR;
+  SerialDmaRx.Init.Priority = DMA_PRIORITY_MEDIUM;
+  if(HAL_DMA_Init(&SerialDmaRx) != HAL_OK)
+  {
+    return HAL_ERROR;
+  }
+  __HAL_LINKDMA(&SerialUart, hdmarx, SerialDmaRx);
+
+  /* The circular buffer absorbs late reads: no overrun error to stop the
+     reception on */
+  SerialUart.Instance = USART1;
+  SerialUart.Init.BaudRate = SERIAL_BAUDRATE;
+  SerialUart.Init.WordLength = UART_WORDLENGTH_8B;
+  SerialUart.Init.StopBits = UART_STOPBITS_1;
+  SerialUart.Init.Parity = UART_PARITY_NONE;
+  SerialUart.Init.Mode = UART_MODE_TX_RX;
+  SerialUart.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+  SerialUart.Init.OverSampling = UART_OVERSAMPLING_8;
+  SerialUart.AdvancedInit.AdvFeatureInit = UART_ADVFEATURE_RXOVERRUNDISABLE_INIT;
+  SerialUart.AdvancedInit.OverrunDisable = UART_ADVFEATURE_OVERRUN_DISABLE;
+  if(HAL_UART_Init(&SerialUart) != HAL_OK)
+  {
+    return HAL_ERROR;
+  }
+
+  HAL_NVIC_SetPriority(DMA1_Channel4_IRQn, SERIAL_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel4_IRQn);
+  HAL_NVIC_SetPriority(DMA1_Channel5_IRQn, SERIAL_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel5_IRQn);
+  HAL_NVIC_SetPriority(USART1_IRQn, SERIAL_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(USART1_IRQn);
+
+  RING_Init(&SerialTx, SerialTxBuffer, 1U, SERIAL_TX_SIZE);
+  SerialTxSpan = 0;
+  SerialTxHold = 0;
+  SerialRxHead = 0;
+  SerialRxTail = 0;
+  memset(&SerialStats, 0, sizeof(SerialStats));
+  SERIAL_StartRx();
+
+  setvbuf(stdout, SerialStdio, _IOLBF, sizeof(SerialStdio));
+  CLOCK_RegisterCallback(SERIAL_ClockChanged);
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Queue bytes for transmission, never waits.
+  * @param  pData: bytes to send
+  * @param  Size: number of bytes
+  * @retval Size, 0 if the ring has no room for all of them
+  */
+uint32_t SERIAL_Write(const void *pData, uint32_t Size)
+{
+  if(RING_Space(&SerialTx) < Size)
+  {
+    SerialStats.TxDropped += Size;
+    return 0;
+  }
+  RING_Push(&SerialTx, pData, Size);
+  SERIAL_StartTx();
+
+  return Size;
+}
+
+/**
+  * @brief  Room in the transmit ring: a write of this size is not dropped.
+  * @param  None
+  * @retval Free bytes
+  */
+uint32_t SERIAL_TxSpace(void)
+{
+  return RING_Space(&SerialTx);
+}
+
+/**
+  * @brief  Copy out received bytes.
+  * @param  pData: destination
+  * @param  Size: room at pData
+  * @retval Number of bytes copied
+  */
+uint32_t SERIAL_Read(uint8_t *pData, uint32_t Size)
+{
+  uint32_t count = SERIAL_RxCount();
+  uint32_t index, first;
+
+  if(Size > count)
+  {
+    Size = count;
+  }
+  index = SerialRxTail & (SERIAL_RX_SIZE - 1U);
+  first = SERIAL_RX_SIZE - index;
+  if(first > Size)
+  {
+    first = Size;
+  }
+  memcpy(pData, &SerialRxBuffer[index], first);
+  memcpy(&pData[first], SerialRxBuffer, Size - first);
+  SerialRxTail += Size;
+
+  return Size;
+}
+
+/**
+  * @brief  Number of received bytes not read yet.
+  * @note   Bytes the DMA overwrote before they were read are skipped and
+  *         counted in RxOverrun.
+  * @param  None
+  * @retval Byte count, at most SERIAL_RX_SIZE
+  */
+uint32_t SERIAL_RxCount(void)
+{
+  uint32_t head = SerialRxHead;
+
+  if((head - SerialRxTail) > SERIAL_RX_SIZE)
+  {
+    SerialStats.RxOverrun += (head - SerialRxTail) - SERIAL_RX_SIZE;
+    SerialRxTail = head - SERIAL_RX_SIZE;
+  }
+  return head - SerialRxTail;
+}
+
+/**
+  * @brief  Whether a span is on the wire, which a STOP mode would cut.
+  * @param  None
+  * @retval 1 while transmitting, 0 otherwise
+  */
+uint8_t SERIAL_IsBusy(void)
+{
+  return (SerialTxSpan != 0U) ? 1U : 0U;
+}
+
+/**
+  * @brief  Lost bytes.
+  * @param  None
+  * @retval Pointer to the counters
+  */
+const SERIAL_StatsTypeDef *SERIAL_GetStats(void)
+{
+  return &SerialStats;
+}
+
+/**
+  * @brief  USART1 interrupt: idle line, end of transmission, errors.
+  * @param  None
+  * @retval None
+  */
+void SERIAL_IRQHandler(void)
+{
+  if(__HAL_UART_GET_FLAG(&SerialUart, UART_FLAG_IDLE) != RESET)
+  {
+    __HAL_UART_CLEAR_IDLEFLAG(&SerialUart);
+    SERIAL_RxEvent();
+  }
+  HAL_UART_IRQHandler(&SerialUart);
+}
+
+/**
+  * @brief  DMA1 channel 4 interrupt, end of a transmit span.
+  * @param  None
+  * @retval None
+  */
+void SERIAL_DmaTxIRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&SerialDmaTx);
+}
+
+/**
+  * @brief  DMA1 channel 5 interrupt, receive buffer half and full.
+  * @param  None
+  * @retval None
+  */
+void SERIAL_DmaRxIRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&SerialDmaRx);
+}
+
+/**
+  * @brief  Last byte of a span sent: release it, send the next one.
+  * @param  huart: UART handle
+  * @retval None
+  */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+  if(huart == &SerialUart)
+  {
+    RING_Consume(&SerialTx, SerialTxSpan);
+    SerialTxSpan = 0;
+    SERIAL_StartTx();
+  }
+}
+
+/**
+  * @brief  First half of the receive buffer filled.
+  * @param  huart: UART handle
+  * @retval None
+  */
+void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart)
+{
+  if(huart == &SerialUart)
+  {
+    SERIAL_RxEvent();
+  }
+}
+
+/**
+  * @brief  Second half of the receive buffer filled, the DMA wraps.
+  * @param  huart: UART handle
+  * @retval None
+  */
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+  if(huart == &SerialUart)
+  {
+    SERIAL_RxEvent();
+  }
+}
+
+/**
+  * @brief  Framing or noise error: restart the reception if the HAL
+  *         stopped it.
+  * @param  huart: UART handle
+  * @retval None
+  */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+  if((huart == &SerialUart) && (SerialUart.RxState == HAL_UART_STATE_READY))
+  {
+    SERIAL_RxEvent();
+    SERIAL_StartRx();
+  }
+}
+
+/**
+  * @brief  Route stdout and stderr to the transmit ring.
+  * @param  file: file descriptor
+  * @param  ptr: bytes to write
+  * @param  len: number of bytes
+  * @retval len, -1 for other files
+  */
+__USED int _write(int file, char *ptr, int len)
+{
+  if((file != 1) && (file != 2))
+  {
+    return -1;
+  }
+  SERIAL_Write(ptr, (uint32_t)len);
+
+  return len;
+}
+
+/**
+  * @brief  Start the DMA on the oldest contiguous span of the ring, unless
+  *         one is on the wire already.
+  * @note   Runs from thread mode and from the end of transmission
+  *         interrupt, the check and the start are one PRIMASK section.
+  * @param  None
+  * @retval None
+  */
+static void SERIAL_StartTx(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  void *span;
+  uint32_t count;
+
+  __disable_irq();
+  if((SerialTxSpan == 0U) && (SerialTxHold == 0U))
+  {
+    count = RING_ReadPtr(&SerialTx, &span);
+    if((count != 0U) && (HAL_UART_Transmit_DMA(&SerialUart, (uint8_t *)span, (uint16_t)count) == HAL_OK))
+    {
+      SerialTxSpan = count;
+    }
+  }
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Start the circular reception at the buffer start.
+  * @param  None
+  * @retval None
+  */
+static void SERIAL_StartRx(void)
+{
+  SerialRxPos = 0;
+  HAL_UART_Receive_DMA(&SerialUart, SerialRxBuffer, SERIAL_RX_SIZE);
+  __HAL_UART_CLEAR_IDLEFLAG(&SerialUart);
+  __HAL_UART_ENABLE_IT(&SerialUart, UART_IT_IDLE);
+}
+
+/**
+  * @brief  Publish the bytes the DMA wrote since the last event.
+  * @note   Events come at least every half buffer, the position cannot
+  *         lap the previous one in between.
+  * @param  None
+  * @retval None
+  */
+static void SERIAL_RxEvent(void)
+{
+  uint32_t pos = (SERIAL_RX_SIZE - __HAL_DMA_GET_COUNTER(&SerialDmaRx)) & (SERIAL_RX_SIZE - 1U);
+
+  SerialRxHead += (pos - SerialRxPos) & (SERIAL_RX_SIZE - 1U);
+  SerialRxPos = pos;
+}
+
+/**
+  * @brief  Hold transmission across a clock profile change and set the baud
+  *         rate for the new PCLK2.
+  * @param  Event: CLOCK_EVENT_PRE_CHANGE or CLOCK_EVENT_POST_CHANGE
+  * @param  Profile: new profile, unused
+  * @retval None
+  */
+static void SERIAL_ClockChanged(CLOCK_EventTypeDef Event, CLOCK_ProfileTypeDef Profile)
+{
+  uint32_t div, start;
+
+  (void)Profile;
+  if(Event == CLOCK_EVENT_PRE_CHANGE)
+  {
+    /* Let the span on the wire finish at the old baud rate */
+    SerialTxHold = 1;
+    start = HAL_GetTick();
+    while((SerialTxSpan != 0U) && ((HAL_GetTick() - start) < SERIAL_FLUSH_MS))
+    {
+    }
+    return;
+  }
+
+  /* Oversampling by 8: BRR[2:0] holds USARTDIV[3:0] shifted right */
+  div = ((2U * HAL_RCC_GetPCLK2Freq()) + (SERIAL_BAUDRATE / 2U)) / SERIAL_BAUDRATE;
+  if(div < SERIAL_DIV_MIN)
+  {
+    return;
+  }
+  __HAL_UART_DISABLE(&SerialUart);
+  SerialUart.Instance->BRR = (div & 0xFFF0U) | ((div & 0x000FU) >> 1U);
+  __HAL_UART_ENABLE(&SerialUart);
+
+  SerialTxHold = 0;
+  SERIAL_StartTx();
+}
+
+/**
+  * @}
+  */
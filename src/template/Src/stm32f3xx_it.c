@@ -38,8 +38,11 @@
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
 #include "stm32f3xx_it.h"
+#include "fault.h"
 #include "main.h"
 #include "stm32f3_discovery.h"
+#include "latency.h"
+#include "sections.h"
 
 /** @addtogroup STM32F3xx_HAL_Examples
   * @{
@@ -53,6 +56,9 @@
 /* Private define ------------------------------------------------------------*/
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
+/* Millisecond tick of HAL_IncTick() / HAL_GetTick(), next to their code */
+static __IO uint32_t SysTickMs __CCMRAM_BSS;
+
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 
@@ -74,12 +80,10 @@ void NMI_Handler(void)
   * @param  None
   * @retval None
   */
-void HardFault_Handler(void)
+__attribute__((naked)) void HardFault_Handler(void)
 {
-  /* Go to infinite loop when Hard Fault exception occurs */
-  while (1)
-  {
-  }
+  /* Save a crash dump and reset, see fault.c */
+  FAULT_HANDLER_BODY();
 }
 
 /**
@@ -87,12 +91,10 @@ void HardFault_Handler(void)
   * @param  None
   * @retval None
   */
-void MemManage_Handler(void)
+__attribute__((naked)) void MemManage_Handler(void)
 {
-  /* Go to infinite loop when Memory Manage exception occurs */
-  while (1)
-  {
-  }
+  /* Save a crash dump and reset, see fault.c */
+  FAULT_HANDLER_BODY();
 }
 
 /**
@@ -100,12 +102,10 @@ void MemManage_Handler(void)
   * @param  None
   * @retval None
   */
-void BusFault_Handler(void)
+__attribute__((naked)) void BusFault_Handler(void)
 {
-  /* Go to infinite loop when Bus Fault exception occurs */
-  while (1)
-  {
-  }
+  /* Save a crash dump and reset, see fault.c */
+  FAULT_HANDLER_BODY();
 }
 
 /**
@@ -113,12 +113,10 @@ void BusFault_Handler(void)
   * @param  None
   * @retval None
   */
-void UsageFault_Handler(void)
+__attribute__((naked)) void UsageFault_Handler(void)
 {
-  /* Go to infinite loop when Usage Fault exception occurs */
-  while (1)
-  {
-  }
+  /* Save a crash dump and reset, see fault.c */
+  FAULT_HANDLER_BODY();
 }
 
 /**
@@ -148,14 +146,40 @@ void PendSV_Handler(void)
 {
 }
 
+/**
+  * @brief  Count one ms. Replaces the weak HAL version so that the whole
+  *         SysTick path, WDOG_Service() included, runs from CCM-RAM.
+  * @param  None
+  * @retval None
+  */
+__CCMRAM_FUNC void HAL_IncTick(void)
+{
+  SysTickMs++;
+}
+
+/**
+  * @brief  Milliseconds since boot. Replaces the weak HAL version.
+  * @param  None
+  * @retval Tick in ms
+  */
+__CCMRAM_FUNC uint32_t HAL_GetTick(void)
+{
+  return SysTickMs;
+}
+
 /**
   * @brief  This function handles SysTick Handler.
   * @param  None
   * @retval None
   */
-void SysTick_Handler(void)
+__CCMRAM_FUNC void SysTick_Handler(void)
 {
+  LATENCY_ENTER_SYSTICK();
   HAL_IncTick();
+  if((HAL_GetTick() % WDOG_SERVICE_MS) == 0U)
+  {
+    WDOG_Service();
+  }
 }
 
 /******************************************************************************/
@@ -170,9 +194,72 @@ void SysTick_Handler(void)
   * @param  None
   * @retval None
   */
-void EXTI0_IRQHandler(void)
+__CCMRAM_FUNC void EXTI0_IRQHandler(void)
+{
+  LATENCY_ENTER(LATENCY_IRQ_EXTI0);
+
+  /* HAL_GPIO_EXTI_IRQHandler() inline, it would run from FLASH */
+  if(__HAL_GPIO_EXTI_GET_IT(USER_BUTTON_PIN) != RESET)
+  {
+    __HAL_GPIO_EXTI_CLEAR_IT(USER_BUTTON_PIN);
+    HAL_GPIO_EXTI_Callback(USER_BUTTON_PIN);
+  }
+}
+
+/**
+  * @brief  This function handles External line 1 interrupt request, the
+  *         L3GD20 INT2 when it wakes the core from STOP, or its data-ready
+  *         edge in the AHRS demo, timed from the TIM17 capture of PE1.
+  * @param  None
+  * @retval None
+  */
+void EXTI1_IRQHandler(void)
+{
+  LATENCY_ENTER_CAPTURE(LATENCY_IRQ_DRDY, TSTAMP_GYRO);
+  HAL_GPIO_EXTI_IRQHandler(GYRO_INT2_PIN);
+}
+
+/**
+  * @brief  This function handles RTC wakeup timer interrupt request.
+  * @param  None
+  * @retval None
+  */
+void RTC_WKUP_IRQHandler(void)
+{
+  LPWR_IRQHandler();
+}
+
+/**
+  * @brief  This function handles USART1 interrupt request, idle line and
+  *         end of transmission of the telemetry UART.
+  * @param  None
+  * @retval None
+  */
+void USART1_IRQHandler(void)
+{
+  SERIAL_IRQHandler();
+}
+
+/**
+  * @brief  This function handles DMA1 channel 4 interrupt request, USART1
+  *         transmit.
+  * @param  None
+  * @retval None
+  */
+void DMA1_Channel4_IRQHandler(void)
+{
+  SERIAL_DmaTxIRQHandler();
+}
+
+/**
+  * @brief  This function handles DMA1 channel 5 interrupt request, USART1
+  *         receive.
+  * @param  None
+  * @retval None
+  */
+void DMA1_Channel5_IRQHandler(void)
 {
-  HAL_GPIO_EXTI_IRQHandler(USER_BUTTON_PIN);
+  SERIAL_DmaRxIRQHandler();
 }
 
 /**
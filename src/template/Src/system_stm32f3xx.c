@@ -150,6 +150,7 @@ const uint8_t APBPrescTable[8]  = {0, 0, 0, 0, 1, 2, 3, 4};
 /** @addtogroup STM32F3xx_System_Private_FunctionPrototypes
   * @{
   */
+static void SystemInit_RamSections(void);
 
 /**
   * @}
@@ -167,6 +168,9 @@ const uint8_t APBPrescTable[8]  = {0, 0, 0, 0, 1, 2, 3, 4};
   */
 void SystemInit(void)
 {
+  /* RAM code and CCM-RAM sections ------------------------------------------*/
+  SystemInit_RamSections();
+
   /* FPU settings ------------------------------------------------------------*/
   #if (__FPU_PRESENT == 1) && (__FPU_USED == 1)
     SCB->CPACR |= ((3UL << 10*2)|(3UL << 11*2));  /* set CP10 and CP11 Full Access */
@@ -204,6 +208,37 @@ void SystemInit(void)
 #endif
 }
 
+/**
+  * @brief  Copy the .ramfunc code and the .ccmram init-values from FLASH and
+  *         clear .ccmbss. The startup code only handles .data and .bss.
+  * @param  None
+  * @retval None
+  */
+static void SystemInit_RamSections(void)
+{
+  extern uint32_t _siramfunc, _sramfunc, _eramfunc;
+  extern uint32_t _siccmram, _sccmram, _eccmram, _sccmbss, _eccmbss;
+  uint32_t *src = &_siramfunc;
+  uint32_t *dst = &_sramfunc;
+
+  while (dst < &_eramfunc)
+  {
+    *dst++ = *src++;
+  }
+
+  src = &_siccmram;
+  dst = &_sccmram;
+  while (dst < &_eccmram)
+  {
+    *dst++ = *src++;
+  }
+
+  for (dst = &_sccmbss; dst < &_eccmbss; dst++)
+  {
+    *dst = 0;
+  }
+}
+
 /**
    * @brief  Update SystemCoreClock variable according to Clock Register Values.
   *         The SystemCoreClock variable contains the core clock (HCLK), it can
@@ -0,0 +1,304 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Src/tstamp.c
+  * @brief   Microsecond time base and data-ready edge timestamps.
+  *
+  *          TIM2, the only 32-bit timer, counts microseconds freely and
+  *          wraps after 71 minutes. The data-ready lines of the sensors are
+  *          not on TIM2 pins, they are captured by 16-bit timers running at
+  *          the same 1 MHz:
+  *            - PE1 gyro INT2/DRDY         TIM17_CH1 (AF4)
+  *            - PE4 accelerometer INT1     TIM3_CH3  (AF2)
+  *            - PE2 magnetometer DRDY      TIM3_CH1  (AF2)
+  *          All three counters are started together, so the 16-bit counters
+  *          track the low half of TIM2. A capture is extended to 32 bits
+  *          with TIM2 read afterwards: exact as long as it is collected
+  *          within 65 ms of the edge.
+  *
+  *          The timestamp is latched by hardware on the edge, it carries no
+  *          interrupt or polling latency. TSTAMP_Get() is called from the
+  *          acquisition loop. Reading a capture clears its flag, so a
+  *          handler of the data-ready line takes it with TSTAMP_Latch(),
+  *          which keeps it for the next TSTAMP_Get().
+  *
+  *          Call TSTAMP_Init() after BSP_GYRO_Init() / BSP_ACCELERO_Init(),
+  *          which configure PE1 / PE2 / PE4 as plain inputs. A change of
+  *          clock profile reloads the prescalers, the count goes on.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "tstamp.h"
+#include "clock.h"
+
+/** @addtogroup BSP_Examples
+  * @{
+  */
+
+/* Private typedef -----------------------------------------------------------*/
+/**
+  * @brief Capture input of a data-ready line
+  */
+typedef struct
+{
+  TIM_HandleTypeDef *Handle;
+  uint32_t           Channel;
+  uint32_t           Flag;
+} TSTAMP_InputTypeDef;
+
+/* Private define ------------------------------------------------------------*/
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static TIM_HandleTypeDef TimClock;    /* TIM2, 32-bit microsecond counter */
+static TIM_HandleTypeDef TimMems;     /* TIM3, accelerometer and magnetometer */
+static TIM_HandleTypeDef TimGyro;     /* TIM17, gyroscope */
+
+static const TSTAMP_InputTypeDef TstampInputs[TSTAMP_COUNT] =
+{
+  { &TimGyro, TIM_CHANNEL_1, TIM_FLAG_CC1 },
+  { &TimMems, TIM_CHANNEL_3, TIM_FLAG_CC3 },
+  { &TimMems, TIM_CHANNEL_1, TIM_FLAG_CC1 },
+};
+
+/* Captures taken by TSTAMP_Latch(), one bit per source in TstampHeldMask */
+static __IO uint32_t TstampHeld[TSTAMP_COUNT];
+static __IO uint32_t TstampHeldMask;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t TSTAMP_TimerClock(uint32_t Pclk, uint32_t ApbPrescaler);
+static void     TSTAMP_BaseInit(TIM_HandleTypeDef *htim, TIM_TypeDef *Instance,
+                                uint32_t TimerClock, uint32_t Period);
+static void     TSTAMP_ClockChanged(CLOCK_EventTypeDef Event, CLOCK_ProfileTypeDef Profile);
+static HAL_StatusTypeDef TSTAMP_Read(const TSTAMP_InputTypeDef *pInput, uint32_t *pTimestamp);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Start the microsecond counter and the data-ready captures.
+  * @param  None
+  * @retval None
+  */
+void TSTAMP_Init(void)
+{
+  GPIO_InitTypeDef gpio;
+  TIM_IC_InitTypeDef ic;
+  uint32_t apb1 = TSTAMP_TimerClock(HAL_RCC_GetPCLK1Freq(), RCC->CFGR & RCC_CFGR_PPRE1);
+  uint32_t apb2 = TSTAMP_TimerClock(HAL_RCC_GetPCLK2Freq(), RCC->CFGR & RCC_CFGR_PPRE2);
+  uint32_t i;
+
+  __HAL_RCC_TIM2_CLK_ENABLE();
+  __HAL_RCC_TIM3_CLK_ENABLE();
+  __HAL_RCC_TIM17_CLK_ENABLE();
+  __HAL_RCC_GPIOE_CLK_ENABLE();
+
+  gpio.Mode = GPIO_MODE_AF_PP;
+  gpio.Pull = GPIO_NOPULL;
+  gpio.Speed = GPIO_SPEED_FREQ_HIGH;
+  gpio.Pin = GPIO_PIN_1;
+  gpio.Alternate = GPIO_AF4_TIM17;
+  HAL_GPIO_Init(GPIOE, &gpio);
+  gpio.Pin = GPIO_PIN_2 | GPIO_PIN_4;
+  gpio.Alternate = GPIO_AF2_TIM3;
+  HAL_GPIO_Init(GPIOE, &gpio);
+
+  TSTAMP_BaseInit(&TimClock, TIM2, apb1, 0xFFFFFFFFU);
+  HAL_TIM_Base_Init(&TimClock);
+  TSTAMP_BaseInit(&TimMems, TIM3, apb1, 0xFFFFU);
+  HAL_TIM_IC_Init(&TimMems);
+  TSTAMP_BaseInit(&TimGyro, TIM17, apb2, 0xFFFFU);
+  HAL_TIM_IC_Init(&TimGyro);
+
+  ic.ICPolarity = TIM_ICPOLARITY_RISING;
+  ic.ICSelection = TIM_ICSELECTION_DIRECTTI;
+  ic.ICPrescaler = TIM_ICPSC_DIV1;
+  ic.ICFilter = 0;
+  for(i = 0; i < TSTAMP_COUNT; i++)
+  {
+    HAL_TIM_IC_ConfigChannel(TstampInputs[i].Handle, &ic, TstampInputs[i].Channel);
+    HAL_TIM_IC_Start(TstampInputs[i].Handle, TstampInputs[i].Channel);
+  }
+
+  /* Restart the three counters from 0 together: reload the prescalers and
+     enable them back to back, a few CPU cycles apart out of 72 per tick */
+  __disable_irq();
+  TIM2->CR1 &= ~TIM_CR1_CEN;
+  TIM3->CR1 &= ~TIM_CR1_CEN;
+  TIM17->CR1 &= ~TIM_CR1_CEN;
+  TIM2->CNT = 0;
+  TIM3->CNT = 0;
+  TIM17->CNT = 0;
+  TIM2->EGR = TIM_EGR_UG;
+  TIM3->EGR = TIM_EGR_UG;
+  TIM17->EGR = TIM_EGR_UG;
+  TIM3->CR1 |= TIM_CR1_CEN;
+  TIM17->CR1 |= TIM_CR1_CEN;
+  TIM2->CR1 |= TIM_CR1_CEN;
+  __enable_irq();
+
+  /* Discard edges captured before the restart */
+  for(i = 0; i < TSTAMP_COUNT; i++)
+  {
+    HAL_TIM_ReadCapturedValue(TstampInputs[i].Handle, TstampInputs[i].Channel);
+  }
+  TstampHeldMask = 0;
+
+  CLOCK_RegisterCallback(TSTAMP_ClockChanged);
+}
+
+/**
+  * @brief  Current time.
+  * @param  None
+  * @retval Microseconds since TSTAMP_Init(), modulo 2^32
+  */
+uint32_t TSTAMP_Now(void)
+{
+  return TIM2->CNT;
+}
+
+/**
+  * @brief  Time of the last data-ready edge of a sensor.
+  * @param  Source: TSTAMP_GYRO, TSTAMP_ACC or TSTAMP_MAG
+  * @param  pTimestamp: set to the edge time, same base as TSTAMP_Now()
+  * @retval HAL_ERROR if no edge was captured since the previous call
+  */
+HAL_StatusTypeDef TSTAMP_Get(TSTAMP_SourceTypeDef Source, uint32_t *pTimestamp)
+{
+  HAL_StatusTypeDef status;
+  uint32_t primask;
+
+  if(Source >= TSTAMP_COUNT)
+  {
+    return HAL_ERROR;
+  }
+
+  /* A handler may latch the same capture between the test and the read */
+  primask = __get_PRIMASK();
+  __disable_irq();
+  if((TstampHeldMask & (1U << Source)) != 0U)
+  {
+    TstampHeldMask &= ~(1U << Source);
+    *pTimestamp = TstampHeld[Source];
+    status = HAL_OK;
+  }
+  else
+  {
+    status = TSTAMP_Read(&TstampInputs[Source], pTimestamp);
+  }
+  __set_PRIMASK(primask);
+
+  return status;
+}
+
+/**
+  * @brief  Take the last data-ready edge of a sensor from an interrupt
+  *         handler. The time is also kept for the next TSTAMP_Get().
+  * @param  Source: TSTAMP_GYRO, TSTAMP_ACC or TSTAMP_MAG
+  * @param  pTimestamp: set to the edge time, same base as TSTAMP_Now()
+  * @retval HAL_ERROR if no edge was captured since the previous call
+  */
+HAL_StatusTypeDef TSTAMP_Latch(TSTAMP_SourceTypeDef Source, uint32_t *pTimestamp)
+{
+  if((Source >= TSTAMP_COUNT) || (TSTAMP_Read(&TstampInputs[Source], pTimestamp) != HAL_OK))
+  {
+    return HAL_ERROR;
+  }
+
+  TstampHeld[Source] = *pTimestamp;
+  TstampHeldMask |= (1U << Source);
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Extend a pending capture to 32 bits.
+  * @param  pInput: capture input
+  * @param  pTimestamp: set to the edge time
+  * @retval HAL_ERROR if the capture flag is clear
+  */
+static HAL_StatusTypeDef TSTAMP_Read(const TSTAMP_InputTypeDef *pInput, uint32_t *pTimestamp)
+{
+  uint16_t capture;
+  uint32_t now;
+
+  if(__HAL_TIM_GET_FLAG(pInput->Handle, pInput->Flag) == RESET)
+  {
+    return HAL_ERROR;
+  }
+
+  /* Reading the capture register clears the flag. TIM2 is read after it,
+     the edge lies at most 0xFFFF us back */
+  capture = (uint16_t)HAL_TIM_ReadCapturedValue(pInput->Handle, pInput->Channel);
+  now = TIM2->CNT;
+  *pTimestamp = now - (uint16_t)((uint16_t)now - capture);
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Timer kernel clock of an APB bus: twice PCLK when the bus is divided.
+  * @param  Pclk: bus clock in Hz
+  * @param  ApbPrescaler: PPREx field of RCC_CFGR, 0 when not divided
+  * @retval Timer clock in Hz
+  */
+static uint32_t TSTAMP_TimerClock(uint32_t Pclk, uint32_t ApbPrescaler)
+{
+  return (ApbPrescaler == 0U) ? Pclk : (2U * Pclk);
+}
+
+/**
+  * @brief  Keep the counters at 1 MHz across a clock profile change.
+  * @param  Event: CLOCK_EVENT_PRE_CHANGE or CLOCK_EVENT_POST_CHANGE
+  * @param  Profile: new profile, unused
+  * @retval None
+  */
+static void TSTAMP_ClockChanged(CLOCK_EventTypeDef Event, CLOCK_ProfileTypeDef Profile)
+{
+  uint32_t apb1, apb2, now;
+
+  (void)Profile;
+  if(Event != CLOCK_EVENT_POST_CHANGE)
+  {
+    return;
+  }
+  apb1 = TSTAMP_TimerClock(HAL_RCC_GetPCLK1Freq(), RCC->CFGR & RCC_CFGR_PPRE1);
+  apb2 = TSTAMP_TimerClock(HAL_RCC_GetPCLK2Freq(), RCC->CFGR & RCC_CFGR_PPRE2);
+
+  /* A new prescaler only loads on an update event, which clears the
+     counters: put the count back, the 16-bit counters in step with TIM2 */
+  __disable_irq();
+  now = TIM2->CNT;
+  TIM2->PSC = (apb1 / TSTAMP_FREQ) - 1U;
+  TIM3->PSC = (apb1 / TSTAMP_FREQ) - 1U;
+  TIM17->PSC = (apb2 / TSTAMP_FREQ) - 1U;
+  TIM2->EGR = TIM_EGR_UG;
+  TIM3->EGR = TIM_EGR_UG;
+  TIM17->EGR = TIM_EGR_UG;
+  TIM2->CNT = now;
+  TIM3->CNT = now & 0xFFFFU;
+  TIM17->CNT = now & 0xFFFFU;
+  __enable_irq();
+}
+
+/**
+  * @brief  Fill the time base of a handle for a 1 MHz up-counter.
+  * @param  htim: handle
+  * @param  Instance: timer
+  * @param  TimerClock: kernel clock of the timer in Hz
+  * @param  Period: auto-reload value, full range of the counter
+  * @retval None
+  */
+static void TSTAMP_BaseInit(TIM_HandleTypeDef *htim, TIM_TypeDef *Instance,
+                            uint32_t TimerClock, uint32_t Period)
+{
+  htim->Instance = Instance;
+  htim->Init.Prescaler = (TimerClock / TSTAMP_FREQ) - 1U;
+  htim->Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim->Init.Period = Period;
+  htim->Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim->Init.RepetitionCounter = 0;
+  htim->Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+}
+
+/**
+  * @}
+  */
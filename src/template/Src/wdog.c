@@ -0,0 +1,294 @@
+/**
+  ******************************************************************************
+  * @file    BSP/Src/wdog.c
+  * @brief   Independent watchdog fed only while every task is alive.
+  *
+  *          Each supervised task calls WDOG_CheckIn() at least once per
+  *          check-in period. WDOG_Service() runs every WDOG_SERVICE_MS
+  *          from SysTick and refreshes the IWDG only when no active task
+  *          is late. A late task stops the feeding for good: the IWDG resets
+  *          the device WDOG_TIMEOUT_MS later. Recovery from a stall is
+  *          therefore bounded by the check-in period plus WDOG_TIMEOUT_MS.
+  *          Stalls caught:
+  *            - a thread-mode spin, such as an I2C transfer waiting
+  *              for a flag that never comes: SysTick runs, the task
+  *              misses its check-in
+  *            - an interrupt handler that never returns, or interrupts
+  *              masked: SysTick does not run, nothing feeds the IWDG
+  *
+  *          The late task is written to a __NOINIT record, which survives
+  *          the reset. WDOG_Init() reads the reset cause from RCC_CSR and
+  *          appends abnormal resets, with the task, to the reset log of
+  *          the key-value store for post-mortem.
+  *
+  *          The IWDG cannot be stopped and keeps counting in STOP mode,
+  *          tickless idle periods are limited to WDOG_MAX_IDLE_MS. It is
+  *          frozen while the core is halted by a debugger unless NDEBUG
+  *          is defined.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "wdog.h"
+#include "kvstore.h"
+#include "sections.h"
+
+/** @addtogroup BSP_Examples
+  * @{
+  */
+
+/* Private typedef -----------------------------------------------------------*/
+/**
+  * @brief Stall record handed over to the next boot
+  */
+typedef struct
+{
+  uint32_t Magic;
+  uint32_t Task;
+  uint32_t Tick;
+  uint32_t Check;     /* Magic ^ Task ^ Tick, RAM is random after power-up */
+} WDOG_StallTypeDef;
+
+/* Private define ------------------------------------------------------------*/
+#define WDOG_STALL_MAGIC      0x57444F47U     /* "WDOG" */
+#define WDOG_LSI_HZ           40000U
+#define WDOG_PRESCALER_DIV    64U             /* IWDG_PRESCALER_64 */
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static IWDG_HandleTypeDef IwdgHandle;
+
+static const uint32_t WdogPeriods[WDOG_TASK_COUNT] =
+{
+  WDOG_PERIOD_MAIN_MS,
+  WDOG_PERIOD_FLOG_MS,
+};
+
+static volatile uint32_t WdogLast[WDOG_TASK_COUNT];
+static volatile uint32_t WdogActive;          /* one bit per task */
+static volatile uint8_t  WdogExpired;
+static uint8_t           WdogRunning;
+
+static WDOG_ResetTypeDef    ResetCause = WDOG_RESET_POWER;
+static WDOG_ResetLogTypeDef ResetLog;
+static WDOG_StallTypeDef    WdogStall __NOINIT;
+
+/* Private function prototypes -----------------------------------------------*/
+static WDOG_ResetTypeDef WDOG_ReadResetCause(void);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Log the reset cause and start the IWDG, supervising WDOG_TASK_MAIN.
+  * @note   Call after KV_Init(), and after LPWR_Init() whose LSI calibration
+  *         holds the main loop for 200 ms.
+  * @param  None
+  * @retval None
+  */
+void WDOG_Init(void)
+{
+  uint32_t now;
+  uint32_t i;
+
+  ResetCause = WDOG_ReadResetCause();
+
+  if(KV_Get(KV_KEY_RESET_LOG, &ResetLog, sizeof(ResetLog), NULL) != HAL_OK)
+  {
+    memset(&ResetLog, 0, sizeof(ResetLog));
+    ResetLog.LastTask = WDOG_NO_TASK;
+  }
+
+  if((ResetCause != WDOG_RESET_POWER) && (ResetCause != WDOG_RESET_PIN))
+  {
+    ResetLog.Counts[ResetCause]++;
+    ResetLog.LastCause = ResetCause;
+    ResetLog.LastTask = WDOG_NO_TASK;
+    ResetLog.LastTick = 0;
+    if((ResetCause == WDOG_RESET_IWDG) && (WdogStall.Magic == WDOG_STALL_MAGIC) &&
+       (WdogStall.Check == (WdogStall.Magic ^ WdogStall.Task ^ WdogStall.Tick)))
+    {
+      ResetLog.LastTask = WdogStall.Task;
+      ResetLog.LastTick = WdogStall.Tick;
+    }
+    KV_Set(KV_KEY_RESET_LOG, &ResetLog, sizeof(ResetLog));
+  }
+  WdogStall.Magic = 0;
+
+#ifndef NDEBUG
+  __HAL_DBGMCU_FREEZE_IWDG();
+#endif /* NDEBUG */
+
+  now = HAL_GetTick();
+  for(i = 0; i < WDOG_TASK_COUNT; i++)
+  {
+    WdogLast[i] = now;
+  }
+  WdogActive = 1U << WDOG_TASK_MAIN;
+  WdogExpired = 0;
+
+  /* Starting the IWDG also starts the LSI */
+  IwdgHandle.Instance = IWDG;
+  IwdgHandle.Init.Prescaler = IWDG_PRESCALER_64;
+  IwdgHandle.Init.Reload = (WDOG_TIMEOUT_MS * (WDOG_LSI_HZ / WDOG_PRESCALER_DIV)) / 1000U;
+  IwdgHandle.Init.Window = IWDG_WINDOW_DISABLE;
+  if(HAL_IWDG_Init(&IwdgHandle) == HAL_OK)
+  {
+    WdogRunning = 1;
+  }
+}
+
+/**
+  * @brief  Put a task under supervision, its period starts now.
+  * @param  Task: WDOG_TASK_xxx
+  * @retval None
+  */
+void WDOG_TaskStart(WDOG_TaskTypeDef Task)
+{
+  if(Task < WDOG_TASK_COUNT)
+  {
+    WdogLast[Task] = HAL_GetTick();
+    WdogActive |= 1U << Task;
+  }
+}
+
+/**
+  * @brief  End the supervision of a task that stops running.
+  * @param  Task: WDOG_TASK_xxx
+  * @retval None
+  */
+void WDOG_TaskStop(WDOG_TaskTypeDef Task)
+{
+  if(Task < WDOG_TASK_COUNT)
+  {
+    WdogActive &= ~(1U << Task);
+  }
+}
+
+/**
+  * @brief  Report a task alive. Cheap, call it from the task loop.
+  * @param  Task: WDOG_TASK_xxx
+  * @retval None
+  */
+void WDOG_CheckIn(WDOG_TaskTypeDef Task)
+{
+  if(Task < WDOG_TASK_COUNT)
+  {
+    WdogLast[Task] = HAL_GetTick();
+  }
+}
+
+/**
+  * @brief  Feed the IWDG if no supervised task is late.
+  * @note   Called from SysTick every WDOG_SERVICE_MS, and before a tickless
+  *         idle period. Check-ins come from thread mode only, so none can
+  *         be newer than the tick read here. In CCM-RAM with the rest of
+  *         the SysTick path.
+  * @param  None
+  * @retval None
+  */
+__CCMRAM_FUNC void WDOG_Service(void)
+{
+  uint32_t now = HAL_GetTick();
+  uint32_t i;
+
+  if((WdogRunning == 0U) || (WdogExpired != 0U))
+  {
+    return;
+  }
+
+  for(i = 0; i < WDOG_TASK_COUNT; i++)
+  {
+    if(((WdogActive & (1U << i)) != 0U) && ((now - WdogLast[i]) > WdogPeriods[i]))
+    {
+      /* Let the IWDG expire, and tell the next boot who stalled */
+      WdogStall.Task = i;
+      WdogStall.Tick = now;
+      WdogStall.Magic = WDOG_STALL_MAGIC;
+      WdogStall.Check = WDOG_STALL_MAGIC ^ i ^ now;
+      WdogExpired = 1;
+      return;
+    }
+  }
+
+  HAL_IWDG_Refresh(&IwdgHandle);
+}
+
+/**
+  * @brief  Whether the IWDG runs, it cannot be stopped once started.
+  * @param  None
+  * @retval 1 after WDOG_Init(), 0 before
+  */
+uint8_t WDOG_IsRunning(void)
+{
+  return WdogRunning;
+}
+
+/**
+  * @brief  Cause of the last reset.
+  * @param  None
+  * @retval WDOG_RESET_xxx, read by WDOG_Init()
+  */
+WDOG_ResetTypeDef WDOG_GetResetCause(void)
+{
+  return ResetCause;
+}
+
+/**
+  * @brief  Reset history, as stored in the key-value store.
+  * @param  None
+  * @retval Pointer to the log, valid after WDOG_Init()
+  */
+const WDOG_ResetLogTypeDef *WDOG_GetResetLog(void)
+{
+  return &ResetLog;
+}
+
+/**
+  * @brief  Decode and clear the RCC_CSR reset flags.
+  * @note   Every internal reset also pulses NRST and sets PINRSTF, and a
+  *         power-on sets PORRSTF with it: the most specific flag wins.
+  * @param  None
+  * @retval WDOG_RESET_xxx
+  */
+static WDOG_ResetTypeDef WDOG_ReadResetCause(void)
+{
+  WDOG_ResetTypeDef cause;
+
+  if(__HAL_RCC_GET_FLAG(RCC_FLAG_IWDGRST) != RESET)
+  {
+    cause = WDOG_RESET_IWDG;
+  }
+  else if(__HAL_RCC_GET_FLAG(RCC_FLAG_WWDGRST) != RESET)
+  {
+    cause = WDOG_RESET_WWDG;
+  }
+  else if(__HAL_RCC_GET_FLAG(RCC_FLAG_LPWRRST) != RESET)
+  {
+    cause = WDOG_RESET_LOWPOWER;
+  }
+  else if(__HAL_RCC_GET_FLAG(RCC_FLAG_SFTRST) != RESET)
+  {
+    cause = WDOG_RESET_SOFTWARE;
+  }
+  else if(__HAL_RCC_GET_FLAG(RCC_FLAG_OBLRST) != RESET)
+  {
+    cause = WDOG_RESET_OPTION;
+  }
+  else if(__HAL_RCC_GET_FLAG(RCC_FLAG_PORRST) != RESET)
+  {
+    cause = WDOG_RESET_POWER;
+  }
+  else
+  {
+    cause = WDOG_RESET_PIN;
+  }
+
+  __HAL_RCC_CLEAR_RESET_FLAGS();
+
+  return cause;
+}
+
+/**
+  * @}
+  */
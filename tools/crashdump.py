@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+"""Decode the crash dump written by fault.c.
+
+    make crashdump                          # reads the KVSTORE region and runs this script
+    crashdump.py kvstore.bin --elf build/<profile>/main
+    crashdump.py capture.bin --elf build/<profile>/main
+    crashdump.py ram.bin --all
+
+The input is any raw image holding FAULT_RecordTypeDef: a dump of the
+KVSTORE flash region, of RAM, or a record received as is, such as a UART
+capture of the boot after a fault (main.c sends the record there). Records are
+found by their magic and validated with their XOR check; the last one in
+the image is printed unless --all is given. With --elf, the PC, LR and the
+stack words that look like return addresses are resolved to function and
+line with addr2line. The layout mirrors src/template/Inc/fault.h.
+"""
+
+import argparse
+import struct
+import subprocess
+import sys
+
+MAGIC = 0x544C5546
+VERSION = 1
+STACK_WORDS = 64
+FIELDS = ["magic", "version", "check", "tick", "exc_return", "ipsr", "sp"] + \
+         ["r%d" % i for i in range(13)] + \
+         ["lr", "pc", "xpsr", "cfsr", "hfsr", "mmfar", "bfar", "afsr", "stack_words"]
+RECORD = struct.Struct("<%dI" % (len(FIELDS) + STACK_WORDS))
+
+EXCEPTIONS = {3: "HardFault", 4: "MemManage", 5: "BusFault", 6: "UsageFault"}
+
+CFSR_BITS = [
+    (0, "IACCVIOL", "instruction fetch from a no-execute region"),
+    (1, "DACCVIOL", "data access violation, MMFAR holds the address"),
+    (3, "MUNSTKERR", "MemManage fault on exception return unstacking"),
+    (4, "MSTKERR", "MemManage fault on exception entry stacking"),
+    (5, "MLSPERR", "MemManage fault on lazy FPU state preservation"),
+    (8, "IBUSERR", "bus error on instruction fetch"),
+    (9, "PRECISERR", "precise data bus error, BFAR holds the address"),
+    (10, "IMPRECISERR", "imprecise data bus error, PC is after the access"),
+    (11, "UNSTKERR", "bus fault on exception return unstacking"),
+    (12, "STKERR", "bus fault on exception entry stacking, stack overflow?"),
+    (13, "LSPERR", "bus fault on lazy FPU state preservation"),
+    (16, "UNDEFINSTR", "undefined instruction"),
+    (17, "INVSTATE", "invalid EPSR state, e.g. branch to an even address"),
+    (18, "INVPC", "invalid EXC_RETURN on exception return"),
+    (19, "NOCP", "coprocessor access, FPU disabled?"),
+    (24, "UNALIGNED", "unaligned access"),
+    (25, "DIVBYZERO", "division by zero"),
+]
+MMARVALID = 1 << 7
+BFARVALID = 1 << 15
+
+HFSR_BITS = [
+    (1, "VECTTBL", "bus fault on vector table read"),
+    (30, "FORCED", "escalated configurable fault, see CFSR"),
+    (31, "DEBUGEVT", "debug event"),
+]
+
+# Memories that can hold code: flash, CCM RAM and SRAM (__RAMFUNC)
+CODE_RANGES = [(0x08000000, 0x08040000), (0x10000000, 0x10002000), (0x20000000, 0x2000A000)]
+
+
+def scan(image):
+    """Yield (offset, record dict) of every valid record in the image.
+
+    The magic is searched at any byte offset: a record in a UART capture
+    is not aligned.
+    """
+    magic = struct.pack("<I", MAGIC)
+    offset = image.find(magic)
+    while 0 <= offset <= len(image) - RECORD.size:
+        words = RECORD.unpack_from(image, offset)
+        check = 0
+        for w in words:
+            check ^= w
+        rec = dict(zip(FIELDS, words))
+        if check == 0 and rec["version"] == VERSION and rec["stack_words"] <= STACK_WORDS:
+            rec["stack"] = list(words[len(FIELDS):len(FIELDS) + rec["stack_words"]])
+            yield offset, rec
+        offset = image.find(magic, offset + 1)
+
+
+def is_code(value):
+    """Whether a word looks like a Thumb return address."""
+    return (value & 1) and any(lo <= value < hi for lo, hi in CODE_RANGES)
+
+
+def symbolize(elf, addresses, addr2line):
+    """Return {address: "function at file:line"} for the given addresses."""
+    if not elf or not addresses:
+        return {}
+    addresses = sorted(set(addresses))
+    cmd = [addr2line, "-e", elf, "-f", "-C"] + ["0x%08x" % (a & ~1) for a in addresses]
+    try:
+        out = subprocess.run(cmd, check=True, capture_output=True, text=True).stdout.splitlines()
+    except (OSError, subprocess.CalledProcessError) as e:
+        print("addr2line failed: %s" % e, file=sys.stderr)
+        return {}
+    return {a: "%s at %s" % (out[2 * i], out[2 * i + 1])
+            for i, a in enumerate(addresses) if 2 * i + 1 < len(out)}
+
+
+def bits(value, table):
+    return [(name, text) for bit, name, text in table if value & (1 << bit)]
+
+
+def report(rec, elf=None, addr2line="arm-none-eabi-addr2line"):
+    """Return the text report of one record."""
+    lines = []
+    exc = rec["ipsr"] & 0x1FF
+    lines.append("%s at tick %d ms" % (EXCEPTIONS.get(exc, "exception %d" % exc), rec["tick"]))
+
+    code = [rec["pc"], rec["lr"] | 1] + [w for w in rec["stack"] if is_code(w)]
+    syms = symbolize(elf, code, addr2line)
+
+    def sym(value):
+        s = syms.get(value)
+        return "  %s" % s if s else ""
+
+    lines.append("  pc   0x%08x%s" % (rec["pc"], sym(rec["pc"])))
+    lines.append("  lr   0x%08x%s" % (rec["lr"], sym(rec["lr"] | 1)))
+    lines.append("  sp   0x%08x (%s)" % (rec["sp"], "psp" if rec["exc_return"] & 4 else "msp"))
+    lines.append("  xpsr 0x%08x  exc_return 0x%08x%s" % (
+        rec["xpsr"], rec["exc_return"], "" if rec["exc_return"] & 0x10 else "  fpu frame"))
+    for i in range(0, 13, 4):
+        lines.append("  " + "  ".join("r%-2d 0x%08x" % (r, rec["r%d" % r])
+                                      for r in range(i, min(i + 4, 13))))
+
+    lines.append("  cfsr 0x%08x  hfsr 0x%08x  afsr 0x%08x" % (rec["cfsr"], rec["hfsr"], rec["afsr"]))
+    for name, text in bits(rec["hfsr"], HFSR_BITS) + bits(rec["cfsr"], CFSR_BITS):
+        lines.append("    %-12s %s" % (name, text))
+    if rec["cfsr"] & MMARVALID:
+        lines.append("  mmfar 0x%08x" % rec["mmfar"])
+    if rec["cfsr"] & BFARVALID:
+        lines.append("  bfar 0x%08x" % rec["bfar"])
+
+    lines.append("  stack, %d word(s):" % len(rec["stack"]))
+    for i, w in enumerate(rec["stack"]):
+        if is_code(w):
+            lines.append("    [sp+0x%03x] 0x%08x%s" % (4 * i, w, sym(w)))
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("dump", help="raw image holding the record")
+    parser.add_argument("--elf", help="firmware ELF, to resolve addresses")
+    parser.add_argument("--addr2line", default="arm-none-eabi-addr2line")
+    parser.add_argument("--all", action="store_true", help="print every record found")
+    args = parser.parse_args()
+
+    with open(args.dump, "rb") as f:
+        image = f.read()
+
+    records = list(scan(image))
+    if not records:
+        print("no crash dump found", file=sys.stderr)
+        sys.exit(1)
+    if not args.all:
+        records = records[-1:]
+    for offset, rec in records:
+        print("record at offset 0x%x" % offset)
+        print(report(rec, args.elf, args.addr2line))
+
+
+if __name__ == "__main__":
+    main()
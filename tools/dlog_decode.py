@@ -0,0 +1,220 @@
+#!/usr/bin/env python3
+"""Expand the deferred log records of dlog.c with the format strings of the ELF.
+
+    stty -F /dev/ttyUSB0 3000000 raw && cat /dev/ttyUSB0 > capture.bin
+    dlog_decode.py capture.bin --elf build/release/main
+    cat /dev/ttyUSB0 | dlog_decode.py - --elf build/release/main
+
+A record is little-endian words: a header (0xD1 sync byte, argument count,
+16-bit format id), the tick in ms, then one word per argument. The format
+id is the offset of the string in the .dlog_fmt section, which the linker
+script keeps in the ELF without loading it. Records are recognized by the
+sync byte, a known id and the argument count of its format; every other
+byte of the stream, printf output for instance, is passed through as text.
+
+Conversions take one word each: integers as 32 bits, %f/%e/%g as the bits of
+a float (DLOG_Float()), %s as the address of a string in the ELF. Length
+modifiers are ignored. The layout mirrors src/template/Inc/dlog.h.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+SYNC = 0xD1
+MAX_ARGS = 6
+ID_DROPPED = 0xFFFF
+SECTION = ".dlog_fmt"
+
+SHT_PROGBITS = 1
+SHF_ALLOC = 2
+
+CONVERSION = re.compile(r"%(?P<flags>[-+ #0]*)(?P<width>\d*)(?:\.(?P<prec>\d*))?"
+                        r"(?P<length>hh|h|ll|l|j|z|t|L)?(?P<conv>[diuxXoscpfFeEgGaA%])")
+
+
+class Elf:
+    """Sections of a little-endian ELF file, enough to read strings back."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[5] != 1:
+            raise ValueError("%s: not a little-endian ELF file" % path)
+        if self.data[4] == 1:
+            shoff, = struct.unpack_from("<I", self.data, 0x20)
+            shentsize, shnum, shstrndx = struct.unpack_from("<HHH", self.data, 0x2E)
+            layout = struct.Struct("<IIIIIIIIII")
+        else:
+            shoff, = struct.unpack_from("<Q", self.data, 0x28)
+            shentsize, shnum, shstrndx = struct.unpack_from("<HHH", self.data, 0x3A)
+            layout = struct.Struct("<IIQQQQIIQQ")
+        headers = [layout.unpack_from(self.data, shoff + i * shentsize) for i in range(shnum)]
+        names = headers[shstrndx][4]
+        self.sections = {}
+        for name, kind, flags, addr, offset, size, _, _, _, _ in headers:
+            end = self.data.index(b"\0", names + name)
+            self.sections[self.data[names + name:end].decode()] = (kind, flags, addr, offset, size)
+
+    def section(self, name):
+        """Content of a section, None if the ELF has none of that name."""
+        if name not in self.sections:
+            return None
+        _, _, _, offset, size = self.sections[name]
+        return self.data[offset:offset + size]
+
+    def string(self, address):
+        """NUL-terminated string at a load address, None outside the image."""
+        for kind, flags, addr, offset, size in self.sections.values():
+            if kind == SHT_PROGBITS and flags & SHF_ALLOC and addr <= address < addr + size:
+                start = offset + address - addr
+                end = self.data.find(b"\0", start, offset + size)
+                return self.data[start:end if end >= 0 else offset + size].decode("utf-8", "replace")
+        return None
+
+
+def formats(elf):
+    """Return {id: format string} from the .dlog_fmt section."""
+    table = {}
+    data = elf.section(SECTION)
+    if data is None:
+        raise ValueError("no %s section, firmware built without dlog.h?" % SECTION)
+    offset = 0
+    while offset < len(data):
+        if data[offset] == 0:
+            offset += 1
+            continue
+        end = data.index(b"\0", offset)
+        table[offset] = data[offset:end].decode("utf-8", "replace")
+        offset = end + 1
+    return table
+
+
+def arguments(fmt):
+    """Number of words a format consumes."""
+    return sum(1 for m in CONVERSION.finditer(fmt) if m.group("conv") != "%")
+
+
+def expand(fmt, words, elf):
+    """Apply a format to the argument words of a record."""
+    args = iter(words)
+
+    def convert(m):
+        conv = m.group("conv")
+        if conv == "%":
+            return "%"
+        word = next(args)
+        spec = "%" + m.group("flags") + m.group("width")
+        if m.group("prec") is not None:
+            spec += "." + m.group("prec")
+        if conv in "di":
+            return (spec + "d") % (word - (1 << 32) if word & 0x80000000 else word)
+        if conv == "u":
+            return (spec + "d") % word
+        if conv in "xXo":
+            return (spec + conv) % word
+        if conv == "c":
+            return (spec + "c") % chr(word & 0xFF)
+        if conv == "p":
+            return "0x%08x" % word
+        if conv == "s":
+            text = elf.string(word)
+            return (spec + "s") % (text if text is not None else "<0x%08x>" % word)
+        value, = struct.unpack("<f", struct.pack("<I", word))
+        return (spec + conv.replace("a", "e").replace("A", "E")) % value
+
+    return CONVERSION.sub(convert, fmt)
+
+
+class Decoder:
+    """Split a byte stream into log records and pass-through text."""
+
+    def __init__(self, elf):
+        self.elf = elf
+        self.table = formats(elf)
+        self.counts = {i: arguments(f) for i, f in self.table.items()}
+        self.buffer = b""
+        self.text = b""
+
+    def record_size(self, pos):
+        """Size of a record starting at pos, 0 if none, None if incomplete."""
+        if len(self.buffer) - pos < 4:
+            return None
+        if self.buffer[pos + 3] != SYNC:
+            return 0
+        nargs = self.buffer[pos + 2]
+        fid = self.buffer[pos] | (self.buffer[pos + 1] << 8)
+        if fid == ID_DROPPED:
+            valid = nargs == 1
+        else:
+            valid = nargs <= MAX_ARGS and self.counts.get(fid) == nargs
+        if not valid:
+            return 0
+        size = 8 + 4 * nargs
+        return size if len(self.buffer) - pos >= size else None
+
+    def lines(self, words):
+        header, tick = words[0], words[1]
+        fid = header & 0xFFFF
+        if fid == ID_DROPPED:
+            message = "<%d record(s) dropped, ring full>" % words[2]
+        else:
+            message = expand(self.table[fid], words[2:], self.elf)
+        return "[%10.3f] %s" % (tick / 1000.0, message)
+
+    def flush_text(self):
+        out = []
+        if self.text:
+            out.append(self.text.decode("utf-8", "replace").rstrip("\r\n"))
+            self.text = b""
+        return out
+
+    def feed(self, data, final=False):
+        """Return the output lines completed by data."""
+        out = []
+        self.buffer += data
+        pos = 0
+        while pos < len(self.buffer):
+            size = self.record_size(pos)
+            if size is None and not final:
+                break
+            if size:
+                out += self.flush_text()
+                out.append(self.lines(struct.unpack_from("<%dI" % (size // 4), self.buffer, pos)))
+                pos += size
+                continue
+            self.text += self.buffer[pos:pos + 1]
+            if self.buffer[pos] == 0x0A:
+                out += self.flush_text()
+            pos += 1
+        self.buffer = self.buffer[pos:]
+        if final:
+            out += self.flush_text()
+        return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture", help="bytes received from the UART, - for stdin")
+    parser.add_argument("--elf", required=True, help="firmware ELF that produced the log")
+    args = parser.parse_args()
+
+    try:
+        decoder = Decoder(Elf(args.elf))
+    except (OSError, ValueError) as e:
+        print(e, file=sys.stderr)
+        sys.exit(1)
+
+    stream = sys.stdin.buffer if args.capture == "-" else open(args.capture, "rb")
+    with stream:
+        while True:
+            data = stream.read1(4096) if hasattr(stream, "read1") else stream.read(4096)
+            for line in decoder.feed(data, final=not data):
+                print(line, flush=True)
+            if not data:
+                break
+
+
+if __name__ == "__main__":
+    main()
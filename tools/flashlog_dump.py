@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+"""Decode a raw dump of the LOG flash region written by flashlog.c.
+
+    make logdump                    # reads the region and runs this script
+    flashlog_dump.py log.bin > log.csv
+    flashlog_dump.py log.bin --session 3 --npz log.npz
+
+Blocks are validated with their CRC-32, ordered by sequence number and
+expanded to one row per frame: session, time in seconds, then one column
+per channel. Torn or erased blocks are skipped and counted on stderr.
+The layout mirrors FLOG_BlockTypeDef in src/template/Inc/flashlog.h.
+"""
+
+import argparse
+import csv
+import struct
+import sys
+import zlib
+
+PAGE_SIZE = 2048
+MAGIC = 0x4C46
+HEADER = struct.Struct("<HHIIIHHHBB")
+CRC_OFFSET = 8
+ENC_RAW = 0
+ENC_DELTA8 = 1
+ENC_PACKED = 2
+MAX_PAYLOAD = 64 * 9 * 2
+
+
+def scan(image):
+    """Yield (header dict, payload) of every block with a valid CRC."""
+    bad = 0
+    for page in range(0, len(image) - PAGE_SIZE + 1, PAGE_SIZE):
+        addr = page
+        end = page + PAGE_SIZE
+        while addr + HEADER.size <= end:
+            (magic, length, crc, seq, tick, session, rate, frames,
+             channels, encoding) = HEADER.unpack_from(image, addr)
+            size = HEADER.size + length
+            if magic != MAGIC or length > MAX_PAYLOAD or addr + size > end:
+                break
+            if zlib.crc32(image[addr + CRC_OFFSET:addr + size]) == crc:
+                yield dict(seq=seq, tick=tick, session=session, rate=rate,
+                           frames=frames, channels=channels,
+                           encoding=encoding), image[addr + HEADER.size:addr + size]
+            else:
+                bad += 1
+            addr += size
+    if bad:
+        print("%d torn block(s) skipped" % bad, file=sys.stderr)
+
+
+def decode(block, payload):
+    """Return the frames of a block as lists of int."""
+    n = block["channels"]
+    count = block["frames"]
+    if block["encoding"] == ENC_RAW:
+        flat = list(struct.unpack_from("<%dh" % (count * n), payload))
+        return [flat[i * n:(i + 1) * n] for i in range(count)]
+    if block["encoding"] == ENC_DELTA8:
+        frame = list(struct.unpack_from("<%dh" % n, payload))
+        deltas = struct.unpack_from("<%db" % ((count - 1) * n), payload, 2 * n)
+        frames = [frame]
+        for i in range(1, count):
+            frame = [frame[c] + deltas[(i - 1) * n + c] for c in range(n)]
+            frames.append(frame)
+        return frames
+    if block["encoding"] == ENC_PACKED:
+        import imucodec
+        return imucodec.decode(payload, count, n)[0].tolist()
+    raise ValueError("unknown encoding %d in block %d" % (block["encoding"], block["seq"]))
+
+
+def rows(image, session=None):
+    """Yield (session, t, samples) ordered by block sequence number."""
+    blocks = sorted(scan(image), key=lambda b: b[0]["seq"])
+    for block, payload in blocks:
+        if session is not None and block["session"] != session:
+            continue
+        period = 1.0 / block["rate"] if block["rate"] else 0.0
+        t0 = block["tick"] / 1000.0
+        for i, frame in enumerate(decode(block, payload)):
+            yield block["session"], t0 + i * period, frame
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("dump", help="raw image of the LOG region")
+    parser.add_argument("--session", type=int, help="only this session")
+    parser.add_argument("--npz", help="also write the columns to a numpy .npz")
+    args = parser.parse_args()
+
+    with open(args.dump, "rb") as f:
+        image = f.read()
+
+    data = list(rows(image, args.session))
+    channels = max((len(r[2]) for r in data), default=0)
+
+    out = csv.writer(sys.stdout)
+    out.writerow(["session", "t"] + ["ch%d" % c for c in range(channels)])
+    for session, t, frame in data:
+        out.writerow([session, "%.6f" % t] + frame)
+
+    if args.npz:
+        import numpy as np
+        columns = {"session": np.array([r[0] for r in data], dtype=np.uint16),
+                   "t": np.array([r[1] for r in data])}
+        for c in range(channels):
+            columns["ch%d" % c] = np.array([r[2][c] if c < len(r[2]) else 0 for r in data],
+                                           dtype=np.int16)
+        np.savez(args.npz, **columns)
+
+
+if __name__ == "__main__":
+    main()
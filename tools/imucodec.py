@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+"""Host side of the block codec in src/template/Src/imucodec.c.
+
+    import imucodec
+    frames = imucodec.decode(payload, n_frames, n_channels)   # int16 (n, c)
+    payload = imucodec.encode(frames)
+
+Per channel: first sample (int16 LE), bit width W, then n - 1 zigzag
+deltas of W bits, LSB first, padded to a byte. Decoding is vectorised:
+bits are unpacked in one go and the deltas summed with a cumulative sum
+modulo 2^16.
+"""
+
+import numpy as np
+
+CHANNEL_HEADER = 3
+
+
+def decode(payload, frames, channels):
+    """Decode one block, return an int16 array of shape (frames, channels)
+    and the number of bytes consumed as a tuple."""
+    buf = np.frombuffer(bytes(payload), dtype=np.uint8)
+    out = np.empty((frames, channels), dtype=np.int16)
+    pos = 0
+    for c in range(channels):
+        if pos + CHANNEL_HEADER > len(buf):
+            raise ValueError("truncated block")
+        first = int(buf[pos]) | (int(buf[pos + 1]) << 8)
+        width = int(buf[pos + 2])
+        pos += CHANNEL_HEADER
+        if width > 16:
+            raise ValueError("bad width %d" % width)
+        nbytes = ((frames - 1) * width + 7) // 8
+        if pos + nbytes > len(buf):
+            raise ValueError("truncated block")
+
+        if width:
+            bits = np.unpackbits(buf[pos:pos + nbytes], bitorder="little")
+            bits = bits[:(frames - 1) * width].reshape(frames - 1, width)
+            zz = bits.astype(np.uint32) @ (np.uint32(1) << np.arange(width, dtype=np.uint32))
+            deltas = ((zz >> 1) ^ (0 - (zz & 1))).astype(np.uint16)
+        else:
+            deltas = np.zeros(frames - 1, dtype=np.uint16)
+        pos += nbytes
+
+        values = np.concatenate(([first], deltas)).astype(np.uint32)
+        out[:, c] = (np.cumsum(values) & 0xFFFF).astype(np.uint16).view(np.int16)
+    return out, pos
+
+
+def encode(frames):
+    """Encode an int16 array of shape (frames, channels), for tests and
+    host generated data. Returns bytes."""
+    frames = np.asarray(frames, dtype=np.int16)
+    out = bytearray()
+    for c in range(frames.shape[1]):
+        col = frames[:, c].view(np.uint16).astype(np.int32)
+        deltas = ((col[1:] - col[:-1]) & 0xFFFF).astype(np.uint16).view(np.int16).astype(np.int32)
+        zz = ((deltas << 1) ^ (deltas >> 15)) & 0xFFFF
+        width = int(zz.max()).bit_length() if len(zz) else 0
+        out += int(col[0]).to_bytes(2, "little") + bytes([width])
+        if width:
+            bits = (zz[:, None] >> np.arange(width)) & 1
+            out += np.packbits(bits.astype(np.uint8).ravel(), bitorder="little").tobytes()
+    return bytes(out)